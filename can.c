@@ -13,6 +13,279 @@
  */
 
 #include "can.h"
+#include "can_timing.h"
+#include "can_busload.h"
+
+/* Structure that holds the bit timing register values of a supported baud rate */
+typedef struct
+{
+    uint32_t baudrate; /* CAN baud rate (refer to 'MCP2515 baud rates')                          */
+    uint8_t  cnf[ 3 ]; /* CNF3, CNF2 and CNF1 register values (without WAKFIL, SOF and SAM bits) */
+} CAN_Control_Bit_Timing;
+
+/* Build-time check of every supported baud rate: an unachievable bit timing declares an array of negative size */
+#define CAN_BAUD_RATE_CHECK( b )        typedef char can_baud_rate_check_##b[ CAN_TIMING_VALID( OSC1_FREQ, b ) ? 1 : -1 ];
+CAN_BAUD_RATE_LIST( CAN_BAUD_RATE_CHECK )
+
+/* Bit timing table of the supported baud rates, computed from OSC1_FREQ at build time (refer to CAN_BAUD_RATE_LIST in can.h) */
+#define CAN_BAUD_RATE_ENTRY( b )        { ( b ), { CAN_TIMING_CNF3( OSC1_FREQ, b ), CAN_TIMING_CNF2( OSC1_FREQ, b ), CAN_TIMING_CNF1( OSC1_FREQ, b ) } },
+static const CAN_Control_Bit_Timing can_bit_timing[] =
+{
+    CAN_BAUD_RATE_LIST( CAN_BAUD_RATE_ENTRY )
+};
+
+/* TXB0CTRL, TXB1CTRL and TXB2CTRL register addresses, indexed by TX buffer */
+static const uint8_t can_txbctrl_reg[ 3 ] = { TXB0CTRL_REG, TXB1CTRL_REG, TXB2CTRL_REG };
+
+/* RXF0SIDH to RXF5SIDH register addresses, indexed by filter (RXF3SIDH follows a gap after RXF2EID0) */
+static const uint8_t can_rxfsidh_reg[ 6 ] = { RXF0SIDH_REG, RXF1SIDH_REG, RXF2SIDH_REG, RXF3SIDH_REG, RXF4SIDH_REG, RXF5SIDH_REG };
+
+/* Build-time check of the CAN frame size (4 words) */
+typedef char can_frame_size_check[ ( sizeof( CAN_Control_Frame ) == 16U ) ? 1 : -1 ];
+
+/* Shadow register cache: register bits held by each entry, 0 for registers that are not cached (status, error
+   counters and CANCTRL mirrors change on their own). Unimplemented and read-only bits are left out */
+static const uint8_t can_shadow_bits[ CAN_SHADOW_SIZE ] =
+{
+    0xFFU, 0xEBU, 0xFFU, 0xFFU, 0xFFU, 0xEBU, 0xFFU, 0xFFU, /* RXF0, RXF1                                */
+    0xFFU, 0xEBU, 0xFFU, 0xFFU, 0x3FU, 0x07U, 0x00U, 0xFFU, /* RXF2, BFPCTRL, TXRTSCTRL, CANSTAT, CANCTRL */
+    0xFFU, 0xEBU, 0xFFU, 0xFFU, 0xFFU, 0xEBU, 0xFFU, 0xFFU, /* RXF3, RXF4                                */
+    0xFFU, 0xEBU, 0xFFU, 0xFFU, 0x00U, 0x00U, 0x00U, 0x00U, /* RXF5, TEC, REC, CANSTAT, CANCTRL           */
+    0xFFU, 0xE3U, 0xFFU, 0xFFU, 0xFFU, 0xE3U, 0xFFU, 0xFFU, /* RXM0, RXM1                                */
+    0xC7U, 0xFFU, 0xFFU, 0xFFU, 0x00U, 0x00U, 0x00U, 0x00U, /* CNF3, CNF2, CNF1, CANINTE, CANINTF, EFLG,
+                                                               CANSTAT, CANCTRL                          */
+    0x64U, 0x60U                                            /* RXB0CTRL, RXB1CTRL                        */
+};
+
+/* Shadow entries only writable in configuration mode: filters, TXRTSCTRL, masks and CNF1 to CNF3 */
+#define CAN_SHADOW_CONFIG_ONLY( i )     ( ( (i) < 0x0CU ) || ( (i) == 0x0DU ) || ( ( (i) >= 0x10U ) && ( (i) <= 0x2AU ) ) )
+
+/* Shadow entries of the acceptance filters (RXF0 to RXF5), whose reset value is undefined (R/W-x) */
+#define CAN_SHADOW_FILTER( i )          ( ( (i) < 0x0CU ) || ( ( (i) >= 0x10U ) && ( (i) < 0x1CU ) ) )
+
+/* Shadow entries that do not support BIT MODIFY (filters and masks), a BIT MODIFY is a byte write on them */
+#define CAN_SHADOW_BYTE_ONLY( i )       ( ( (i) < 0x0CU ) || ( ( (i) >= 0x10U ) && ( (i) < 0x28U ) ) )
+
+/* Shadow entries with read-only bits that change on their own (TXRTSCTRL pin states, RXBnCTRL frame status),
+   always read from the MCP2515 */
+#define CAN_SHADOW_READ_THROUGH( i )    ( ( (i) == 0x0DU ) || ( (i) >= CAN_SHADOW_RXB0CTRL ) )
+
+/* Register image last applied to an MCP2515 (refer to CAN_Control_Warm_Start()): key of its CS pin, CRC-32 of the
+   image and a check word, since the RAM contents are random after a power-up */
+typedef struct
+{
+    uint32_t key;
+    uint32_t crc;
+    uint32_t check;
+} CAN_Control_Applied_Image;
+
+/* Applied image record key of an MCP2515: CS port address XOR CS pin mask << 16 (GPIO port addresses differ below bit 16) */
+#define CAN_APPLIED_KEY( hcan )         ( ( uint32_t )( uintptr_t )( hcan )->csport ^ ( ( uint32_t )( hcan )->cspin << 16 ) )
+
+/* Applied images, kept across STM32F070RB resets (.noinit section, not cleared by the startup code) */
+static CAN_Control_Applied_Image can_applied_image[ CAN_WARM_START_NODES ] __attribute__(( section( ".noinit" ) ));
+
+/**
+ * @brief Start an SPI transaction with the MCP2515: take its SPI bus, so that an interrupt using the same bus
+ *        defers instead of interleaving its own transactions (refer to SPI_Bus_Lock() in spi.c), and enable its CS.
+ * 
+ * @param hcan pointer to an MCP2515 configuration structure
+ */
+static void CAN_Control_Select( const CAN_Control_HandleTypeDef *hcan )
+{
+    SPI_Bus_Lock( hcan->spiport );
+    SPI_CS_Enable( hcan->csport, hcan->cspin );
+}
+
+/**
+ * @brief End an SPI transaction with the MCP2515: disable its CS and release its SPI bus.
+ * 
+ * @param hcan pointer to an MCP2515 configuration structure
+ */
+static void CAN_Control_Deselect( const CAN_Control_HandleTypeDef *hcan )
+{
+    SPI_CS_Disable( hcan->csport, hcan->cspin );
+    SPI_Bus_Unlock( hcan->spiport );
+}
+
+/**
+ * @brief Find the applied image record of an MCP2515 (identified by its CS pin).
+ * 
+ * @param key                         CS pin key of the MCP2515 (refer to CAN_APPLIED_KEY())
+ * @return CAN_Control_Applied_Image* record of the MCP2515, NULL if it has none
+ */
+static CAN_Control_Applied_Image *CAN_Control_Applied_Find( uint32_t key )
+{
+    CAN_Control_Applied_Image *record;
+    uint8_t                    i;
+
+    for ( i = 0U; i < CAN_WARM_START_NODES; i++ )
+    {
+        record = &can_applied_image[ i ];
+
+        if ( ( record->key == key ) && ( record->check == ~( record->key ^ record->crc ) ) )
+        {
+            return record;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Record the CRC-32 of the register image just applied to the MCP2515, or forget it (crc = 0 with valid = 0)
+ *        when its configuration registers are about to change. Nothing is recorded when the CAN_WARM_START_NODES
+ *        records are taken by other controllers.
+ * 
+ * @param hcan  pointer to an MCP2515 configuration structure (CS pin set)
+ * @param crc   CRC-32 of the applied image
+ * @param valid 1 to record the image, 0 to forget the recorded one
+ */
+static void CAN_Control_Applied_Set( const CAN_Control_HandleTypeDef *hcan, uint32_t crc, uint8_t valid )
+{
+    uint32_t                   key    = CAN_APPLIED_KEY( hcan );
+    CAN_Control_Applied_Image *record = CAN_Control_Applied_Find( key );
+    uint8_t                    i;
+
+    if ( record == NULL )
+    {
+        if ( valid == 0U )
+        {
+            return;
+        }
+
+        /* First free record */
+        for ( i = 0U; i < CAN_WARM_START_NODES; i++ )
+        {
+            if ( can_applied_image[ i ].check != ~( can_applied_image[ i ].key ^ can_applied_image[ i ].crc ) )
+            {
+                record = &can_applied_image[ i ];
+                break;
+            }
+        }
+
+        if ( record == NULL )
+        {
+            return;
+        }
+    }
+
+    record->key   = key;
+    record->crc   = crc;
+    record->check = ( valid == 1U ) ? ~( key ^ crc ) : ( key ^ crc );
+}
+
+/**
+ * @brief Get the shadow register cache entry of an MCP2515 register.
+ * 
+ * @param reg_addr register address. Refer to 'MCP2515 register addresses definitions' in can.h
+ * @return uint8_t shadow entry, CAN_SHADOW_NONE if the register is not cached
+ */
+static uint8_t CAN_Control_Shadow_Index( uint8_t reg_addr )
+{
+    uint8_t index = CAN_SHADOW_NONE;
+
+    if ( reg_addr < CAN_SHADOW_RXB0CTRL )
+    {
+        index = reg_addr;
+    }
+    else if ( reg_addr == RXB0CTRL_REG )
+    {
+        index = CAN_SHADOW_RXB0CTRL;
+    }
+    else if ( reg_addr == RXB1CTRL_REG )
+    {
+        index = CAN_SHADOW_RXB1CTRL;
+    }
+
+    if ( ( index != CAN_SHADOW_NONE ) && ( can_shadow_bits[ index ] == 0U ) )
+    {
+        index = CAN_SHADOW_NONE;
+    }
+
+    return index;
+}
+
+/**
+ * @brief Check whether a shadow register cache entry holds the register value.
+ * 
+ * @param hcan     pointer to an MCP2515 configuration structure
+ * @param index    shadow entry
+ * @return uint8_t 1 if valid, 0 if not
+ */
+static uint8_t CAN_Control_Shadow_Valid( const CAN_Control_HandleTypeDef *hcan, uint8_t index )
+{
+    return ( uint8_t )( ( hcan->shadowvalid[ index >> 5 ] >> ( index & 0x1FU ) ) & 0x01U );
+}
+
+/**
+ * @brief Update a shadow register cache entry after its register was written. Registers only writable in configuration
+ *        mode discard writes in any other mode, so their entry is only updated while CANSTAT is known to report
+ *        configuration mode (hcan->configmode, refer to CAN_Control_Wait_Op_Mode()), and dropped otherwise: a write
+ *        issued after a mode request that has not taken effect yet (or timed out) may have been discarded.
+ *        A CANCTRL write that requests another mode ends the confirmed configuration mode, a write to any other cached
+ *        register but CANINTE (all of them are part of a register image) drops the record of the last applied image.
+ *        Like the operation mode, the interrupts enabled are up to the application once the image is applied.
+ * 
+ * @param hcan  pointer to an MCP2515 configuration structure
+ * @param index shadow entry
+ * @param value value written to the register
+ */
+static void CAN_Control_Shadow_Store( CAN_Control_HandleTypeDef *hcan, uint8_t index, uint8_t value )
+{
+    uint32_t bit = 1UL << ( index & 0x1FU );
+
+    /* The configuration may no longer be the one of the last applied register image */
+    if ( ( index != CANCTRL_REG ) && ( index != CANINTE_REG ) )
+    {
+        CAN_Control_Applied_Set( hcan, 0U, 0U );
+    }
+
+    if ( CAN_SHADOW_CONFIG_ONLY( index ) && ( hcan->configmode == 0U ) )
+    {
+        hcan->shadowvalid[ index >> 5 ] &= ~bit;
+        return;
+    }
+
+    if ( ( index == CANCTRL_REG ) && ( ( value & REQOP_MASK ) != REQOP_CONFIGURATION_MODE ) )
+    {
+        hcan->configmode = 0U;
+    }
+
+    hcan->shadow[ index ] = value & can_shadow_bits[ index ];
+    hcan->shadowvalid[ index >> 5 ] |= bit;
+}
+
+/**
+ * @brief Load the register reset values into the shadow register cache: CANCTRL = 0x87 (configuration mode, CLKOUT
+ *        enabled, CLKOUT = OSC1 / 8), all other cached registers = 0x00. The filter registers have no defined reset
+ *        value, so their entries stay invalid until they are written (every other entry becomes valid).
+ *        The MCP2515 runs in configuration mode once its reset is over.
+ * 
+ * @param hcan pointer to an MCP2515 configuration structure (CAN module just reset)
+ */
+static void CAN_Control_Shadow_Defaults( CAN_Control_HandleTypeDef *hcan )
+{
+    uint8_t i;
+
+    for ( i = 0U; i < CAN_SHADOW_SIZE; i++ )
+    {
+        hcan->shadow[ i ] = 0U;
+    }
+
+    hcan->shadow[ CANCTRL_REG ] = REQOP_CONFIGURATION_MODE | CLKOUT_SYSTEMCLK_DIV_8;
+    hcan->shadowvalid[ 0 ] = 0xFFFFFFFFUL;
+    hcan->shadowvalid[ 1 ] = ( 1UL << ( CAN_SHADOW_SIZE - 32U ) ) - 1UL;
+    hcan->configmode       = 1U;
+
+    for ( i = 0U; i < CAN_SHADOW_SIZE; i++ )
+    {
+        if ( CAN_SHADOW_FILTER( i ) )
+        {
+            hcan->shadowvalid[ i >> 5 ] &= ~( 1UL << ( i & 0x1FU ) );
+        }
+    }
+}
 
 /**
  * @brief Initialize the MCP2515 CAN Controller Driver according to the parameters provided in the CAN_Control_HandleTypeDef:
@@ -21,10 +294,11 @@
  *        - turn masks/filters ON or OFF
  *        - either enable or disable RX buffer 0 rollover
  *        - either enable or disable one-shot mode
+ *        - either enable or disable the CLKOUT pin (and its prescaler)
  *        - and force the device to work at the defined operation mode.
  * 
- *        Use the specified SPI1 or SPI2 on the Nucleo Board for both reading and writing to the MCP2515
- *        (refer to spi.c for the Nucleo Board's SPI1 and SPI2 pinout).
+ *        Use the specified SPI bus and CS pin for both reading and writing to the MCP2515, any number of controllers
+ *        can share a bus (refer to CAN_Control_Init_Pins() for the default SPI1 and SPI2 wiring).
  * 
  * @param hcan pointer to an MCP2515 configuration structure (CAN module to be initialized).
  *             Refer to the CAN_Control_HandleTypeDef structure definition in can.h for its possible values
@@ -33,12 +307,12 @@ void CAN_Control_Init( CAN_Control_HandleTypeDef *hcan )
 {
     uint8_t spi_write = 0U; /* RXB0CTRL and RXB1CTRL register */
 
+    /* Set up the SPI bus, CS pin and INT pin of the MCP2515 */
+    CAN_Control_Init_Pins( hcan );
+
     /* Make sure the SPI instance selected to control the MCP2515 is valid */
-    if ( ( hcan->spi == CAN_SPI1 ) || ( hcan->spi == CAN_SPI2 ) )
+    if ( ( hcan->spiport == SPI1 ) || ( hcan->spiport == SPI2 ) )
     {
-        /* Initialize selected SPI peripheral (6MHz) */
-        ( hcan->spi == CAN_SPI1 ) ? SPI1_Init() : SPI2_Init();
-        
         /* Reset MCP2515 */
         CAN_Control_Reset( hcan );
 
@@ -77,11 +351,414 @@ void CAN_Control_Init( CAN_Control_HandleTypeDef *hcan )
         }
         /* ... otherwise RX buffer 1 will only receive CAN frames that meet the masks and filter criteria */
 
-        /* Set CAN controller operation and one-shot modes selected by user */
+        /* Set CAN controller operation mode, one-shot mode and CLKOUT pin configuration selected by user */
         CAN_Control_Set_Op_Mode( hcan, hcan->opmode );
     }
 }
 
+/**
+ * @brief Initialize the SPI bus (6MHz, only once per bus), CS pin and INT pin of the MCP2515 specified by
+ *        CAN_Control_HandleTypeDef. When no bus is given, the default Nucleo Board wiring selected by 'spi' is used:
+ *        - CAN_SPI1: SPI1 with CS on PA4
+ *        - CAN_SPI2: SPI2 with CS on PB12
+ * 
+ * @param hcan pointer to an MCP2515 configuration structure (CAN module to be initialized)
+ */
+void CAN_Control_Init_Pins( CAN_Control_HandleTypeDef *hcan )
+{
+    uint8_t number = 0U;
+
+    /* Default wiring */
+    if ( hcan->spiport == NULL )
+    {
+        if ( hcan->spi == CAN_SPI1 )
+        {
+            hcan->spiport = SPI1;
+            hcan->csport  = GPIOA;
+            hcan->cspin   = GPIO_ODR_4;
+        }
+        else if ( hcan->spi == CAN_SPI2 )
+        {
+            hcan->spiport = SPI2;
+            hcan->csport  = GPIOB;
+            hcan->cspin   = GPIO_ODR_12;
+        }
+        else
+        {
+            return;
+        }
+    }
+
+    /* Initialize the SPI bus if no other CAN controller did it before and the CS pin in IDLE state (HIGH) */
+    SPI_Bus_Init( hcan->spiport );
+    SPI_CS_Init( hcan->csport, hcan->cspin );
+
+    /* INT pin (active LOW) as an input with pull-up */
+    if ( hcan->intport != NULL )
+    {
+        while ( ( ( uint32_t )hcan->intpin >> number ) > 1U )
+        {
+            number++;
+        }
+
+        GPIO_CLK_ENBL( hcan->intport );
+        hcan->intport->MODER &= ~( 0x03UL << ( number << 1 ) );
+        hcan->intport->PUPDR &= ~( 0x03UL << ( number << 1 ) );
+        hcan->intport->PUPDR |=  ( 0x01UL << ( number << 1 ) );
+    }
+}
+
+/**
+ * @brief Build the register image of a complete MCP2515 configuration (refer to CAN_Control_Init_Image()), from the
+ *        parameters of the CAN_Control_HandleTypeDef (baud rate, sample point, wake-up filter, RX buffer operation mode,
+ *        RXB0 rollover, one-shot mode, CLKOUT pin and operation mode), the masks and filters and the interrupts enabled.
+ *        The image only depends on the configuration, so it can be built once and kept (e.g. const or in flash).
+ * 
+ * @param hcan       pointer to an MCP2515 configuration structure holding the configuration parameters
+ * @param hmask      pointer to a receiving mask configuration structure, NULL to keep the masks cleared (accept any frame)
+ * @param hfilter    pointer to a receiving filter configuration structure, NULL to keep the filters cleared
+ * @param interrupts MCP2515 interrupts to be enabled (CANINTE register). Refer to 'MCP2515 bit definitions for CANINTE' in can.h
+ * @param image      pointer to the register image to be built
+ * @return uint8_t   1 if built, 0 if the baud rate is not supported (refer to CAN_BAUD_RATE_LIST in can.h)
+ */
+uint8_t CAN_Control_Build_Image( const CAN_Control_HandleTypeDef *hcan, const CAN_Control_RX_Mask *hmask, const CAN_Control_RX_Filter *hfilter,
+                                 uint8_t interrupts, CAN_Control_Image *image )
+{
+    uint8_t i;
+
+    for ( i = 0U; i < CAN_IMAGE_SIZE; i++ )
+    {
+        image->regs[ i ] = 0U;
+    }
+
+    /* Filters: RXFnSIDH, RXFnSIDL (EXIDE bit), RXFnEID8 and RXFnEID0 */
+    for ( i = 0U; ( hfilter != NULL ) && ( i < 6U ); i++ )
+    {
+        if ( ( hfilter->rxfilternmbr & ( RXF0 << i ) ) != 0U )
+        {
+            CAN_Control_ID_Pack_Raw( hfilter->rxfiltervalue[ i ], &image->regs[ can_rxfsidh_reg[ i ] ] );
+            image->regs[ can_rxfsidh_reg[ i ] + 1U ] |= ( ( hfilter->extendedidenable >> i ) & 0x01U ) << 3;
+        }
+    }
+
+    /* Masks: RXMnSIDH, RXMnSIDL, RXMnEID8 and RXMnEID0 */
+    for ( i = 0U; ( hmask != NULL ) && ( i < 2U ); i++ )
+    {
+        if ( ( hmask->rxmasknmbr & ( RXM0 << i ) ) != 0U )
+        {
+            CAN_Control_ID_Pack_Raw( hmask->rxmaskvalue[ i ], &image->regs[ RXM0SIDH_REG + ( i << 2 ) ] );
+        }
+    }
+
+    /* Bit timing: CNF3, CNF2 and CNF1 */
+    for ( i = 0U; i < ( sizeof( can_bit_timing ) / sizeof( can_bit_timing[ 0 ] ) ); i++ )
+    {
+        if ( can_bit_timing[ i ].baudrate == hcan->baudrate )
+        {
+            break;
+        }
+    }
+
+    if ( i == ( sizeof( can_bit_timing ) / sizeof( can_bit_timing[ 0 ] ) ) )
+    {
+        return 0U;
+    }
+
+    image->regs[ CNF3_REG ] = hcan->wakeupfilter | can_bit_timing[ i ].cnf[ 0 ];
+    image->regs[ CNF2_REG ] = hcan->samplepoint  | can_bit_timing[ i ].cnf[ 1 ];
+    image->regs[ CNF1_REG ] = can_bit_timing[ i ].cnf[ 2 ];
+
+    /* Interrupts: CANINTE */
+    image->regs[ CANINTE_REG ] = interrupts;
+
+    /* CANCTRL and its mirror stay in configuration mode during the burst */
+    image->regs[ CANCTRL_REG ]         = REQOP_CONFIGURATION_MODE | hcan->oneshot | hcan->clkout;
+    image->regs[ CANCTRL_REG + 0x10U ] = image->regs[ CANCTRL_REG ];
+
+    /* RX buffers: RXB0CTRL (RXM and BUKT bits) and RXB1CTRL (RXM bits) */
+    image->rxbctrl[ 0 ] = ( ( hcan->rxbufferopmode & RXB0_TURN_MASKS_FILTERS_OFF ) == RXB0_TURN_MASKS_FILTERS_OFF ) ? RXM_RECEIVE_ANY_MESSAGE : 0U;
+    image->rxbctrl[ 1 ] = ( ( hcan->rxbufferopmode & RXB1_TURN_MASKS_FILTERS_OFF ) == RXB1_TURN_MASKS_FILTERS_OFF ) ? RXM_RECEIVE_ANY_MESSAGE : 0U;
+
+    if ( ( hcan->rxbuffer0rollover & RXB0_ROLLOVER_ENABLED ) == RXB0_ROLLOVER_ENABLED )
+    {
+        image->rxbctrl[ 0 ] |= BUKT_RXB0_ROLLOVER_ENABLED;
+    }
+
+    /* Operation mode to enter once the image is written (operation mode definitions are REQOP shifted right by 5) */
+    image->canctrl = ( uint8_t )( hcan->opmode << 5 ) | hcan->oneshot | hcan->clkout;
+
+    return 1U;
+}
+
+/**
+ * @brief Update the configuration parameters of the CAN_Control_HandleTypeDef from a register image.
+ * 
+ * @param hcan  pointer to an MCP2515 configuration structure
+ * @param image pointer to the register image
+ */
+static void CAN_Control_Image_Params( CAN_Control_HandleTypeDef *hcan, const CAN_Control_Image *image )
+{
+    uint8_t i;
+
+    hcan->opmode            = image->canctrl >> 5;
+    hcan->oneshot           = image->canctrl & OSM_ENABLED;
+    hcan->clkout            = image->canctrl & ( CLKEN_CLKOUT_PIN_ENABLED | CLKPRE_MASK );
+    hcan->wakeupfilter      = image->regs[ CNF3_REG ] & WAKFIL_ENABLED;
+    hcan->samplepoint       = image->regs[ CNF2_REG ] & SAM_BUS_SAMPLED_THREE;
+    hcan->rxbufferopmode    = ( ( image->rxbctrl[ 0 ] & RXM_RECEIVE_ANY_MESSAGE ) == RXM_RECEIVE_ANY_MESSAGE ) ? RXB0_TURN_MASKS_FILTERS_OFF : 0U;
+    hcan->rxbufferopmode   |= ( ( image->rxbctrl[ 1 ] & RXM_RECEIVE_ANY_MESSAGE ) == RXM_RECEIVE_ANY_MESSAGE ) ? RXB1_TURN_MASKS_FILTERS_OFF : 0U;
+    hcan->rxbuffer0rollover = ( ( image->rxbctrl[ 0 ] & BUKT_RXB0_ROLLOVER_ENABLED ) == BUKT_RXB0_ROLLOVER_ENABLED ) ? RXB0_ROLLOVER_ENABLED : RXB0_ROLLOVER_DISABLED;
+
+    for ( i = 0U; i < ( sizeof( can_bit_timing ) / sizeof( can_bit_timing[ 0 ] ) ); i++ )
+    {
+        if ( ( can_bit_timing[ i ].cnf[ 2 ] == image->regs[ CNF1_REG ] ) &&
+             ( can_bit_timing[ i ].cnf[ 1 ] == ( image->regs[ CNF2_REG ] & ~SAM_BUS_SAMPLED_THREE ) ) )
+        {
+            hcan->baudrate = can_bit_timing[ i ].baudrate;
+        }
+    }
+}
+
+/**
+ * @brief Compute the Fletcher-16 checksum of the registers of a register image that can be read back while the MCP2515
+ *        is running (every cached bit except masks and filters, which are read as zeros out of configuration mode).
+ *        CANINTE is left out, the application enables its interrupts after the image is applied.
+ * 
+ * @param image     pointer to the register image (CANCTRL taken from 'canctrl', the operation mode to run in)
+ * @return uint16_t checksum
+ */
+static uint16_t CAN_Control_Image_Checksum( const CAN_Control_Image *image )
+{
+    uint16_t sum1 = 0U;
+    uint16_t sum2 = 0U;
+    uint8_t  value;
+    uint8_t  i;
+
+    for ( i = 0U; i < ( CAN_IMAGE_SIZE + 3U ); i++ )
+    {
+        if ( i < CAN_IMAGE_SIZE )
+        {
+            if ( CAN_SHADOW_BYTE_ONLY( i ) || ( i == CANCTRL_REG ) || ( i == CANINTE_REG ) )
+            {
+                continue;
+            }
+
+            value = image->regs[ i ] & can_shadow_bits[ i ];
+        }
+        else if ( i < ( CAN_IMAGE_SIZE + 2U ) )
+        {
+            value = image->rxbctrl[ i - CAN_IMAGE_SIZE ] & can_shadow_bits[ CAN_SHADOW_RXB0CTRL + ( i - CAN_IMAGE_SIZE ) ];
+        }
+        else
+        {
+            value = image->canctrl;
+        }
+
+        sum1 = ( sum1 + value ) % 255U;
+        sum2 = ( sum2 + sum1 ) % 255U;
+    }
+
+    return ( uint16_t )( ( sum2 << 8 ) | sum1 );
+}
+
+/**
+ * @brief Compute the CRC-32 (IEEE 802.3, bitwise) of a whole register image, masks and filters included, to tell
+ *        whether it is the last image applied to an MCP2515 (refer to CAN_Control_Warm_Start()).
+ * 
+ * @param image     pointer to the register image
+ * @return uint32_t CRC-32
+ */
+static uint32_t CAN_Control_Image_CRC( const CAN_Control_Image *image )
+{
+    const uint8_t *data = ( const uint8_t * )image;
+    uint32_t       crc  = 0xFFFFFFFFUL;
+    uint8_t        i, bit;
+
+    for ( i = 0U; i < sizeof( CAN_Control_Image ); i++ )
+    {
+        crc ^= data[ i ];
+
+        for ( bit = 0U; bit < 8U; bit++ )
+        {
+            crc = ( crc >> 1 ) ^ ( 0xEDB88320UL & ( 0UL - ( crc & 0x01UL ) ) );
+        }
+    }
+
+    return ~crc;
+}
+
+/**
+ * @brief Initialize the MCP2515 from a complete register image (refer to CAN_Control_Build_Image()) in the fewest
+ *        SPI transactions, instead of the field by field configuration of CAN_Control_Init():
+ *        - reset the MCP2515 and wait for its OST
+ *        - write registers 0x00 to 0x2B (filters, BFPCTRL, TXRTSCTRL, masks, CNF3 to CNF1 and CANINTE) in one full
+ *          burst, then RXB0CTRL and RXB1CTRL
+ *        - verify every configuration register written with a single burst read (0x00 to RXB1CTRL)
+ *        - enter the operation mode of the image and wait until the MCP2515 runs in it
+ * 
+ *        The configuration parameters of the CAN_Control_HandleTypeDef are updated from the image, so that the rest of
+ *        the driver (e.g. CAN_Control_Wake_Up()) works as after CAN_Control_Init().
+ * 
+ * @param hcan     pointer to an MCP2515 configuration structure (only its SPI bus, CS and INT pins are used, refer to
+ *                 CAN_Control_Init_Pins())
+ * @param image    pointer to the register image
+ * @return uint8_t IMAGE_OK, IMAGE_VERIFY_ERROR (no valid SPI bus or a register does not hold its image value,
+ *                 the MCP2515 is left in configuration mode) or IMAGE_OPMODE_TIMEOUT
+ *                 (refer to 'MCP2515 register image initialization results' in can.h)
+ */
+uint8_t CAN_Control_Init_Image( CAN_Control_HandleTypeDef *hcan, const CAN_Control_Image *image )
+{
+    uint8_t spi_read[ RXB1CTRL_REG + 1U ];
+    uint8_t i;
+
+    /* Set up the SPI bus, CS pin and INT pin of the MCP2515 */
+    CAN_Control_Init_Pins( hcan );
+
+    if ( ( hcan->spiport != SPI1 ) && ( hcan->spiport != SPI2 ) )
+    {
+        return IMAGE_VERIFY_ERROR;
+    }
+
+    /* Reset MCP2515 (configuration mode once the OST is over) */
+    CAN_Control_Reset( hcan );
+
+    /* Write every configuration register, whatever the shadow register cache holds (filters have no defined reset
+       value): with every entry unknown, the bursts are not trimmed, and they load the cache from the image */
+    hcan->shadowvalid[ 0 ] = 0U;
+    hcan->shadowvalid[ 1 ] = 0U;
+
+    CAN_Control_Register_Write( hcan, RXF0SIDH_REG, image->regs, CAN_IMAGE_SIZE );
+    CAN_Control_Register_Write( hcan, RXB0CTRL_REG, &image->rxbctrl[ 0 ], 1U );
+    CAN_Control_Register_Write( hcan, RXB1CTRL_REG, &image->rxbctrl[ 1 ], 1U );
+
+    /* Read them back in one burst (masks and filters are only readable in configuration mode) */
+    CAN_Control_Register_Read( hcan, RXF0SIDH_REG, spi_read, sizeof( spi_read ) );
+
+    for ( i = 0U; i < CAN_IMAGE_SIZE; i++ )
+    {
+        if ( ( ( spi_read[ i ] ^ image->regs[ i ] ) & can_shadow_bits[ i ] ) != 0U )
+        {
+            break;
+        }
+    }
+
+    if ( ( i < CAN_IMAGE_SIZE ) ||
+         ( ( ( spi_read[ RXB0CTRL_REG ] ^ image->rxbctrl[ 0 ] ) & can_shadow_bits[ CAN_SHADOW_RXB0CTRL ] ) != 0U ) ||
+         ( ( ( spi_read[ RXB1CTRL_REG ] ^ image->rxbctrl[ 1 ] ) & can_shadow_bits[ CAN_SHADOW_RXB1CTRL ] ) != 0U ) )
+    {
+        CAN_Control_Shadow_Invalidate( hcan );
+        return IMAGE_VERIFY_ERROR;
+    }
+
+    /* Configuration parameters of the image */
+    CAN_Control_Image_Params( hcan, image );
+
+    /* Enter the operation mode right away */
+    CAN_Control_Register_Write( hcan, CANCTRL_REG, &image->canctrl, 1U );
+
+    if ( CAN_Control_Wait_Op_Mode( hcan, hcan->opmode, CAN_OPMODE_TIMEOUT_US ) != OPMODE_CHANGED )
+    {
+        return IMAGE_OPMODE_TIMEOUT;
+    }
+
+    /* Remember the image across STM32F070RB resets */
+    CAN_Control_Applied_Set( hcan, CAN_Control_Image_CRC( image ), 1U );
+
+    return IMAGE_OK;
+}
+
+/**
+ * @brief Start the MCP2515 after a reset of the STM32F070RB only (watchdog, firmware update...), without resetting
+ *        the MCP2515 when it still runs with the configuration of the register image:
+ *        - check that the image is the last one applied to the MCP2515 by CAN_Control_Init_Image(): its CRC-32 is kept
+ *          in .noinit RAM, which survives the reset, and any later configuration register write drops it (CANINTE
+ *          writes do not, interrupts are enabled by the application once running)
+ *        - read back the configuration registers in one burst (0x00 to RXB1CTRL) and compare their checksum against
+ *          the one of the image (refer to CAN_Control_Image_Checksum())
+ *        - if both match, keep the MCP2515 running: it stays on the bus, and frames in its RX buffers and pending
+ *          transmissions are kept, so servicing resumes right away. The shadow register cache is loaded from the image
+ *          (CANINTE from the register read back)
+ *        - otherwise (e.g. power-up, MCP2515 in configuration mode or with another configuration), fall back to
+ *          CAN_Control_Init_Image()
+ * 
+ *        Note: masks and filters are read as zeros out of configuration mode, so they are not part of the checksum
+ *              (entering configuration mode would take the MCP2515 off the bus). The applied image CRC covers them,
+ *              and their shadow entries are left invalid since they were not read back.
+ * 
+ * @param hcan     pointer to an MCP2515 configuration structure (only its SPI bus, CS and INT pins are used, refer to
+ *                 CAN_Control_Init_Pins())
+ * @param image    pointer to the register image
+ * @return uint8_t IMAGE_RESUMED if the MCP2515 kept running, otherwise the result of CAN_Control_Init_Image()
+ *                 (refer to 'MCP2515 register image initialization results' in can.h)
+ */
+uint8_t CAN_Control_Warm_Start( CAN_Control_HandleTypeDef *hcan, const CAN_Control_Image *image )
+{
+    uint8_t                          spi_read[ RXB1CTRL_REG + 1U ];
+    CAN_Control_Image                running;
+    const CAN_Control_Applied_Image *applied;
+    uint8_t                          i;
+
+    /* Set up the SPI bus, CS pin and INT pin of the MCP2515 */
+    CAN_Control_Init_Pins( hcan );
+
+    if ( ( hcan->spiport != SPI1 ) && ( hcan->spiport != SPI2 ) )
+    {
+        return IMAGE_VERIFY_ERROR;
+    }
+
+    /* Nothing is known about the MCP2515 registers yet */
+    CAN_Control_Shadow_Invalidate( hcan );
+
+    /* The image must be the last one applied before the reset (masks and filters can not be read back) */
+    applied = CAN_Control_Applied_Find( CAN_APPLIED_KEY( hcan ) );
+
+    if ( ( applied == NULL ) || ( applied->crc != CAN_Control_Image_CRC( image ) ) )
+    {
+        return CAN_Control_Init_Image( hcan, image );
+    }
+
+    /* Read the registers back in one burst and lay them out as a register image */
+    CAN_Control_Register_Read( hcan, RXF0SIDH_REG, spi_read, sizeof( spi_read ) );
+
+    for ( i = 0U; i < CAN_IMAGE_SIZE; i++ )
+    {
+        running.regs[ i ] = spi_read[ i ];
+    }
+
+    running.rxbctrl[ 0 ] = spi_read[ RXB0CTRL_REG ];
+    running.rxbctrl[ 1 ] = spi_read[ RXB1CTRL_REG ];
+    running.canctrl      = spi_read[ CANCTRL_REG ];
+
+    /* The MCP2515 must also run in the operation mode of the image (not still in configuration mode after a reset) */
+    if ( ( CAN_Control_Image_Checksum( &running ) != CAN_Control_Image_Checksum( image ) ) ||
+         ( ( spi_read[ CANSTAT_REG ] & OPMOD_MASK ) != ( image->canctrl & REQOP_MASK ) ) )
+    {
+        return CAN_Control_Init_Image( hcan, image );
+    }
+
+    /* Keep it running: load the shadow register cache (except masks and filters, not read back) and the configuration
+       parameters from the image */
+    for ( i = 0U; i < CAN_IMAGE_SIZE; i++ )
+    {
+        hcan->shadow[ i ] = image->regs[ i ] & can_shadow_bits[ i ];
+
+        if ( !CAN_SHADOW_BYTE_ONLY( i ) )
+        {
+            hcan->shadowvalid[ i >> 5 ] |= 1UL << ( i & 0x1FU );
+        }
+    }
+
+    hcan->shadow[ CANINTE_REG ]         = spi_read[ CANINTE_REG ];
+    hcan->shadow[ CANCTRL_REG ]         = image->canctrl;
+    hcan->shadow[ CAN_SHADOW_RXB0CTRL ] = image->rxbctrl[ 0 ] & can_shadow_bits[ CAN_SHADOW_RXB0CTRL ];
+    hcan->shadow[ CAN_SHADOW_RXB1CTRL ] = image->rxbctrl[ 1 ] & can_shadow_bits[ CAN_SHADOW_RXB1CTRL ];
+    hcan->shadowvalid[ CAN_SHADOW_RXB0CTRL >> 5 ] |= ( 1UL << ( CAN_SHADOW_RXB0CTRL & 0x1FU ) ) | ( 1UL << ( CAN_SHADOW_RXB1CTRL & 0x1FU ) );
+
+    CAN_Control_Image_Params( hcan, image );
+
+    return IMAGE_RESUMED;
+}
+
 /**
  * @brief Bring the MCP2515 to its reset state via the SPI command.
  *        This sets the internal registers to their default values (refer to datasheet)
@@ -94,46 +771,38 @@ void CAN_Control_Reset( CAN_Control_HandleTypeDef *hcan )
     uint8_t instruction = RESET_INS;
     uint8_t ost = GET_OST( OSC1_FREQ );
 
-    /* If SPI1 peripheral handles the CAN controller */
-    if ( ( hcan->spi == CAN_SPI1 ) )
-    {
-        /* Send RESET instruction to the CAN controller connected to SPI1.
-           Reset registers to the default state and set MCP2515 to configuration mode */
-        SPI1_CS_Enable();
-        SPI1_Write( &instruction, 1U );
-        SPI1_CS_Disable();
-    }
-    /* If SPI2 peripheral handles the CAN controller */
-    else if ( ( hcan->spi == CAN_SPI2 ) )
-    {
-        /* Send RESET instruction to the CAN controller connected to SPI2.
-           Reset registers to the default state and set MCP2515 to configuration mode*/
-        SPI2_CS_Enable();
-        SPI2_Write( &instruction, 1U );
-        SPI2_CS_Disable();
-    }
-    else
-    {
-        /* Do nothing */
-    }
+    /* Send RESET instruction to the CAN controller on its SPI bus.
+       Reset registers to the default state and set MCP2515 to configuration mode */
+    CAN_Control_Select( hcan );
+    SPI_Write( hcan->spiport, &instruction, 1U );
+    CAN_Control_Deselect( hcan );
 
     /* Wait 50us for the instruction to be processed by the MCP2515 (time is not specified in datasheet) */
     TIM3_Delay_us( 50U );
 
     /* MCP2515 must wait for an OST period for the oscillator to stabilize */
     TIM3_Delay_us( ost );
+
+    /* Every cached register is back to its reset value, and the RX buffers are empty */
+    CAN_Control_Shadow_Defaults( hcan );
+    CAN_Control_Applied_Set( hcan, 0U, 0U );
+    hcan->rxb1older = 0U;
 }
 
 /**
  * @brief Set the MCP2515 to the specified operation mode.
  * 
+ *        The user's one-shot and CLKOUT pin configurations are written to CANCTRL along with the requested mode,
+ *        so that the CLKOUT signal (when enabled) keeps running regardless of the operation mode set.
+ *        Nothing is sent when CANCTRL already requests that mode with that configuration (shadow register cache).
+ * 
  * @param hcan   pointer to an MCP2515 configuration structure (CAN module to be configured)
  * @param opmode MCP2515 operation mode. Refer to 'MCP2515 operation mode definitions' in can.h
  */
 void CAN_Control_Set_Op_Mode( CAN_Control_HandleTypeDef *hcan, uint8_t opmode )
 {
-    /* get user's oneshot configuration selected */
-    uint8_t spi_write = hcan->oneshot; /* CANCTRL register */
+    /* get user's oneshot and CLKOUT pin configurations selected */
+    uint8_t spi_write = hcan->oneshot | hcan->clkout; /* CANCTRL register */
 
     /* Determine operation mode to be set */
     switch ( opmode )
@@ -174,102 +843,135 @@ void CAN_Control_Set_Op_Mode( CAN_Control_HandleTypeDef *hcan, uint8_t opmode )
     }
 }
 
+/**
+ * @brief Wait for the MCP2515 to actually run in the specified operation mode (OPMOD bits in CANSTAT).
+ *        A requested mode change only takes place once the frame being sent or received is complete,
+ *        and the MCP2515 provides no interrupt for it, so CANSTAT is polled until it matches or the deadline expires.
+ * 
+ *        The time taken is measured with the SysTick cycle counter (refer to PROFILE_Init() in profile.c, it runs at the
+ *        core clock whether PROFILE_ENABLED is defined or not) and stored in hcan->opmodetime (and hcan->opmodetimemax)
+ *        in microseconds. The deadline is still counted as CAN_OPMODE_POLL_US per poll, so that the wait always ends.
+ *        A confirmed configuration mode lets the shadow register cache hold the configuration registers written next
+ *        (refer to CAN_Control_Shadow_Store()), a timeout drops that confirmation.
+ * 
+ * @param hcan       pointer to an MCP2515 configuration structure
+ * @param opmode     MCP2515 operation mode. Refer to 'MCP2515 operation mode definitions' in can.h
+ * @param timeout_us longest time to wait, in microseconds (refer to CAN_OPMODE_TIMEOUT_US)
+ * @return uint8_t   OPMODE_CHANGED or OPMODE_TIMEOUT (refer to 'verified operation mode change results' in can.h)
+ */
+uint8_t CAN_Control_Wait_Op_Mode( CAN_Control_HandleTypeDef *hcan, uint8_t opmode, uint32_t timeout_us )
+{
+    uint8_t  opmod   = ( uint8_t )( opmode << 5 ); /* operation mode definitions are the OPMOD values shifted right by 5 */
+    uint8_t  canstat = 0U;
+    uint8_t  result  = OPMODE_CHANGED;
+    uint32_t polled  = 0U;                         /* deadline count, CAN_OPMODE_POLL_US per poll  */
+    uint32_t cycles  = 0U;                         /* time taken, in core clock cycles            */
+    uint32_t start   = PROFILE_Get_Cycles();
+    uint32_t now;
+
+    /* Poll CANSTAT (not cached, read from the MCP2515 every time) */
+    CAN_Control_Register_Read( hcan, CANSTAT_REG, &canstat, 1U );
+
+    while ( ( canstat & OPMOD_MASK ) != opmod )
+    {
+        if ( polled >= timeout_us )
+        {
+            result = OPMODE_TIMEOUT;
+            break;
+        }
+
+        /* Add up the time of every poll, the 24-bit SysTick down-counter wraps around every 349ms */
+        now     = PROFILE_Get_Cycles();
+        cycles += ( start - now ) & PROFILE_CYCLES_MASK;
+        start   = now;
+
+        CAN_Control_Register_Read( hcan, CANSTAT_REG, &canstat, 1U );
+        polled += CAN_OPMODE_POLL_US;
+    }
+
+    now              = PROFILE_Get_Cycles();
+    cycles          += ( start - now ) & PROFILE_CYCLES_MASK;
+    hcan->opmodetime = cycles / ( SystemCoreClock / 1000000UL );
+
+    if ( result == OPMODE_TIMEOUT )
+    {
+        hcan->opmodetimeouts++;
+
+        /* Configuration mode is not confirmed, configuration register writes are not cached from now on */
+        hcan->configmode = 0U;
+    }
+    else
+    {
+        hcan->configmode = ( opmode == CONFIGURATION_OP_MODE ) ? 1U : 0U;
+
+        if ( hcan->opmodetime > hcan->opmodetimemax )
+        {
+            hcan->opmodetimemax = hcan->opmodetime;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Set the MCP2515 to the specified operation mode and wait until it actually runs in it, so that nothing
+ *        is written to the configuration registers before configuration mode is really entered (refer to
+ *        CAN_Control_Set_Op_Mode() and CAN_Control_Wait_Op_Mode()).
+ * 
+ * @param hcan       pointer to an MCP2515 configuration structure (CAN module to be configured)
+ * @param opmode     MCP2515 operation mode. Refer to 'MCP2515 operation mode definitions' in can.h
+ * @param timeout_us longest time to wait, in microseconds (refer to CAN_OPMODE_TIMEOUT_US)
+ * @return uint8_t   OPMODE_CHANGED or OPMODE_TIMEOUT (refer to 'verified operation mode change results' in can.h)
+ */
+uint8_t CAN_Control_Set_Op_Mode_Wait( CAN_Control_HandleTypeDef *hcan, uint8_t opmode, uint32_t timeout_us )
+{
+    uint8_t result;
+
+    /* Hold the SPI bus until the mode change is confirmed (or times out) */
+    SPI_Bus_Lock( hcan->spiport );
+
+    CAN_Control_Set_Op_Mode( hcan, opmode );
+    result = CAN_Control_Wait_Op_Mode( hcan, opmode, timeout_us );
+
+    SPI_Bus_Unlock( hcan->spiport );
+
+    return result;
+}
+
 /**
  * @brief Configure the MCP2515 CAN baud rate by updatting its bit timing registers.
- *        Bit timing details can be found in the comments below each case.
+ *        Bit timings are computed from OSC1_FREQ at build time, so this only looks up the table and writes one burst.
  * 
  *        Note: MCP2515 must be set to configuration operation mode before calling this function
  *              in order to be able to write to the configuration registers CNF3, CNF2 and CNF1.
  * 
  * @param hcan     pointer to an MCP2515 configuration structure (CAN module to be configured)
- * @param baudrate MCP2515 CAN baud rate. Refer to 'MCP2515 baud rates definitions' in can.h
+ * @param baudrate MCP2515 CAN baud rate. Refer to 'MCP2515 baud rates definitions' and CAN_BAUD_RATE_LIST in can.h
+ * @return uint8_t 1 if the bit timing registers were written, 0 if the baud rate is not supported with OSC1_FREQ
+ *                 (nothing is written)
  */
-void CAN_Control_Set_Baud_Rate( CAN_Control_HandleTypeDef *hcan, uint32_t baudrate )
+uint8_t CAN_Control_Set_Baud_Rate( CAN_Control_HandleTypeDef *hcan, uint32_t baudrate )
 {
     uint8_t spi_write[ 3 ];
+    uint8_t i;
 
-    /* Set CAN baud rate by writting to the bit timing registers of the MCP2515 */
-    switch ( baudrate )
-    {
-        case CAN_BAUD_500_KBPS:
-            /* BRP     = 0
-               TQ      = 2(BRP + 1)/fosc = 2/8MHz = 250ns
-               SyncSeg = 1TQ
-               PropSeg = 2TQ
-               PS1     = 2TQ
-               PS2     = 3TQ
-               SJW     = 1TQ
-               Sampling point = 62.5% */
-            spi_write[ 0 ] = hcan->wakeupfilter | PHSEG2_3TQ;                                      /* CNF3 register */
-            spi_write[ 1 ] = BTLMODE_PS2_PHSEG2_CNF3 | hcan->samplepoint | PHSEG1_2TQ | PRSEG_2TQ; /* CNF2 register */
-            spi_write[ 2 ] = SJW_1TQ;                                                              /* CNF1 register */
-            CAN_Control_Register_Write( hcan, CNF3_REG, spi_write, 3U );
-            break;
-
-        case CAN_BAUD_250_KBPS:
-            /* BRP     = 0
-               TQ      = 2(BRP + 1)/fosc = 2/8MHz = 250ns
-               SyncSeg = 1TQ
-               PropSeg = 4TQ
-               PS1     = 5TQ
-               PS2     = 6TQ
-               SJW     = 1TQ
-               Sampling point = 62.5% */
-            spi_write[ 0 ] = hcan->wakeupfilter | PHSEG2_6TQ;                                      /* CNF3 register */
-            spi_write[ 1 ] = BTLMODE_PS2_PHSEG2_CNF3 | hcan->samplepoint | PHSEG1_5TQ | PRSEG_4TQ; /* CNF2 register */
-            spi_write[ 2 ] = SJW_1TQ;                                                              /* CNF1 register */
-            CAN_Control_Register_Write( hcan, CNF3_REG, spi_write, 3U );
-            break;
-
-        case CAN_BAUD_125_KBPS:
-            /* BRP     = 1
-               TQ      = 2(BRP + 1)/fosc = 4/8MHz = 500ns
-               SyncSeg = 1TQ
-               PropSeg = 3TQ
-               PS1     = 6TQ
-               PS2     = 6TQ
-               SJW     = 1TQ
-               Sampling point = 62.5% */
-            spi_write[ 0 ] = hcan->wakeupfilter | PHSEG2_6TQ;                                      /* CNF3 register */
-            spi_write[ 1 ] = BTLMODE_PS2_PHSEG2_CNF3 | hcan->samplepoint | PHSEG1_6TQ | PRSEG_3TQ; /* CNF2 register */
-            spi_write[ 2 ] = SJW_1TQ | BRP_BIT_0;                                                  /* CNF1 register */
-            CAN_Control_Register_Write( hcan, CNF3_REG, spi_write, 3U );
-            break;
-
-        case CAN_BAUD_100_KBPS:
-            /* BRP     = 1
-               TQ      = 2(BRP + 1)/fosc = 4/8MHz = 500ns
-               SyncSeg = 1TQ
-               PropSeg = 6TQ
-               PS1     = 6TQ
-               PS2     = 7TQ
-               SJW     = 1TQ
-               Sampling point = 65% */
-            spi_write[ 0 ] = hcan->wakeupfilter | PHSEG2_7TQ;                                      /* CNF3 register */
-            spi_write[ 1 ] = BTLMODE_PS2_PHSEG2_CNF3 | hcan->samplepoint | PHSEG1_6TQ | PRSEG_6TQ; /* CNF2 register */
-            spi_write[ 2 ] = SJW_1TQ | BRP_BIT_0;                                                  /* CNF1 register */
-            CAN_Control_Register_Write( hcan, CNF3_REG, spi_write, 3U );
-            break;
-
-        case CAN_BAUD_50_KBPS:
-            /* BRP     = 3
-               TQ      = 2(BRP + 1)/fosc = 8/8MHz = 1us
-               SyncSeg = 1TQ
-               PropSeg = 6TQ
-               PS1     = 6TQ
-               PS2     = 7TQ
-               SJW     = 1TQ
-               Sampling point = 65% */
-            spi_write[ 0 ] = hcan->wakeupfilter | PHSEG2_7TQ;                                      /* CNF3 register */
-            spi_write[ 1 ] = BTLMODE_PS2_PHSEG2_CNF3 | hcan->samplepoint | PHSEG1_6TQ | PRSEG_6TQ; /* CNF2 register */
-            spi_write[ 2 ] = SJW_1TQ | BRP_BIT_1 | BRP_BIT_0;                                      /* CNF1 register */
+    /* Look for the requested baud rate in the bit timing table */
+    for ( i = 0U; i < ( sizeof( can_bit_timing ) / sizeof( can_bit_timing[ 0 ] ) ); i++ )
+    {
+        if ( can_bit_timing[ i ].baudrate == baudrate )
+        {
+            /* Set CAN baud rate by writting to the bit timing registers of the MCP2515 in a single burst */
+            spi_write[ 0 ] = hcan->wakeupfilter | can_bit_timing[ i ].cnf[ 0 ]; /* CNF3 register */
+            spi_write[ 1 ] = hcan->samplepoint  | can_bit_timing[ i ].cnf[ 1 ]; /* CNF2 register */
+            spi_write[ 2 ] = can_bit_timing[ i ].cnf[ 2 ];                      /* CNF1 register */
             CAN_Control_Register_Write( hcan, CNF3_REG, spi_write, 3U );
-            break;
 
-        default:
-            /* Wrong baud rate selected */
-            break;
+            return 1U;
+        }
     }
+
+    /* ... otherwise wrong baud rate selected */
+    return 0U;
 }
 
 /**
@@ -287,33 +989,19 @@ void CAN_Control_Set_Baud_Rate( CAN_Control_HandleTypeDef *hcan, uint32_t baudra
 void CAN_Control_Set_RX_Mask( CAN_Control_HandleTypeDef *hcan, CAN_Control_RX_Mask *hmask )
 {
     uint8_t spi_write[ 4 ];
+    uint8_t mask;
 
-    /* If mask 0 (applies to RX buffer 0) is selected for configuration */
-    if ( ( hmask->rxmasknmbr & RXM0 ) == RXM0 )
+    for ( mask = 0U; mask < 2U; mask++ )
     {
-        /* Get the mask 0 register values */
-        spi_write[ 0 ]  =   hmask->rxmaskvalue[ 0 ] >> 21;           /* RXM0SIDH.SID[10:3]  */
-        spi_write[ 1 ]  = ( hmask->rxmaskvalue[ 0 ] >> 13 ) & 0xE0U; /* RXM0SIDL.SID[2:0]   */
-        spi_write[ 1 ] |= ( hmask->rxmaskvalue[ 0 ] >> 16 ) & 0x03U; /* RXM0SIDL.EID[17:16] */
-        spi_write[ 2 ]  =   hmask->rxmaskvalue[ 0 ] >> 8;            /* RXM0EID8.EID[15:8]  */
-        spi_write[ 3 ]  =   hmask->rxmaskvalue[ 0 ];                 /* RXM0EID0.EID[7:0]   */
-
-        /* Write the mask values to the mask 0 registers */
-        CAN_Control_Register_Write( hcan, RXM0SIDH_REG, spi_write, 4U );
-    }
-
-    /* If mask 1 (applies to RX buffer 1) is selected for configuration */
-    if ( ( hmask->rxmasknmbr & RXM1 ) == RXM1 )
-    {
-        /* Get the mask 1 register values */
-        spi_write[ 0 ]  =   hmask->rxmaskvalue[ 1 ] >> 21;           /* RXM1SIDH.SID[10:3]  */
-        spi_write[ 1 ]  = ( hmask->rxmaskvalue[ 1 ] >> 13 ) & 0xE0U; /* RXM1SIDL.SID[2:0]   */
-        spi_write[ 1 ] |= ( hmask->rxmaskvalue[ 1 ] >> 16 ) & 0x03U; /* RXM1SIDL.EID[17:16] */
-        spi_write[ 2 ]  =   hmask->rxmaskvalue[ 1 ] >> 8;            /* RXM1EID8.EID[15:8]  */
-        spi_write[ 3 ]  =   hmask->rxmaskvalue[ 1 ];                 /* RXM1EID0.EID[7:0]   */
+        /* If mask n (mask 0 applies to RX buffer 0, mask 1 to RX buffer 1) is selected for configuration */
+        if ( ( hmask->rxmasknmbr & ( RXM0 << mask ) ) != 0U )
+        {
+            /* Get the mask n register values: RXMnSIDH, RXMnSIDL, RXMnEID8 and RXMnEID0 */
+            CAN_Control_ID_Pack_Raw( hmask->rxmaskvalue[ mask ], spi_write );
 
-        /* Write the mask values to the mask 1 registers */
-        CAN_Control_Register_Write( hcan, RXM1SIDH_REG, spi_write, 4U );
+            /* Write the mask values to the mask n registers */
+            CAN_Control_Register_Write( hcan, RXM0SIDH_REG + ( mask << 2 ), spi_write, 4U );
+        }
     }
 }
 
@@ -332,131 +1020,22 @@ void CAN_Control_Set_RX_Mask( CAN_Control_HandleTypeDef *hcan, CAN_Control_RX_Ma
 void CAN_Control_Set_RX_Filter( CAN_Control_HandleTypeDef *hcan, CAN_Control_RX_Filter *hfilter )
 {
     uint8_t spi_write[ 4 ];
-    
-    /* If filter 0 is selected for configuration */
-    if ( ( hfilter->rxfilternmbr & RXF0 ) == RXF0 )
-    {
-        /* Get the filter 0 register values */
-        spi_write[ 0 ]  =   hfilter->rxfiltervalue[ 0 ] >> 21;           /* RXF0SIDH.SID[10:3]  */
-        spi_write[ 1 ]  = ( hfilter->rxfiltervalue[ 0 ] >> 13 ) & 0xE0U; /* RXF0SIDL.SID[2:0]   */
-        spi_write[ 1 ] |= ( hfilter->rxfiltervalue[ 0 ] >> 16 ) & 0x03U; /* RXF0SIDL.EID[17:16] */
-        spi_write[ 2 ]  =   hfilter->rxfiltervalue[ 0 ] >> 8;            /* RXF0EID8.EID[15:8]  */
-        spi_write[ 3 ]  =   hfilter->rxfiltervalue[ 0 ];                 /* RXF0EID0.EID[7:0]   */
-	
-        /* If filter 0 is to be applied only to extended frames */
-        if ( ( hfilter->extendedidenable & RXF0_EXTENDED_ID_ENABLED ) == RXF0_EXTENDED_ID_ENABLED )
-        {
-            /* set EXIDE bit in RXF0SIDL register */
-            spi_write[ 1 ] |= EXIDE_FILTER_APPLY_ONLY_EXTENDED_FRAMES;
-        }
+    uint8_t filter;
 
-        /* Write the filter values to the filter 0 registers */
-        CAN_Control_Register_Write( hcan, RXF0SIDH_REG, spi_write, 4U );
-    }
-
-    /* If filter 1 is selected for configuration */
-    if ( ( hfilter->rxfilternmbr & RXF1 ) == RXF1 )
+    for ( filter = 0U; filter < 6U; filter++ )
     {
-        /* Get the filter 1 register values */
-        spi_write[ 0 ]  =   hfilter->rxfiltervalue[ 1 ] >> 21;           /* RXF1SIDH.SID[10:3]  */
-        spi_write[ 1 ]  = ( hfilter->rxfiltervalue[ 1 ] >> 13 ) & 0xE0U; /* RXF1SIDL.SID[2:0]   */
-        spi_write[ 1 ] |= ( hfilter->rxfiltervalue[ 1 ] >> 16 ) & 0x03U; /* RXF1SIDL.EID[17:16] */
-        spi_write[ 2 ]  =   hfilter->rxfiltervalue[ 1 ] >> 8;            /* RXF1EID8.EID[15:8]  */
-        spi_write[ 3 ]  =   hfilter->rxfiltervalue[ 1 ];                 /* RXF1EID0.EID[7:0]   */
-	
-        /* If filter 1 is to be applied only to extended frames */
-        if ( ( hfilter->extendedidenable & RXF1_EXTENDED_ID_ENABLED ) == RXF1_EXTENDED_ID_ENABLED )
+        /* If filter n is selected for configuration */
+        if ( ( hfilter->rxfilternmbr & ( RXF0 << filter ) ) != 0U )
         {
-            /* set EXIDE bit in RXF1SIDL register */
-            spi_write[ 1 ] |= EXIDE_FILTER_APPLY_ONLY_EXTENDED_FRAMES;
-        }
+            /* Get the filter n register values: RXFnSIDH, RXFnSIDL, RXFnEID8 and RXFnEID0 */
+            CAN_Control_ID_Pack_Raw( hfilter->rxfiltervalue[ filter ], spi_write );
 
-        /* Write the filter values to the filter 1 registers */
-        CAN_Control_Register_Write( hcan, RXF1SIDH_REG, spi_write, 4U );
-    }
-
-    /* If filter 2 is selected for configuration */
-    if ( ( hfilter->rxfilternmbr & RXF2 ) == RXF2 )
-    {
-        /* Get the filter 2 register values */
-        spi_write[ 0 ]  =   hfilter->rxfiltervalue[ 2 ] >> 21;           /* RXF2SIDH.SID[10:3]  */
-        spi_write[ 1 ]  = ( hfilter->rxfiltervalue[ 2 ] >> 13 ) & 0xE0U; /* RXF2SIDL.SID[2:0]   */
-        spi_write[ 1 ] |= ( hfilter->rxfiltervalue[ 2 ] >> 16 ) & 0x03U; /* RXF2SIDL.EID[17:16] */
-        spi_write[ 2 ]  =   hfilter->rxfiltervalue[ 2 ] >> 8;            /* RXF2EID8.EID[15:8]  */
-        spi_write[ 3 ]  =   hfilter->rxfiltervalue[ 2 ];                 /* RXF2EID0.EID[7:0]   */
-	
-	    /* If filter 2 is to be applied only to extended frames */
-        if ( ( hfilter->extendedidenable & RXF2_EXTENDED_ID_ENABLED ) == RXF2_EXTENDED_ID_ENABLED )
-        {
-            /* set EXIDE bit in RXF2SIDL register */
-            spi_write[ 1 ] |= EXIDE_FILTER_APPLY_ONLY_EXTENDED_FRAMES;
-        }
+            /* If filter n is to be applied only to extended frames, set EXIDE bit in RXFnSIDL register */
+            spi_write[ 1 ] |= ( ( hfilter->extendedidenable >> filter ) & 0x01U ) << 3; /* EXIDE_FILTER_APPLY_ONLY_EXTENDED_FRAMES */
 
-        /* Write the filter values to the filter 2 registers */
-        CAN_Control_Register_Write( hcan, RXF2SIDH_REG, spi_write, 4U );
-    }
-    
-    /* If filter 3 is selected for configuration */
-    if ( ( hfilter->rxfilternmbr & RXF3 ) == RXF3 )
-    {
-        /* Get the filter 3 register values */
-        spi_write[ 0 ]  =   hfilter->rxfiltervalue[ 3 ] >> 21;           /* RXF3SIDH.SID[10:3]  */
-        spi_write[ 1 ]  = ( hfilter->rxfiltervalue[ 3 ] >> 13 ) & 0xE0U; /* RXF3SIDL.SID[2:0]   */
-        spi_write[ 1 ] |= ( hfilter->rxfiltervalue[ 3 ] >> 16 ) & 0x03U; /* RXF3SIDL.EID[17:16] */
-        spi_write[ 2 ]  =   hfilter->rxfiltervalue[ 3 ] >> 8;            /* RXF3EID8.EID[15:8]  */
-        spi_write[ 3 ]  =   hfilter->rxfiltervalue[ 3 ];                 /* RXF3EID0.EID[7:0]   */
-	
-	    /* If filter 3 is to be applied only to extended frames */
-        if ( ( hfilter->extendedidenable & RXF3_EXTENDED_ID_ENABLED ) == RXF3_EXTENDED_ID_ENABLED )
-        {
-            /* set EXIDE bit in RXF3SIDL register */
-            spi_write[ 1 ] |= EXIDE_FILTER_APPLY_ONLY_EXTENDED_FRAMES;
+            /* Write the filter values to the filter n registers (RXF3SIDH follows a gap after RXF2EID0) */
+            CAN_Control_Register_Write( hcan, can_rxfsidh_reg[ filter ], spi_write, 4U );
         }
-
-        /* Write the filter values to the filter 3 registers */
-        CAN_Control_Register_Write( hcan, RXF3SIDH_REG, spi_write, 4U );
-    }
-
-    /* If filter 4 is selected for configuration */
-    if ( ( hfilter->rxfilternmbr & RXF4 ) == RXF4 )
-    {
-        /* Get the filter 4 register values */
-        spi_write[ 0 ]  =   hfilter->rxfiltervalue[ 4 ] >> 21;           /* RXF4SIDH.SID[10:3]  */
-        spi_write[ 1 ]  = ( hfilter->rxfiltervalue[ 4 ] >> 13 ) & 0xE0U; /* RXF4SIDL.SID[2:0]   */
-        spi_write[ 1 ] |= ( hfilter->rxfiltervalue[ 4 ] >> 16 ) & 0x03U; /* RXF4SIDL.EID[17:16] */
-        spi_write[ 2 ]  =   hfilter->rxfiltervalue[ 4 ] >> 8;            /* RXF4EID8.EID[15:8]  */
-        spi_write[ 3 ]  =   hfilter->rxfiltervalue[ 4 ];                 /* RXF4EID0.EID[7:0]   */
-	
-	    /* If filter 4 is to be applied only to extended frames */
-        if ( ( hfilter->extendedidenable & RXF4_EXTENDED_ID_ENABLED ) == RXF4_EXTENDED_ID_ENABLED )
-        {
-            /* set EXIDE bit in RXF4SIDL register */
-            spi_write[ 1 ] |= EXIDE_FILTER_APPLY_ONLY_EXTENDED_FRAMES;
-        }
-
-        /* Write the filter values to the filter 4 registers */
-        CAN_Control_Register_Write( hcan, RXF4SIDH_REG, spi_write, 4U );
-    }
-
-    /* If filter 5 is selected for configuration */
-    if ( ( hfilter->rxfilternmbr & RXF5 ) == RXF5 )
-    {
-        /* Get the filter 5 register values */
-        spi_write[ 0 ]  =   hfilter->rxfiltervalue[ 5 ] >> 21;           /* RXF5SIDH.SID[10:3]  */
-        spi_write[ 1 ]  = ( hfilter->rxfiltervalue[ 5 ] >> 13 ) & 0xE0U; /* RXF5SIDL.SID[2:0]   */
-        spi_write[ 1 ] |= ( hfilter->rxfiltervalue[ 5 ] >> 16 ) & 0x03U; /* RXF5SIDL.EID[17:16] */
-        spi_write[ 2 ]  =   hfilter->rxfiltervalue[ 5 ] >> 8;            /* RXF5EID8.EID[15:8]  */
-        spi_write[ 3 ]  =   hfilter->rxfiltervalue[ 5 ];                 /* RXF5EID0.EID[7:0]   */
-	
-	    /* If filter 5 is to be applied only to extended frames */
-        if ( ( hfilter->extendedidenable & RXF5_EXTENDED_ID_ENABLED ) == RXF5_EXTENDED_ID_ENABLED )
-        {
-            /* set EXIDE bit in RXF5SIDL register */
-            spi_write[ 1 ] |= EXIDE_FILTER_APPLY_ONLY_EXTENDED_FRAMES;
-        }
-
-        /* Write the filter values to the filter 5 registers */
-        CAN_Control_Register_Write( hcan, RXF5SIDH_REG, spi_write, 4U );
     }
 }
 
@@ -473,36 +1052,62 @@ void CAN_Control_Set_RX_Filter( CAN_Control_HandleTypeDef *hcan, CAN_Control_RX_
  *              - RXMnSIDLH, RXMnSIDL, RXMnEID8, RXMnEID0
  *              - RXFnSIDLH, RXFnSIDL, RXFnEID8, RXFnEID0
  * 
+ *        Cached configuration registers (refer to 'shadow register cache definitions' in can.h) that already hold
+ *        their value are not written again: the burst is trimmed to the bytes from the first to the last one that
+ *        changes, and no SPI transaction is made at all if none does.
+ * 
  * @param hcan     pointer to an MCP2515 configuration structure (CAN module to write to)
  * @param reg_addr register address to write to. Refer to 'MCP2515 register addresses definitions' in can.h
  * @param data     data array that contains the information to be written
  * @param size     number of bytes to write from the data array to the register
  */
-void CAN_Control_Register_Write( CAN_Control_HandleTypeDef *hcan, uint8_t reg_addr, uint8_t *data, uint8_t size )
+void CAN_Control_Register_Write( CAN_Control_HandleTypeDef *hcan, uint8_t reg_addr, const uint8_t *data, uint8_t size )
 {   
     uint8_t instruction = WRITE_INS;
+    uint8_t first = size;
+    uint8_t last  = 0U;
+    uint8_t index, i;
 
-    /* If SPI1 peripheral handles the CAN controller */
-    if ( ( hcan->spi == CAN_SPI1 ) )
+    /* Find the bytes that change a register (uncached, not known or different value) */
+    for ( i = 0U; i < size; i++ )
     {
-        SPI1_CS_Enable();
-        SPI1_Write( &instruction, 1U ); /* Request WRITE to the CAN controller (MCP2515) ... */
-        SPI1_Write( &reg_addr, 1U );    /* ... to this address */
-        SPI1_Write( data, size );       /* Write 'size' number of bytes from the data array */
-        SPI1_CS_Disable();
+        index = CAN_Control_Shadow_Index( reg_addr + i );
+
+        if ( ( index == CAN_SHADOW_NONE ) || ( CAN_Control_Shadow_Valid( hcan, index ) == 0U ) ||
+             ( ( ( hcan->shadow[ index ] ^ data[ i ] ) & can_shadow_bits[ index ] ) != 0U ) )
+        {
+            first = ( first == size ) ? i : first;
+            last  = i;
+        }
     }
-    /* If SPI2 peripheral handles the CAN controller */
-    else if ( ( hcan->spi == CAN_SPI2 ) )
+
+    /* Nothing would change */
+    if ( first == size )
     {
-        SPI2_CS_Enable();
-        SPI2_Write( &instruction, 1U ); /* Request WRITE to the CAN controller (MCP2515) ... */
-        SPI2_Write( &reg_addr, 1U );    /* ... to this address */
-        SPI2_Write( data, size );       /* Write 'size' number of bytes from the data array */
-        SPI2_CS_Disable();
+        return;
     }
-    else
+
+    reg_addr += first;
+
+    PROFILE_START( PROFILE_SPI_TRANSACTION );
+
+    CAN_Control_Select( hcan );
+    SPI_Write( hcan->spiport, &instruction, 1U );                            /* Request WRITE to the CAN controller (MCP2515) ... */
+    SPI_Write( hcan->spiport, &reg_addr, 1U );                               /* ... to this address */
+    SPI_Write( hcan->spiport, &data[ first ], ( uint8_t )( last - first + 1U ) ); /* Write the bytes that change from the data array */
+    CAN_Control_Deselect( hcan );
+
+    PROFILE_STOP( PROFILE_SPI_TRANSACTION );
+
+    /* Keep the shadow register cache up to date */
+    for ( i = first; i <= last; i++ )
     {
-        /* Do nothing */
+        index = CAN_Control_Shadow_Index( reg_addr + ( i - first ) );
+
+        if ( index != CAN_SHADOW_NONE )
+        {
+            CAN_Control_Shadow_Store( hcan, index, data[ i ] );
+        }
     }
 
     /* Wait 50us for the data to be processed by the MCP2515 (time is not specified in datasheet) */
@@ -515,6 +1120,10 @@ void CAN_Control_Register_Write( CAN_Control_HandleTypeDef *hcan, uint8_t reg_ad
  * 
  *        Bear in mind that the mask and filter registers are read as zeros in any mode except configuration mode, therefore
  *        for this case the MCP2515 must be set to configuration mode before any reading attempt is made from them.
+ * 
+ *        When every register read is held by the shadow register cache (configuration registers only, refer to
+ *        'shadow register cache definitions' in can.h), the values come from the cache without any SPI transaction,
+ *        in any operation mode.
  *
  * @param hcan     pointer to an MCP2515 configuration structure (CAN module to read from)
  * @param reg_addr register address to read from. Refer to 'MCP2515 register addresses definitions' in can.h
@@ -524,30 +1133,40 @@ void CAN_Control_Register_Write( CAN_Control_HandleTypeDef *hcan, uint8_t reg_ad
 void CAN_Control_Register_Read( CAN_Control_HandleTypeDef *hcan, uint8_t reg_addr, uint8_t *data, uint8_t size )
 {
     uint8_t instruction = READ_INS;
+    uint8_t index, i;
 
-    /* If SPI1 peripheral handles the CAN controller */
-    if ( hcan->spi == CAN_SPI1 )
+    /* Look for every register in the shadow register cache */
+    for ( i = 0U; i < size; i++ )
     {
-        SPI1_CS_Enable();
-        SPI1_Write( &instruction, 1U ); /* Request READ to the CAN controller (MCP2515) ... */
-        SPI1_Write( &reg_addr, 1U );    /* ... from this address */
-        SPI1_Read( data, size );        /* Read back 'size' bytes and store them into the data array */
-        SPI1_CS_Disable();
-    }
-    /* If SPI2 peripheral handles the CAN controller */
-    else if ( hcan->spi == CAN_SPI2 )
-    {
-        SPI2_CS_Enable();
-        SPI2_Write( &instruction, 1U ); /* Request READ to the CAN controller (MCP2515) ... */
-        SPI2_Write( &reg_addr, 1U );    /* ... from this address */
-        SPI2_Read( data, size );        /* Read back 'size' bytes and store them into the data array */
-        SPI2_CS_Disable();
+        index = CAN_Control_Shadow_Index( reg_addr + i );
+
+        if ( ( index == CAN_SHADOW_NONE ) || CAN_SHADOW_READ_THROUGH( index ) || ( CAN_Control_Shadow_Valid( hcan, index ) == 0U ) )
+        {
+            break;
+        }
     }
-    else
+
+    /* All of them cached */
+    if ( ( size > 0U ) && ( i == size ) )
     {
-        /* Do nothing */
+        for ( i = 0U; i < size; i++ )
+        {
+            data[ i ] = hcan->shadow[ CAN_Control_Shadow_Index( reg_addr + i ) ];
+        }
+
+        return;
     }
 
+    PROFILE_START( PROFILE_SPI_TRANSACTION );
+
+    CAN_Control_Select( hcan );
+    SPI_Write( hcan->spiport, &instruction, 1U ); /* Request READ to the CAN controller (MCP2515) ... */
+    SPI_Write( hcan->spiport, &reg_addr, 1U );    /* ... from this address */
+    SPI_Read( hcan->spiport, data, size );        /* Read back 'size' bytes and store them into the data array */
+    CAN_Control_Deselect( hcan );
+
+    PROFILE_STOP( PROFILE_SPI_TRANSACTION );
+
     /* Wait 50us for the data to be processed by the MCP2515 (time is not specified in datasheet) */
     TIM3_Delay_us( 50U );
 }
@@ -562,45 +1181,127 @@ void CAN_Control_Register_Read( CAN_Control_HandleTypeDef *hcan, uint8_t reg_add
  *        - EFLG
  *        - CANCTRL
  * 
- *        Note: executing the BIT MODIFY command on non bit-modifiable registers forces the mask to 0xFF.
- *              This causes byte WRITES to the registers, not BIT MODIFY.
+ *        Note: executing the BIT MODIFY command on non bit-modifiable registers forces the mask to 0xFF.
+ *              This causes byte WRITES to the registers, not BIT MODIFY.
+ * 
+ *        A BIT MODIFY that would not change a cached configuration register is not sent (refer to
+ *        'shadow register cache definitions' in can.h).
+ * 
+ * @param hcan     pointer to an MCP2515 configuration structure (CAN module to be bit modified)
+ * @param reg_addr register address to bit modify. Refer to 'MCP2515 register addresses definitions' in can.h
+ * @param mask     8-bit mask value. Determines which bits in the register will be modified. 1 = modify, 0 = not modify
+ * @param data     8-bit data. Determines what value the modified bits in the register will be changed to
+ */
+void CAN_Control_Register_Bit( CAN_Control_HandleTypeDef *hcan, uint8_t reg_addr, uint8_t mask, uint8_t data )
+{
+    uint8_t instruction = BIT_MODIFY_INS;
+    uint8_t index       = CAN_Control_Shadow_Index( reg_addr );
+    uint8_t value       = 0U;
+
+    if ( index != CAN_SHADOW_NONE )
+    {
+        /* Filters and masks are written as a whole byte */
+        value = CAN_SHADOW_BYTE_ONLY( index ) ? data : ( uint8_t )( ( hcan->shadow[ index ] & ~mask ) | ( data & mask ) );
+
+        if ( ( CAN_Control_Shadow_Valid( hcan, index ) == 1U ) && ( ( ( hcan->shadow[ index ] ^ value ) & can_shadow_bits[ index ] ) == 0U ) )
+        {
+            return;
+        }
+    }
+
+    PROFILE_START( PROFILE_SPI_TRANSACTION );
+
+    CAN_Control_Select( hcan );
+    SPI_Write( hcan->spiport, &instruction, 1U ); /* Request BIT_MODIFY to the CAN controller (MCP2515) ... */
+    SPI_Write( hcan->spiport, &reg_addr, 1U );    /* ... to this address */
+    SPI_Write( hcan->spiport, &mask, 1U );        /* Send the mask byte value */
+    SPI_Write( hcan->spiport, &data, 1U );        /* Send the data byte value */
+    CAN_Control_Deselect( hcan );
+
+    PROFILE_STOP( PROFILE_SPI_TRANSACTION );
+
+    /* Keep the shadow register cache up to date (the other bits of a register not known yet remain unknown) */
+    if ( ( index != CAN_SHADOW_NONE ) && ( CAN_SHADOW_BYTE_ONLY( index ) || ( CAN_Control_Shadow_Valid( hcan, index ) == 1U ) ) )
+    {
+        CAN_Control_Shadow_Store( hcan, index, value );
+    }
+    /* Requested mode of an unknown CANCTRL not known either */
+    else if ( reg_addr == CANCTRL_REG )
+    {
+        hcan->configmode = 0U;
+    }
+    /* Register of the last applied register image changed (refer to CAN_Control_Warm_Start()) */
+    else if ( ( index != CAN_SHADOW_NONE ) && ( index != CANINTE_REG ) )
+    {
+        CAN_Control_Applied_Set( hcan, 0U, 0U );
+    }
+    else
+    {
+        /* Do nothing */
+    }
+
+    /* Wait 50us for the data to be processed by the MCP2515 (time is not specified in datasheet) */
+    TIM3_Delay_us( 50U );    
+}
+
+/**
+ * @brief Drop every entry of the shadow register cache, so that the next reads and writes of the configuration registers
+ *        go to the MCP2515. To be called whenever the MCP2515 registers may have changed without the driver
+ *        (e.g. MCP2515 reset by its RESET pin or a power cycle, or registers written bypassing this driver).
+ * 
+ * @param hcan pointer to an MCP2515 configuration structure
+ */
+void CAN_Control_Shadow_Invalidate( CAN_Control_HandleTypeDef *hcan )
+{
+    hcan->shadowvalid[ 0 ] = 0U;
+    hcan->shadowvalid[ 1 ] = 0U;
+    hcan->configmode       = 0U;
+}
+
+/**
+ * @brief Load a CAN frame into the selected TX buffer with a single LOAD TX BUFFER instruction
+ *        (ID, DLC and data registers are written in one SPI transaction, starting at TXBnSIDH).
+ * 
+ *        Note: the TX buffer must not be pending for transmission (TXREQ = 0).
  * 
- * @param hcan     pointer to an MCP2515 configuration structure (CAN module to be bit modified)
- * @param reg_addr register address to bit modify. Refer to 'MCP2515 register addresses definitions' in can.h
- * @param mask     8-bit mask value. Determines which bits in the register will be modified. 1 = modify, 0 = not modify
- * @param data     8-bit data. Determines what value the modified bits in the register will be changed to
+ * @param hcan   pointer to an MCP2515 configuration structure (CAN sending node)
+ * @param buffer TX buffer index (0 = TXB0, 1 = TXB1, 2 = TXB2)
+ * @param frame  pointer to the CAN frame to be loaded
  */
-void CAN_Control_Register_Bit( CAN_Control_HandleTypeDef *hcan, uint8_t reg_addr, uint8_t mask, uint8_t data )
+static void CAN_Control_Load_TX_Buffer( CAN_Control_HandleTypeDef *hcan, uint8_t buffer, const CAN_Control_Frame *frame )
 {
-    uint8_t instruction = BIT_MODIFY_INS;
+    uint8_t spi_write[ 6 ];
+    uint8_t dlc  = ( frame->dlc > 8U ) ? 8U : frame->dlc; /* never more than the 8 data bytes of the frame */
+    uint8_t size = 0U;
 
-    /* If SPI1 peripheral handles the CAN controller */
-    if ( ( hcan->spi == CAN_SPI1 ) )
-    {
-        SPI1_CS_Enable();
-        SPI1_Write( &instruction, 1U ); /* Request BIT_MODIFY to the CAN controller (MCP2515) ... */
-        SPI1_Write( &reg_addr, 1U );    /* ... to this address */
-        SPI1_Write( &mask, 1U );        /* Send the mask byte value */
-        SPI1_Write( &data, 1U );        /* Send the data byte value */
-        SPI1_CS_Disable();
-    }
-    /* If SPI2 peripheral handles the CAN controller */
-    else if ( ( hcan->spi == CAN_SPI2 ) )
+    /* LOAD TX BUFFER instruction for TXBnSIDH (0x40, 0x42 or 0x44) */
+    spi_write[ 0 ] = LOAD_TX_BUFFER_TXB0SIDH_INS + ( buffer << 1 );
+
+    /* TXBnSIDH, TXBnSIDL (EXIDE bit set for extended frames), TXBnEID8 and TXBnEID0 */
+    CAN_Control_ID_Pack( frame->id, frame->flags & CAN_FRAME_EXTENDED, &spi_write[ 1 ] );
+
+    /* If CAN frame to be sent is remote, set the RTR bit and do not send any data byte */
+    if ( ( frame->flags & CAN_FRAME_REMOTE ) == CAN_FRAME_REMOTE )
     {
-        SPI2_CS_Enable();
-        SPI2_Write( &instruction, 1U ); /* Request BIT_MODIFY to the CAN controller (MCP2515) ... */
-        SPI2_Write( &reg_addr, 1U );    /* ... to this address */
-        SPI2_Write( &mask, 1U );        /* Send the mask byte value */
-        SPI2_Write( &data, 1U );        /* Send the data byte value */
-        SPI2_CS_Disable();
+        spi_write[ 5 ] = dlc | RTR_TRANSMIT_REMOTE_FRAME_REQUEST; /* TXBnDLC */
     }
     else
     {
-        /* Do nothing */
+        spi_write[ 5 ] = dlc; /* TXBnDLC */
+        size           = dlc;
     }
 
+    PROFILE_START( PROFILE_SPI_TRANSACTION );
+
+    CAN_Control_Select( hcan );
+    SPI_Write( hcan->spiport, spi_write, 6U );                  /* LOAD TX BUFFER instruction, ID and DLC registers ... */
+    SPI_Write( hcan->spiport, ( uint8_t * )frame->data, size ); /* ... followed by the data registers */
+    CAN_Control_Deselect( hcan );
+
+    PROFILE_STOP( PROFILE_SPI_TRANSACTION );
+
     /* Wait 50us for the data to be processed by the MCP2515 (time is not specified in datasheet) */
-    TIM3_Delay_us( 50U );    
+    TIM3_Delay_us( 50U );
 }
 
 /**
@@ -619,256 +1320,255 @@ void CAN_Control_Register_Bit( CAN_Control_HandleTypeDef *hcan, uint8_t reg_addr
  */
 void CAN_Control_Send_CAN_Frame( CAN_Control_HandleTypeDef *hcan, CAN_Control_TX *txcan )
 {
-    uint8_t spi_write[ 5 ];
+    CAN_Control_Frame frame;
+    uint8_t           spi_write = TXREQ_PENDING; /* TXBnCTRL */
+    uint8_t           buffer;
+    uint8_t           i;
 
-    /* If buffer TXB0 is selected for transmission */
-    if ( ( txcan->txbuffernmbr & TXB0 ) == TXB0 )
+    PROFILE_START( PROFILE_SEND_FRAME );
+
+    /* TXB0 is sent first, then TXB1 and TXB2 last */
+    for ( buffer = 0U; buffer < 3U; buffer++ )
     {
-        /* If CAN frame to be sent is extended (either data or remote frame) */
-        if ( ( txcan->txframetype[ 0 ] == TX_EXTENDED_DATA_FRAME ) || ( txcan->txframetype[ 0 ] == TX_EXTENDED_REMOTE_FRAME ) )
-        {
-            /* Get the TX buffer 0 COMPLETE ID register values */
-            spi_write[ 0 ]  =   txcan->txid[ 0 ] >> 21;           /* TXB0SIDH.SID[10:3]  */
-            spi_write[ 1 ]  = ( txcan->txid[ 0 ] >> 13 ) & 0xE0U; /* TXB0SIDL.SID[2:0]   */
-            spi_write[ 1 ] |= ( txcan->txid[ 0 ] >> 16 ) & 0x03U; /* TXB0SIDL.EID[17:16] */
-            spi_write[ 2 ]  =   txcan->txid[ 0 ] >> 8;            /* TXB0EID8.EID[15:8]  */
-            spi_write[ 3 ]  =   txcan->txid[ 0 ];                 /* TXB0EID0.EID[7:0]   */
-
-            /* Set EXIDE bit in TXB0SIDL register to indicate extended identifier is to be transmitted */
-            spi_write[ 1 ] |= EXIDE_MSG_TRANSMIT_EXTENDED_ID;
-        }
-        /* If CAN frame to be sent is standard (either data or remote frame) */
-        else
+        /* If buffer TXBn is selected for transmission */
+        if ( ( txcan->txbuffernmbr & ( TXB0 << buffer ) ) != 0U )
         {
-            /* Get the TX buffer 0 STANDARD ID register values */
-            spi_write[ 0 ] = txcan->txid[ 0 ] >> 3; /* TXB0SIDH.SID[10:3] */
-            spi_write[ 1 ] = txcan->txid[ 0 ] << 5; /* TXB0SIDL.SID[2:0]  */
-            
-            /* NOTE: TXB0SIDL.EID[17:16], TXB0EID8.EID[15:8], TXB0EID0.EID[7:0] and TXB0SIDL.EXIDE bit will be sent as 0s */
-            spi_write[ 2 ] = 0U; /* TXB0EID8.EID[15:8] */
-            spi_write[ 3 ] = 0U; /* TXB0EID0.EID[7:0]  */
-        }
-
-        /* Set number of data bytes to be transmitted/requested (TXB0DLC) in the CAN frame using TX buffer 0 */
-        spi_write[ 4 ] = txcan->datalength[ 0 ]; /* TXB0DLC */
+            /* Get the CAN frame of the TXBn slot ('TX buffer frame type definitions' match the CAN frame flags) */
+            frame.id        = txcan->txid[ buffer ];
+            frame.flags     = txcan->txframetype[ buffer ];
+            frame.dlc       = txcan->datalength[ buffer ];
+            frame.timestamp = 0U;
 
-        /* If CAN frame to be sent is remote (either standard or extended frame) */
-        if ( ( txcan->txframetype[ 0 ] == TX_STANDARD_REMOTE_FRAME ) || ( txcan->txframetype[ 0 ] == TX_EXTENDED_REMOTE_FRAME ) )
-        {
-            /* Set RTR bit in TXB0DLC register to indicate a remote request is to be transmitted */
-            spi_write[ 4 ] |= RTR_TRANSMIT_REMOTE_FRAME_REQUEST;
+            for ( i = 0U; i < 8U; i++ )
+            {
+                frame.data[ i ] = txcan->data[ buffer ][ i ];
+            }
 
-            /* Write to the MCP2515 TX buffer 0 ID and TX buffer 0 data length code registers */
-            CAN_Control_Register_Write( hcan, TXB0SIDH_REG, spi_write, 5U );
+            /* Write the TXBn ID, DLC and data registers and request its transmission (TXREQ bit in TXBnCTRL) */
+            SPI_Bus_Lock( hcan->spiport );
+            CAN_Control_Load_TX_Buffer( hcan, buffer, &frame );
+            CAN_Control_Register_Write( hcan, can_txbctrl_reg[ buffer ], &spi_write, 1U );
+            SPI_Bus_Unlock( hcan->spiport );
 
-            /* there's no need for writting to the TXB0 data registers (TXB0Dm) since this is a remote frame */
+            /* Wait for the CAN frame to be sent on the CAN bus ... */
+            switch ( txcan->txframetype[ buffer ] )
+            {
+                case TX_EXTENDED_DATA_FRAME:
+                    /* Longest possible delay for an extended CAN frame of length 'datalength[ n ]' and 'baudrate' bps */
+                    WAIT_SEND_EXTENDED_DATA_FRAME( txcan->datalength[ buffer ], hcan->baudrate );
+                    break;
+
+                case TX_STANDARD_DATA_FRAME:
+                    /* Longest possible delay for a standard CAN frame of length 'datalength[ n ]' and 'baudrate' bps */
+                    WAIT_SEND_STANDARD_DATA_FRAME( txcan->datalength[ buffer ], hcan->baudrate );
+                    break;
+
+                case TX_EXTENDED_REMOTE_FRAME:
+                    /* Longest possible delay for a 'baudrate' bps extended remote CAN frame */
+                    WAIT_SEND_EXTENDED_REMOTE_FRAME( hcan->baudrate );
+                    break;
+
+                default:
+                    /* Longest possible delay for a 'baudrate' bps standard remote CAN frame */
+                    WAIT_SEND_STANDARD_REMOTE_FRAME( hcan->baudrate );
+                    break;
+            }
         }
-        /* If CAN frame to be sent is data (either standard or extended frame) */
-        else
-        {
-            /* Write to the MCP2515 TX buffer 0 ID and TX buffer 0 data length code registers */
-            CAN_Control_Register_Write( hcan, TXB0SIDH_REG, spi_write, 5U );
+    }
 
-            /* Write to the MCP2515 TX buffer 0 Data (TXB0Dm) registers */
-            CAN_Control_Register_Write( hcan, TXB0D0_REG, txcan->data[ 0 ], txcan->datalength[ 0 ] );
-        }
+    PROFILE_STOP( PROFILE_SEND_FRAME );
+}
 
-        /* Request transmission of TX buffer 0 by setting the TXREQ bit in the TXB0CTRL register */
-        spi_write[ 0 ] = TXREQ_PENDING; /* TXB0CTRL */
-        CAN_Control_Register_Write( hcan, TXB0CTRL_REG, spi_write, 1U );
+/**
+ * @brief Queue a single CAN frame for transmission in the first TX buffer that is not pending (TXB0, then TXB1, then TXB2).
+ *        This function does not wait for the frame to be sent, use the TXnIF flags or CAN_Control_TX_CAN_Status() for that.
+ * 
+ * @param hcan     pointer to an MCP2515 configuration structure (CAN sending node)
+ * @param frame    pointer to the CAN frame to be sent
+ * @return uint8_t TX buffer used (refer to 'MCP2515 TX buffer number definitions' in can.h), 0 if all of them are pending
+ */
+uint8_t CAN_Control_Send_Frame( CAN_Control_HandleTypeDef *hcan, const CAN_Control_Frame *frame )
+{
+    uint8_t spi_read;
+    uint8_t spi_write = TXREQ_PENDING; /* TXBnCTRL */
+    uint8_t buffer;
+    uint8_t used      = 0U;
 
-        /* Wait for the CAN frame to be sent on the CAN bus ...
-           If frame is extended data frame */
-        if ( txcan->txframetype[ 0 ] == TX_EXTENDED_DATA_FRAME )
-        {
-            /* Longest possible delay for an extended CAN frame of length 'datalength[ 0 ]' and 'baudrate' bps */
-            WAIT_SEND_EXTENDED_DATA_FRAME( txcan->datalength[ 0 ], hcan->baudrate );
-        }
-        /* If frame is standard data frame */
-        else if ( txcan->txframetype[ 0 ] == TX_STANDARD_DATA_FRAME )
-        {
-            /* Longest possible delay for a standard CAN frame of length 'datalength[ 0 ]' and 'baudrate' bps */
-            WAIT_SEND_STANDARD_DATA_FRAME( txcan->datalength[ 0 ], hcan->baudrate );
-        }
-        /* If frame is extended remote frame */
-        else if ( txcan->txframetype[ 0 ] == TX_EXTENDED_REMOTE_FRAME )
-        {
-            /* Longest possible delay for a 'baudrate' bps extended remote CAN frame */
-            WAIT_SEND_EXTENDED_REMOTE_FRAME( hcan->baudrate );
-        }
-        /* If frame is standard remote frame */
-        else
-        {
-            /* Longest possible delay for a 'baudrate' bps standard remote CAN frame */
-            WAIT_SEND_STANDARD_REMOTE_FRAME( hcan->baudrate );
-        }
-    }
+    /* Hold the SPI bus from READ STATUS until the TX buffer found is loaded and requested */
+    SPI_Bus_Lock( hcan->spiport );
+
+    spi_read = CAN_Control_Read_Status( hcan );
 
-    /* If buffer TXB1 is selected for transmission */
-    if ( ( txcan->txbuffernmbr & TXB1 ) == TXB1 )
+    for ( buffer = 0U; ( buffer < 3U ) && ( used == 0U ); buffer++ )
     {
-        /* If CAN frame to be sent is extended (either data or remote frame) */
-        if ( ( txcan->txframetype[ 1 ] == TX_EXTENDED_DATA_FRAME ) || ( txcan->txframetype[ 1 ] == TX_EXTENDED_REMOTE_FRAME ) )
-        {
-            /* Get the TX buffer 1 COMPLETE ID register values */
-            spi_write[ 0 ]  =   txcan->txid[ 1 ] >> 21;           /* TXB1SIDH.SID[10:3]  */
-            spi_write[ 1 ]  = ( txcan->txid[ 1 ] >> 13 ) & 0xE0U; /* TXB1SIDL.SID[2:0]   */
-            spi_write[ 1 ] |= ( txcan->txid[ 1 ] >> 16 ) & 0x03U; /* TXB1SIDL.EID[17:16] */
-            spi_write[ 2 ]  =   txcan->txid[ 1 ] >> 8;            /* TXB1EID8.EID[15:8]  */
-            spi_write[ 3 ]  =   txcan->txid[ 1 ];                 /* TXB1EID0.EID[7:0]   */
-
-            /* Set EXIDE bit in TXB1SIDL register to indicate extended identifier is to be transmitted */
-            spi_write[ 1 ] |= EXIDE_MSG_TRANSMIT_EXTENDED_ID;
-        }
-        /* If CAN frame to be sent is standard (either data or remote frame) */
-        else
+        /* If TXBn is not pending for transmission (TXnREQ bit in the READ STATUS response) */
+        if ( ( spi_read & ( STATUS_TX0REQ << ( buffer << 1 ) ) ) == 0U )
         {
-            /* Get the TX buffer 1 STANDARD ID register values */
-            spi_write[ 0 ] = txcan->txid[ 1 ] >> 3; /* TXB1SIDH.SID[10:3] */
-            spi_write[ 1 ] = txcan->txid[ 1 ] << 5; /* TXB1SIDL.SID[2:0]  */
-            
-            /* NOTE: TXB1SIDL.EID[17:16], TXB1EID8.EID[15:8], TXB1EID0.EID[7:0] and TXB1SIDL.EXIDE bit will be sent as 0s */
-            spi_write[ 2 ] = 0U; /* TXB1EID8.EID[15:8] */
-            spi_write[ 3 ] = 0U; /* TXB1EID0.EID[7:0]  */
+            CAN_Control_Load_TX_Buffer( hcan, buffer, frame );
+            CAN_Control_Register_Write( hcan, can_txbctrl_reg[ buffer ], &spi_write, 1U );
+
+            used = ( uint8_t )( TXB0 << buffer );
         }
+    }
 
-        /* Set number of data bytes to be transmitted/requested (TXB1DLC) in the CAN frame using TX buffer 1 */
-        spi_write[ 4 ] = txcan->datalength[ 1 ]; /* TXB1DLC */
+    SPI_Bus_Unlock( hcan->spiport );
 
-        /* If CAN frame to be sent is remote (either standard or extended frame) */
-        if ( ( txcan->txframetype[ 1 ] == TX_STANDARD_REMOTE_FRAME ) || ( txcan->txframetype[ 1 ] == TX_EXTENDED_REMOTE_FRAME ) )
-        {
-            /* Set RTR bit in TXB1DLC register to indicate a remote request is to be transmitted */
-            spi_write[ 4 ] |= RTR_TRANSMIT_REMOTE_FRAME_REQUEST;
+    return used;
+}
 
-            /* Write to the MCP2515 TX buffer 1 ID and TX buffer 1 data length code registers */
-            CAN_Control_Register_Write( hcan, TXB1SIDH_REG, spi_write, 5U );
+/**
+ * @brief Send an array of CAN frames, keeping TXB0, TXB1 and TXB2 refilled as their transmissions complete
+ *        so that there is always a frame queued behind the one on the bus (no idle gap between frames).
+ * 
+ *        Frames leave the MCP2515 in the order of the array: every frame is loaded one TXP priority level below
+ *        the frames still pending, and when the oldest frame completes the remaining ones are raised one level
+ *        (oldest first, so that their relative order holds at any time). Frames with the same ID are thus
+ *        never reordered, frames with different IDs still compete by ID on the bus against other nodes.
+ * 
+ *        Only the TX buffers that are not pending when the function is called are used. If no transmission
+ *        completes within 'timeout_us' (e.g. no ACK or bus-off), every pending transmission is aborted (ABAT).
+ * 
+ *        Note: the TXP bits of pending TX buffers are modified while they wait for transmission. The SPI bus is held
+ *              through every pass of the polling loop (loads, completion check and priority raises), and released
+ *              between passes so that the interrupt service of the controller is not held off for the whole batch.
+ * 
+ * @param hcan       pointer to an MCP2515 configuration structure (CAN sending node)
+ * @param frames     array of CAN frames to be sent
+ * @param count      number of CAN frames in the array
+ * @param status     array of 'count' elements where the TX state of every frame is stored.
+ *                   Refer to 'MCP2515 CAN frame TX states definitions' in can.h (TX_PENDING = never sent)
+ * @param timeout_us longest time to wait for a transmission to complete, in microseconds
+ * @return uint16_t  number of CAN frames sent successfully
+ */
+uint16_t CAN_Control_Send_CAN_Batch( CAN_Control_HandleTypeDef *hcan, const CAN_Control_Frame *frames, uint16_t count, uint8_t *status, uint32_t timeout_us )
+{
+    uint16_t frame[ 3 ];   /* frame index loaded into each TX buffer         */
+    uint8_t  order[ 3 ];   /* pending TX buffers in load order, oldest first */
+    uint8_t  pending = 0U; /* number of pending TX buffers                   */
+    uint8_t  free    = 0U; /* TX buffers available (TXB0, TXB1 and TXB2 bits) */
+    uint16_t next    = 0U;
+    uint16_t sent    = 0U;
+    uint32_t idle    = 0U;
+    uint8_t  spi_read;
+    uint8_t  spi_write;
+    uint8_t  buffer;
+    uint8_t  i;
+
+    PROFILE_START( PROFILE_SEND_FRAME );
+
+    /* Every frame is reported as not sent until its transmission ends */
+    for ( next = 0U; next < count; next++ )
+    {
+        status[ next ] = TX_PENDING;
+    }
 
-            /* there's no need for writting to the TXB1 data registers (TXB1Dm) since this is a remote frame */
-        }
-        /* If CAN frame to be sent is data (either standard or extended frame) */
-        else
-        {
-            /* Write to the MCP2515 TX buffer 1 ID and TX buffer 1 data length code registers */
-            CAN_Control_Register_Write( hcan, TXB1SIDH_REG, spi_write, 5U );
+    next = 0U;
 
-            /* Write to the MCP2515 TX buffer 1 Data (TXB1Dm) registers */
-            CAN_Control_Register_Write( hcan, TXB1D0_REG, txcan->data[ 1 ], txcan->datalength[ 1 ] );
-        }
+    SPI_Bus_Lock( hcan->spiport );
 
-        /* Request transmission of TX buffer 1 by setting the TXREQ bit in the TXB1CTRL register */
-        spi_write[ 0 ] = TXREQ_PENDING; /* TXB1CTRL */
-        CAN_Control_Register_Write( hcan, TXB1CTRL_REG, spi_write, 1U );
+    /* Use only the TX buffers that are not pending and clear their TXnIF flags */
+    spi_read = CAN_Control_Read_Status( hcan );
 
-        /* Wait for the CAN frame to be sent on the CAN bus ...
-           If frame is extended data frame */
-        if ( txcan->txframetype[ 1 ] == TX_EXTENDED_DATA_FRAME )
-        {
-            /* Longest possible delay for an extended CAN frame of length 'datalength[ 1 ]' and 'baudrate' bps */
-            WAIT_SEND_EXTENDED_DATA_FRAME( txcan->datalength[ 1 ], hcan->baudrate );
-        }
-        /* If frame is standard data frame */
-        else if ( txcan->txframetype[ 1 ] == TX_STANDARD_DATA_FRAME )
-        {
-            /* Longest possible delay for a standard CAN frame of length 'datalength[ 1 ]' and 'baudrate' bps */
-            WAIT_SEND_STANDARD_DATA_FRAME( txcan->datalength[ 1 ], hcan->baudrate );
-        }
-        /* If frame is extended remote frame */
-        else if ( txcan->txframetype[ 1 ] == TX_EXTENDED_REMOTE_FRAME )
-        {
-            /* Longest possible delay for a 'baudrate' bps extended remote CAN frame */
-            WAIT_SEND_EXTENDED_REMOTE_FRAME( hcan->baudrate );
-        }
-        /* If frame is standard remote frame */
-        else
+    for ( buffer = 0U; buffer < 3U; buffer++ )
+    {
+        if ( ( spi_read & ( STATUS_TX0REQ << ( buffer << 1 ) ) ) == 0U )
         {
-            /* Longest possible delay for a 'baudrate' bps standard remote CAN frame */
-            WAIT_SEND_STANDARD_REMOTE_FRAME( hcan->baudrate );
+            free |= ( uint8_t )( TXB0 << buffer );
         }
     }
 
-    /* If buffer TXB2 is selected for transmission */
-    if ( ( txcan->txbuffernmbr & TXB2 ) == TXB2 )
+    CAN_Control_Register_Bit( hcan, CANINTF_REG, ( uint8_t )( free << 2 ), 0U ); /* TXnIF bits are TXBn bits shifted by 2 */
+
+    SPI_Bus_Unlock( hcan->spiport );
+
+    while ( ( next < count ) || ( pending > 0U ) )
     {
-        /* If CAN frame to be sent is extended (either data or remote frame) */
-        if ( ( txcan->txframetype[ 2 ] == TX_EXTENDED_DATA_FRAME ) || ( txcan->txframetype[ 2 ] == TX_EXTENDED_REMOTE_FRAME ) )
+        SPI_Bus_Lock( hcan->spiport );
+
+        /* Load the next frames into the free TX buffers, one priority level below the pending ones */
+        while ( ( next < count ) && ( free != 0U ) )
         {
-            /* Get the TX buffer 2 COMPLETE ID register values */
-            spi_write[ 0 ]  =   txcan->txid[ 2 ] >> 21;           /* TXB2SIDH.SID[10:3]  */
-            spi_write[ 1 ]  = ( txcan->txid[ 2 ] >> 13 ) & 0xE0U; /* TXB2SIDL.SID[2:0]   */
-            spi_write[ 1 ] |= ( txcan->txid[ 2 ] >> 16 ) & 0x03U; /* TXB2SIDL.EID[17:16] */
-            spi_write[ 2 ]  =   txcan->txid[ 2 ] >> 8;            /* TXB2EID8.EID[15:8]  */
-            spi_write[ 3 ]  =   txcan->txid[ 2 ];                 /* TXB2EID0.EID[7:0]   */
-
-            /* Set EXIDE bit in TXB2SIDL register to indicate extended identifier is to be transmitted */
-            spi_write[ 1 ] |= EXIDE_MSG_TRANSMIT_EXTENDED_ID;
+            buffer = ( ( free & TXB0 ) == TXB0 ) ? 0U : ( ( ( free & TXB1 ) == TXB1 ) ? 1U : 2U );
+
+            CAN_Control_Load_TX_Buffer( hcan, buffer, &frames[ next ] );
+
+            /* Request transmission with priority TXP = 3 - pending (TXREQ and TXP bits in TXBnCTRL) */
+            spi_write = TXREQ_PENDING | ( TXP_HIGHEST_PRIORITY - pending );
+            CAN_Control_Register_Write( hcan, can_txbctrl_reg[ buffer ], &spi_write, 1U );
+
+            frame[ buffer ]    = next++;
+            order[ pending++ ] = buffer;
+            free              &= ( uint8_t )~( TXB0 << buffer );
         }
-        /* If CAN frame to be sent is standard (either data or remote frame) */
-        else
+
+        /* Every TX buffer was already in use by other transmissions */
+        if ( pending == 0U )
         {
-            /* Get the TX buffer 2 STANDARD ID register values */
-            spi_write[ 0 ] = txcan->txid[ 2 ] >> 3; /* TXB2SIDH.SID[10:3] */
-            spi_write[ 1 ] = txcan->txid[ 2 ] << 5; /* TXB2SIDL.SID[2:0]  */
-            
-            /* NOTE: TXB2SIDL.EID[17:16], TXB2EID8.EID[15:8], TXB2EID0.EID[7:0] and TXB2SIDL.EXIDE bit will be sent as 0s */
-            spi_write[ 2 ] = 0U; /* TXB2EID8.EID[15:8] */
-            spi_write[ 3 ] = 0U; /* TXB2EID0.EID[7:0]  */
+            SPI_Bus_Unlock( hcan->spiport );
+            break;
         }
 
-        /* Set number of data bytes to be transmitted/requested (TXB2DLC) in the CAN frame using TX buffer 2 */
-        spi_write[ 4 ] = txcan->datalength[ 2 ]; /* TXB2DLC */
+        /* Check whether the oldest pending frame left its TX buffer */
+        buffer   = order[ 0 ];
+        spi_read = CAN_Control_Read_Status( hcan );
 
-        /* If CAN frame to be sent is remote (either standard or extended frame) */
-        if ( ( txcan->txframetype[ 2 ] == TX_STANDARD_REMOTE_FRAME ) || ( txcan->txframetype[ 2 ] == TX_EXTENDED_REMOTE_FRAME ) )
+        if ( ( spi_read & ( STATUS_TX0REQ << ( buffer << 1 ) ) ) == 0U )
         {
-            /* Set RTR bit in TXB2DLC register to indicate a remote request is to be transmitted */
-            spi_write[ 4 ] |= RTR_TRANSMIT_REMOTE_FRAME_REQUEST;
-
-            /* Write to the MCP2515 TX buffer 2 ID and TX buffer 2 data length code registers */
-            CAN_Control_Register_Write( hcan, TXB2SIDH_REG, spi_write, 5U );
+            /* TXnIF set means it was sent successfully */
+            if ( ( spi_read & ( STATUS_TX0IF << ( buffer << 1 ) ) ) != 0U )
+            {
+                status[ frame[ buffer ] ] = TX_SUCCESS;
+                sent++;
 
-            /* there's no need for writting to the TXB2 data registers (TXB2Dm) since this is a remote frame */
-        }
-        /* If CAN frame to be sent is data (either standard or extended frame) */
-        else
-        {
-            /* Write to the MCP2515 TX buffer 2 ID and TX buffer 2 data length code registers */
-            CAN_Control_Register_Write( hcan, TXB2SIDH_REG, spi_write, 5U );
+                /* Account for the frame in the bus-load monitor of the controller, if any */
+                if ( hcan->busload != NULL )
+                {
+                    CAN_Busload_Add_Frame( hcan->busload, BUSLOAD_TX, frames[ frame[ buffer ] ].flags & CAN_FRAME_TYPE_MASK,
+                                           frames[ frame[ buffer ] ].id, frames[ frame[ buffer ] ].dlc, frames[ frame[ buffer ] ].data );
+                }
+                CAN_Control_Register_Bit( hcan, CANINTF_REG, ( uint8_t )( TX0IE_TXB0_EMPTY_INTERRUPT_ENABLED << buffer ), 0U );
+            }
+            else
+            {
+                status[ frame[ buffer ] ] = CAN_Control_TX_CAN_Status( hcan, ( uint8_t )( TXB0 << buffer ) );
+            }
 
-            /* Write to the MCP2515 TX buffer 2 Data (TXB2Dm) registers */
-            CAN_Control_Register_Write( hcan, TXB2D0_REG, txcan->data[ 2 ], txcan->datalength[ 2 ] );
-        }
+            /* Remove it from the pending list and raise the remaining frames one priority level, oldest first */
+            pending--;
 
-        /* Request transmission of TX buffer 2 by setting the TXREQ bit in the TXB2CTRL register */
-        spi_write[ 0 ] = TXREQ_PENDING; /* TXB2CTRL */
-        CAN_Control_Register_Write( hcan, TXB2CTRL_REG, spi_write, 1U );
+            for ( i = 0U; i < pending; i++ )
+            {
+                order[ i ] = order[ i + 1U ];
+                CAN_Control_Register_Bit( hcan, can_txbctrl_reg[ order[ i ] ], TXP_BIT_1 | TXP_BIT_0, TXP_HIGHEST_PRIORITY - i );
+            }
 
-        /* Wait for the CAN frame to be sent on the CAN bus ...
-           If frame is extended data frame */
-        if ( txcan->txframetype[ 2 ] == TX_EXTENDED_DATA_FRAME )
-        {
-            /* Longest possible delay for an extended CAN frame of length 'datalength[ 2 ]' and 'baudrate' bps */
-            WAIT_SEND_EXTENDED_DATA_FRAME( txcan->datalength[ 2 ], hcan->baudrate );
-        }
-        /* If frame is standard data frame */
-        else if ( txcan->txframetype[ 2 ] == TX_STANDARD_DATA_FRAME )
-        {
-            /* Longest possible delay for a standard CAN frame of length 'datalength[ 2 ]' and 'baudrate' bps */
-            WAIT_SEND_STANDARD_DATA_FRAME( txcan->datalength[ 2 ], hcan->baudrate );
+            free |= ( uint8_t )( TXB0 << buffer );
+            idle  = 0U;
         }
-        /* If frame is extended remote frame */
-        else if ( txcan->txframetype[ 2 ] == TX_EXTENDED_REMOTE_FRAME )
+        /* No transmission completed for too long, abort the pending ones */
+        else if ( ( idle += CAN_BATCH_POLL_US ) >= timeout_us )
         {
-            /* Longest possible delay for a 'baudrate' bps extended remote CAN frame */
-            WAIT_SEND_EXTENDED_REMOTE_FRAME( hcan->baudrate );
+            CAN_Control_TX_CAN_Abort_All( hcan );
+
+            for ( i = 0U; i < pending; i++ )
+            {
+                status[ frame[ order[ i ] ] ] = CAN_Control_TX_CAN_Status( hcan, ( uint8_t )( TXB0 << order[ i ] ) );
+            }
+
+            SPI_Bus_Unlock( hcan->spiport );
+            break;
         }
-        /* If frame is standard remote frame */
         else
         {
-            /* Longest possible delay for a 'baudrate' bps standard remote CAN frame */
-            WAIT_SEND_STANDARD_REMOTE_FRAME( hcan->baudrate );
+            /* Do nothing, keep polling */
         }
+
+        SPI_Bus_Unlock( hcan->spiport );
     }
+
+    PROFILE_STOP( PROFILE_SEND_FRAME );
+
+    return sent;
 }
 
 /**
@@ -887,6 +1587,11 @@ void CAN_Control_Read_CAN_Frame( CAN_Control_HandleTypeDef *hcan, CAN_Control_RX
 {
     uint8_t spi_read[ 6 ];
 
+    PROFILE_START( PROFILE_READ_FRAME );
+
+    /* Hold the SPI bus so that both RX buffers are read as they are now */
+    SPI_Bus_Lock( hcan->spiport );
+
     /* If buffer RXB0 is selected for data reading */
     if ( ( rxcan->rxbuffernmbr & RXB0 ) == RXB0 )
     {	
@@ -901,16 +1606,12 @@ void CAN_Control_Read_CAN_Frame( CAN_Control_HandleTypeDef *hcan, CAN_Control_RX
            (keep only the DLC bits of the RXB0DLC register) */
         rxcan->datalength[ 0 ] = spi_read[ 5 ] & ( DLC_BIT_3 | DLC_BIT_2 | DLC_BIT_1 | DLC_BIT_0 );
 
+        /* Store the RXB0 ID (standard or extended, IDE bit in RXB0SIDL) into rxid[ 0 ] */
+        rxcan->rxid[ 0 ] = CAN_Control_ID_Unpack( &spi_read[ 1 ] );
+
         /* If CAN frame received in RXB0 is extended (IDE bit in RXB0SIDL) */
         if ( ( spi_read[ 2 ] & IDE_RECEIVED_EXTENDED_FRAME ) == IDE_RECEIVED_EXTENDED_FRAME )
         {
-            /* Store the RXB0 full ID (standard + extended) into rxid[ 0 ] */
-            rxcan->rxid[ 0 ]  =   spi_read[ 1 ] << 21;                                           /* RXB0SIDH.SID[10:3]  */
-            rxcan->rxid[ 0 ] |= ( spi_read[ 2 ] & ( SID_BIT_2 | SID_BIT_1 | SID_BIT_0 ) ) << 18; /* RXB0SIDL.SID[2:0]   */
-            rxcan->rxid[ 0 ] |= ( spi_read[ 2 ] & ( EID_BIT_17 | EID_BIT_16 ) ) << 16;           /* RXB0SIDL.EID[17:16] */
-            rxcan->rxid[ 0 ] |=   spi_read[ 3 ] << 8;                                            /* RXB0EID8.EID[15:8]  */
-            rxcan->rxid[ 0 ] |=   spi_read[ 4 ];                                                 /* RXB0EID0.EID[7:0]   */
-
             /* If received extended CAN frame is a remote request (RTR bit in RXB0DLC) */
             if ( ( spi_read[ 5 ] & RTR_RECEIVED_REMOTE_FRAME_REQUEST ) == RTR_RECEIVED_REMOTE_FRAME_REQUEST )
             {
@@ -950,10 +1651,6 @@ void CAN_Control_Read_CAN_Frame( CAN_Control_HandleTypeDef *hcan, CAN_Control_RX
         /* If CAN frame received in RXB0 is standard */
         else
         {
-            /* Store the RXB0 standard ID into rxid[ 0 ] */
-            rxcan->rxid[ 0 ]  = spi_read[ 1 ] << 3; /* RXB0SIDH.SID[10:3]  */
-            rxcan->rxid[ 0 ] |= spi_read[ 2 ] >> 5; /* RXB0SIDL.SID[2:0]   */
-
             /* If received standard CAN frame is a remote request (SRR bit in RXB0SIDL) */
             if ( ( spi_read[ 2 ] & SRR_RECEIVED_STANDARD_REMOTE_REQUEST ) == SRR_RECEIVED_STANDARD_REMOTE_REQUEST )
             {
@@ -1004,16 +1701,12 @@ void CAN_Control_Read_CAN_Frame( CAN_Control_HandleTypeDef *hcan, CAN_Control_RX
            (keep only the DLC bits of the RXB1DLC register) */
         rxcan->datalength[ 1 ] = spi_read[ 5 ] & ( DLC_BIT_3 | DLC_BIT_2 | DLC_BIT_1 | DLC_BIT_0 );
 
+        /* Store the RXB1 ID (standard or extended, IDE bit in RXB1SIDL) into rxid[ 1 ] */
+        rxcan->rxid[ 1 ] = CAN_Control_ID_Unpack( &spi_read[ 1 ] );
+
         /* If CAN frame received in RXB1 is extended (IDE bit in RXB1SIDL) */
         if ( ( spi_read[ 2 ] & IDE_RECEIVED_EXTENDED_FRAME ) == IDE_RECEIVED_EXTENDED_FRAME )
         {
-            /* Store the RXB1 full ID (standard + extended) into rxid[ 1 ] */
-            rxcan->rxid[ 1 ]  =   spi_read[ 1 ] << 21;                                           /* RXB1SIDH.SID[10:3]  */
-            rxcan->rxid[ 1 ] |= ( spi_read[ 2 ] & ( SID_BIT_2 | SID_BIT_1 | SID_BIT_0 ) ) << 18; /* RXB1SIDL.SID[2:0]   */
-            rxcan->rxid[ 1 ] |= ( spi_read[ 2 ] & ( EID_BIT_17 | EID_BIT_16 ) ) << 16;           /* RXB1SIDL.EID[17:16] */
-            rxcan->rxid[ 1 ] |=   spi_read[ 3 ] << 8;                                            /* RXB1EID8.EID[15:8]  */
-            rxcan->rxid[ 1 ] |=   spi_read[ 4 ];                                                 /* RXB1EID0.EID[7:0]   */
-
             /* If received extended CAN frame is a remote request (RTR bit in RXB1DLC) */
             if ( ( spi_read[ 5 ] & RTR_RECEIVED_REMOTE_FRAME_REQUEST ) == RTR_RECEIVED_REMOTE_FRAME_REQUEST )
             {
@@ -1037,10 +1730,6 @@ void CAN_Control_Read_CAN_Frame( CAN_Control_HandleTypeDef *hcan, CAN_Control_RX
         /* If CAN frame received in RXB1 is standard */
         else
         {
-            /* Store the RXB1 standard ID into rxid[ 1 ] */
-            rxcan->rxid[ 1 ]  = spi_read[ 1 ] << 3; /* RXB1SIDH.SID[10:3]  */
-            rxcan->rxid[ 1 ] |= spi_read[ 2 ] >> 5; /* RXB1SIDL.SID[2:0]   */
-
             /* If received standard CAN frame is a remote request (SRR bit in RXB1SIDL) */
             if ( ( spi_read[ 2 ] & SRR_RECEIVED_STANDARD_REMOTE_REQUEST ) == SRR_RECEIVED_STANDARD_REMOTE_REQUEST )
             {
@@ -1060,6 +1749,181 @@ void CAN_Control_Read_CAN_Frame( CAN_Control_HandleTypeDef *hcan, CAN_Control_RX
             }
         }
     }
+
+    SPI_Bus_Unlock( hcan->spiport );
+
+    PROFILE_STOP( PROFILE_READ_FRAME );
+}
+
+/**
+ * @brief Read the CAN frame held by the selected RX buffer with a single READ RX BUFFER instruction
+ *        (ID, DLC and only the DLC data bytes are read in one SPI transaction, starting at RXBnSIDH).
+ *        The MCP2515 clears the RXnIF flag of the RX buffer when the transaction ends, releasing it for a new frame.
+ * 
+ *        The frame type and filter match are taken from the RX STATUS response, which refers to RXB0 when both
+ *        RX buffers are full. RXB1 is read with a READ instruction from RXB1CTRL in that case (FILHIT bits, then
+ *        IDE/SRR in RXB1SIDL and RTR in RXB1DLC give the frame type), and its RX1IF flag is cleared afterwards.
+ * 
+ * @param hcan   pointer to an MCP2515 configuration structure (CAN receiving node)
+ * @param buffer RX buffer index (0 = RXB0, 1 = RXB1)
+ * @param status RX STATUS instruction response, it holds the frame type of the received CAN frame
+ * @param frame  pointer to the CAN frame where the received frame is stored
+ */
+static void CAN_Control_Read_RX_Buffer( CAN_Control_HandleTypeDef *hcan, uint8_t buffer, uint8_t status, CAN_Control_Frame *frame )
+{
+    uint8_t instruction[ 2 ] = { READ_RX_BUFFER_RXB0SIDH_INS + ( buffer << 2 ), RXB1CTRL_REG }; /* 0x90 or 0x94 */
+    uint8_t spi_read[ 6 ]    = { 0U };
+    uint8_t *header          = &spi_read[ 1 ]; /* RXBnSIDH, RXBnSIDL, RXBnEID8, RXBnEID0 and RXBnDLC */
+    uint8_t rxb1ctrl         = ( ( buffer == 1U ) && ( ( status & RX_STATUS_MSG_RXB0 ) == RX_STATUS_MSG_RXB0 ) ) ? 1U : 0U;
+    uint8_t msgtype          = ( status & RX_STATUS_MSG_TYPE_MASK ) >> 3;
+    uint8_t filhit           = status & RX_STATUS_FILTER_MATCH_MASK;
+
+    frame->dlc = 0U;
+
+    if ( rxb1ctrl == 1U )
+    {
+        instruction[ 0 ] = READ_INS;
+    }
+    else
+    {
+        /* Do nothing */
+    }
+
+    PROFILE_START( PROFILE_SPI_TRANSACTION );
+
+    CAN_Control_Select( hcan );
+    SPI_Write( hcan->spiport, instruction, 1U + rxb1ctrl ); /* Request READ RX BUFFER (or READ from RXB1CTRL) to the MCP2515 ... */
+    SPI_Read( hcan->spiport, ( rxb1ctrl == 1U ) ? spi_read : header, 5U + rxb1ctrl ); /* ... read back RXBnSIDH to RXBnDLC ... */
+    frame->dlc = header[ 4 ] & ( DLC_BIT_3 | DLC_BIT_2 | DLC_BIT_1 | DLC_BIT_0 );
+    frame->dlc = ( frame->dlc > 8U ) ? 8U : frame->dlc;
+
+    /* The frame type and filter match of RXB1 come from its own registers (IDE and SRR bits in RXB1SIDL for standard
+       frames, RTR bit in RXB1DLC for extended frames, FILHIT bits in RXB1CTRL) */
+    if ( rxb1ctrl == 1U )
+    {
+        msgtype = ( ( header[ 1 ] & IDE_RECEIVED_EXTENDED_FRAME ) == IDE_RECEIVED_EXTENDED_FRAME ) ?
+                  ( ( ( header[ 4 ] & RTR_RECEIVED_REMOTE_FRAME_REQUEST ) == RTR_RECEIVED_REMOTE_FRAME_REQUEST ) ? 0x03U : 0x02U ) :
+                  ( ( ( header[ 1 ] & SRR_RECEIVED_STANDARD_REMOTE_REQUEST ) == SRR_RECEIVED_STANDARD_REMOTE_REQUEST ) ? 0x01U : 0x00U );
+        filhit  = spi_read[ 0 ] & ( FILHIT_BIT_2 | FILHIT_BIT_1 | FILHIT_BIT_0 );
+    }
+    else
+    {
+        /* Do nothing */
+    }
+
+    SPI_Read( hcan->spiport, frame->data, ( ( msgtype & 0x01U ) == 0x01U ) ? 0U : frame->dlc ); /* ... and the data bytes */
+    CAN_Control_Deselect( hcan );
+
+    PROFILE_STOP( PROFILE_SPI_TRANSACTION );
+
+    /* RX STATUS message type: 00 = standard data, 01 = standard remote, 10 = extended data, 11 = extended remote,
+       which maps to the CAN frame flags by swapping both bits. The filter match is kept along with them */
+    frame->flags     = ( uint8_t )( ( ( msgtype & 0x01U ) << 1 ) | ( msgtype >> 1 ) | ( filhit << CAN_FRAME_FILHIT_SHIFT ) );
+    frame->timestamp = ( uint16_t )TIM1_Get_Ticks();
+
+    /* RXBnSIDH, RXBnSIDL, RXBnEID8 and RXBnEID0 hold the CAN ID (standard or extended) */
+    frame->id = CAN_Control_ID_Unpack( header );
+
+    /* Wait 50us for the instruction to be processed by the MCP2515 (time is not specified in datasheet) */
+    TIM3_Delay_us( 50U );
+
+    /* A READ instruction does not release RXB1 for a new frame */
+    if ( rxb1ctrl == 1U )
+    {
+        CAN_Control_Clear_INT_Status( hcan, RX1IE_RXB1_FULL_INTERRUPT_ENABLED );
+    }
+    else
+    {
+        /* Do nothing */
+    }
+}
+
+/**
+ * @brief Read a single CAN frame from the RX buffers if any was received, oldest first. The RX buffer is released
+ *        for a new frame once read.
+ * 
+ *        When both RX buffers are full, RXB0 holds the older frame if it was received first (e.g. rollover to RXB1),
+ *        but once RXB0 is read with RXB1 still full, any new frame in RXB0 is newer than the one waiting in RXB1.
+ *        The driver keeps track of that case (rxb1older in the handle) and reads RXB1 first then.
+ * 
+ *        The SPI bus is held from RX STATUS to the end of the read, so that the interrupt service of the controller
+ *        (refer to CAN_Service_EXTI_IRQ() in can_service.c) can not drain the RX buffers in between.
+ * 
+ * @param hcan     pointer to an MCP2515 configuration structure (CAN receiving node)
+ * @param frame    pointer to the CAN frame where the received frame is stored
+ * @return uint8_t 1 if a CAN frame was read, 0 if both RX buffers are empty
+ */
+uint8_t CAN_Control_Receive_Frame( CAN_Control_HandleTypeDef *hcan, CAN_Control_Frame *frame )
+{
+    uint8_t status;
+    uint8_t received = 1U;
+
+    SPI_Bus_Lock( hcan->spiport );
+
+    status = CAN_Control_RX_Status( hcan );
+
+    /* If RXB0 holds a frame older than the one in RXB1 (if any) */
+    if ( ( ( status & RX_STATUS_MSG_RXB0 ) == RX_STATUS_MSG_RXB0 ) &&
+         ( ( hcan->rxb1older == 0U ) || ( ( status & RX_STATUS_MSG_RXB1 ) == 0U ) ) )
+    {
+        CAN_Control_Read_RX_Buffer( hcan, 0U, status, frame );
+
+        /* The frame left in RXB1 is now older than any frame received in RXB0 from here on */
+        hcan->rxb1older = ( ( status & RX_STATUS_MSG_RXB1 ) == RX_STATUS_MSG_RXB1 ) ? 1U : 0U;
+    }
+    /* If RXB1 holds the oldest frame */
+    else if ( ( status & RX_STATUS_MSG_RXB1 ) == RX_STATUS_MSG_RXB1 )
+    {
+        CAN_Control_Read_RX_Buffer( hcan, 1U, status, frame );
+        hcan->rxb1older = 0U;
+    }
+    /* Both RX buffers are empty */
+    else
+    {
+        hcan->rxb1older = 0U;
+        received        = 0U;
+    }
+
+    /* Account for the frame in the bus-load monitor of the controller, if any */
+    if ( ( received == 1U ) && ( hcan->busload != NULL ) )
+    {
+        CAN_Busload_Add_Frame( hcan->busload, BUSLOAD_RX, frame->flags & CAN_FRAME_TYPE_MASK, frame->id, frame->dlc, frame->data );
+    }
+
+    SPI_Bus_Unlock( hcan->spiport );
+
+    return received;
+}
+
+/**
+ * @brief Copy every CAN frame pending in RXB0 and RXB1 into the 'frames' array, until both RX buffers are empty
+ *        or 'max' frames are stored. Frames that arrive while draining are read in the same call.
+ * 
+ *        Each frame takes 2 SPI transactions: RX STATUS (which buffers are full and the frame type) and
+ *        READ RX BUFFER (ID, DLC and data, which also clears the RXnIF flag). Frames are read oldest first, and an
+ *        RXB1 frame read while RXB0 is full takes a third one to clear RX1IF
+ *        (refer to CAN_Control_Receive_Frame()).
+ * 
+ * @param hcan      pointer to an MCP2515 configuration structure (CAN receiving node)
+ * @param frames    array where the received CAN frames are stored, in reception order
+ * @param max       number of CAN frames the array can hold
+ * @return uint16_t number of CAN frames stored in the array
+ */
+uint16_t CAN_Control_Receive_CAN_Batch( CAN_Control_HandleTypeDef *hcan, CAN_Control_Frame *frames, uint16_t max )
+{
+    uint16_t count = 0U;
+
+    PROFILE_START( PROFILE_READ_FRAME );
+
+    /* Read frames until both RX buffers are empty or the array is full */
+    while ( ( count < max ) && ( CAN_Control_Receive_Frame( hcan, &frames[ count ] ) == 1U ) )
+    {
+        count++;
+    }
+
+    PROFILE_STOP( PROFILE_READ_FRAME );
+
+    return count;
 }
 
 /**
@@ -1199,11 +2063,15 @@ void CAN_Control_TX_CAN_Abort( CAN_Control_HandleTypeDef *hcan, uint8_t tx_buffe
  */
 void CAN_Control_TX_CAN_Abort_All( CAN_Control_HandleTypeDef *hcan )
 {
+    SPI_Bus_Lock( hcan->spiport );
+
     /* Set abort all pending transmissions bit (ABAT) in CANCTRL register */
     CAN_Control_Register_Bit( hcan, CANCTRL_REG, ABAT_REQ_ABORT_TX, ABAT_REQ_ABORT_TX );
 
     /* Clear ABAT bit in order to allow new CAN frame transmissions. */
     CAN_Control_Register_Bit( hcan, CANCTRL_REG, ABAT_REQ_ABORT_TX, ABAT_TERMINATE_REQ_ABORT_TX );
+
+    SPI_Bus_Unlock( hcan->spiport );
 }
 
 /**
@@ -1243,6 +2111,62 @@ uint8_t CAN_Control_INT_Status( CAN_Control_HandleTypeDef *hcan )
     return spi_read;
 }
 
+/**
+ * @brief Return the quick status of the MCP2515 specified by CAN_Control_HandleTypeDef through the READ STATUS instruction:
+ *        the TXREQ and TXnIF bits of the 3 TX buffers and the RXnIF bits of the 2 RX buffers in a single SPI transaction.
+ * 
+ * @param hcan     pointer to an MCP2515 configuration structure (CAN node to read status from)
+ * @return uint8_t READ STATUS response. Refer to 'MCP2515 bit definitions for the READ STATUS instruction response' in can.h
+ */
+uint8_t CAN_Control_Read_Status( CAN_Control_HandleTypeDef *hcan )
+{
+    uint8_t instruction = READ_STATUS_INS;
+    uint8_t spi_read    = 0U;
+
+    PROFILE_START( PROFILE_SPI_TRANSACTION );
+
+    CAN_Control_Select( hcan );
+    SPI_Write( hcan->spiport, &instruction, 1U ); /* Request READ STATUS to the CAN controller (MCP2515) ... */
+    SPI_Read( hcan->spiport, &spi_read, 1U );     /* ... and read back the status byte */
+    CAN_Control_Deselect( hcan );
+
+    PROFILE_STOP( PROFILE_SPI_TRANSACTION );
+
+    /* Wait 50us for the instruction to be processed by the MCP2515 (time is not specified in datasheet) */
+    TIM3_Delay_us( 50U );
+
+    return spi_read;
+}
+
+/**
+ * @brief Return the RX status of the MCP2515 specified by CAN_Control_HandleTypeDef through the RX STATUS instruction:
+ *        which RX buffers hold a frame, the frame type and the filter match in a single SPI transaction.
+ * 
+ *        Note: when both RX buffers hold a frame, the frame type and filter match refer to RXB0.
+ * 
+ * @param hcan     pointer to an MCP2515 configuration structure (CAN node to read status from)
+ * @return uint8_t RX STATUS response. Refer to 'MCP2515 bit definitions for the RX STATUS instruction response' in can.h
+ */
+uint8_t CAN_Control_RX_Status( CAN_Control_HandleTypeDef *hcan )
+{
+    uint8_t instruction = RX_STATUS_INS;
+    uint8_t spi_read    = 0U;
+
+    PROFILE_START( PROFILE_SPI_TRANSACTION );
+
+    CAN_Control_Select( hcan );
+    SPI_Write( hcan->spiport, &instruction, 1U ); /* Request RX STATUS to the CAN controller (MCP2515) ... */
+    SPI_Read( hcan->spiport, &spi_read, 1U );     /* ... and read back the status byte */
+    CAN_Control_Deselect( hcan );
+
+    PROFILE_STOP( PROFILE_SPI_TRANSACTION );
+
+    /* Wait 50us for the instruction to be processed by the MCP2515 (time is not specified in datasheet) */
+    TIM3_Delay_us( 50U );
+
+    return spi_read;
+}
+
 /**
  * @brief Clear the flags for the selected pending interrupts in the CANINTF register.
  *        Unselected flags remain untouched in CANINTF.
@@ -1318,3 +2242,68 @@ void CAN_Control_Clear_ERR_Status( CAN_Control_HandleTypeDef *hcan, uint8_t erro
     /* Clear the selected error flags in the EFLG register */
     CAN_Control_Register_Bit( hcan, EFLG_REG, errors, 0U );
 }
+
+/**
+ * @brief Put the MCP2515 into sleep mode with the wake-up interrupt enabled, so that activity on the CAN bus
+ *        wakes the device up and drives its INT pin LOW.
+ * 
+ *        If the wake-up filter is not enabled in the CAN_Control_HandleTypeDef, it is enabled here (WAKFIL bit in CNF3)
+ *        to prevent short glitches on the CAN bus from waking the device up. This requires a pass through configuration mode.
+ * 
+ *        Note: the MCP2515 only enters sleep mode once any pending transmission completes. The wake-up interrupt
+ *              (WAKIE) is enabled without modifying any other interrupt enabled in CANINTE.
+ * 
+ * @param hcan pointer to an MCP2515 configuration structure (CAN node to be put to sleep)
+ */
+void CAN_Control_Sleep( CAN_Control_HandleTypeDef *hcan )
+{
+    SPI_Bus_Lock( hcan->spiport );
+
+    /* If the wake-up filter is not enabled yet */
+    if ( hcan->wakeupfilter != WAKE_UP_FILTER_ENABLED )
+    {
+        /* CNF3 is only modifiable in configuration mode */
+        CAN_Control_Set_Op_Mode_Wait( hcan, CONFIGURATION_OP_MODE, CAN_OPMODE_TIMEOUT_US );
+
+        /* Enable the wake-up filter (WAKFIL bit in CNF3) */
+        CAN_Control_Register_Bit( hcan, CNF3_REG, WAKFIL_ENABLED, WAKFIL_ENABLED );
+        hcan->wakeupfilter = WAKE_UP_FILTER_ENABLED;
+    }
+
+    /* Clear any stale wake-up interrupt flag and enable the wake-up interrupt (WAKIF and WAKIE bits in CANINTF and CANINTE) */
+    CAN_Control_Register_Bit( hcan, CANINTF_REG, WAKIE_WAKEUP_INTERRUPT_ENABLED, 0U );
+    CAN_Control_Register_Bit( hcan, CANINTE_REG, WAKIE_WAKEUP_INTERRUPT_ENABLED, WAKIE_WAKEUP_INTERRUPT_ENABLED );
+
+    /* Request sleep operation mode */
+    CAN_Control_Set_Op_Mode( hcan, SLEEP_OP_MODE );
+
+    SPI_Bus_Unlock( hcan->spiport );
+}
+
+/**
+ * @brief Bring the MCP2515 back from sleep mode to the operation mode defined in the CAN_Control_HandleTypeDef.
+ * 
+ *        After a wake-up caused by bus activity the MCP2515 runs in listen-only mode, where it already receives frames.
+ *        This function does not go through configuration mode nor clears the RX buffers or their interrupt flags,
+ *        so any frame received since the wake-up is kept for the application to read.
+ * 
+ *        Note: the frame that wakes the MCP2515 up is not received, since the oscillator is still starting up
+ *              while it is on the bus (refer to datasheet).
+ * 
+ * @param hcan pointer to an MCP2515 configuration structure (CAN node to be woken up)
+ */
+void CAN_Control_Wake_Up( CAN_Control_HandleTypeDef *hcan )
+{
+    SPI_Bus_Lock( hcan->spiport );
+
+    /* The wake-up moves REQOP to listen-only mode by itself, CANCTRL is no longer known */
+    hcan->shadowvalid[ CANCTRL_REG >> 5 ] &= ~( 1UL << ( CANCTRL_REG & 0x1FU ) );
+
+    /* Clear the wake-up interrupt flag (WAKIF bit in CANINTF) */
+    CAN_Control_Register_Bit( hcan, CANINTF_REG, WAKIE_WAKEUP_INTERRUPT_ENABLED, 0U );
+
+    /* Return to the operation mode selected by user */
+    CAN_Control_Set_Op_Mode( hcan, hcan->opmode );
+
+    SPI_Bus_Unlock( hcan->spiport );
+}
@@ -16,29 +16,39 @@
 #define CAN_H
 
     #include <stdint.h>
+    #include <stddef.h>
     #include "stm32f0xx.h"
     #include "spi.h"
     #include "timer.h"
+    #include "profile.h"
 
     /* External crystal oscillator frequency on the MCP2515 */
     #define OSC1_FREQ                                   (8000000U)
 
-    /* Nucleo Board's SPI peripheral to be used for handling the CAN controller */
+    /* Nucleo Board's SPI peripheral to be used for handling the CAN controller (default wiring, refer to spi.c) */
     #define CAN_SPI1                                    (0x00U)
     #define CAN_SPI2                                    (0x01U)
 
+    /* Macro to check whether the INT pin (active LOW) of a CAN controller is asserted, always true when it is not wired */
+    #define CAN_INT_ASSERTED( hcan ) \
+        ( ( (hcan)->intport == NULL ) || ( ( (hcan)->intport->IDR & (hcan)->intpin ) == 0U ) )
+
     /* Macro to compute the OST (Oscillator Start-Up Timer = 128 x OSC1 clock cycles) for the MCP2515 in microseconds */
     #define GET_OST( osc_freq )                        (128000000UL / osc_freq)
 
+    /* Macro to compute the frequency in Hz of the MCP2515 CLKOUT pin for the given 'CLKOUT pin definitions' value */
+    #define GET_CLKOUT_FREQ( osc_freq, clkout )         ( (osc_freq) >> ( (clkout) & CLKPRE_MASK ) )
+
     /* Macros to compute the necessary delays for the different CAN frames to be sent. d = number of data bytes, b = CAN baud rate.
        For a standard  data   CAN frame, largest number of bits (after stuffing) = 8n + 44 + floor((34 + 8n - 1) / 4).
        For an extended data   CAN frame, largest number of bits (after stuffing) = 8n + 64 + floor((54 + 8n - 1) / 4).
        For a standard  remote CAN frame, largest number of bits (after stuffing) = 50.
-       For an extended remote CAN frame, largest number of bits (after stuffing) = 73 */
-    #define WAIT_SEND_STANDARD_DATA_FRAME( d, b )       TIM3_Delay_us( ( 8UL * d + 44UL + ( ( 33UL + 8UL * d ) / 4UL ) ) * ( 1000000UL / b ) )
-    #define WAIT_SEND_EXTENDED_DATA_FRAME( d, b )       TIM3_Delay_us( ( 8UL * d + 64UL + ( ( 53UL + 8UL * d ) / 4UL ) ) * ( 1000000UL / b ) )
-    #define WAIT_SEND_STANDARD_REMOTE_FRAME( b )        TIM3_Delay_us( 50UL * ( 1000000UL / b ) )
-    #define WAIT_SEND_EXTENDED_REMOTE_FRAME( b )        TIM3_Delay_us( 73UL * ( 1000000UL / b ) )
+       For an extended remote CAN frame, largest number of bits (after stuffing) = 73.
+       Delays are rounded up to the next microsecond. Refer to CAN_Timing_Frame_Bits() in can_timing.c for the exact length of a given frame */
+    #define WAIT_SEND_STANDARD_DATA_FRAME( d, b )       TIM3_Delay_us( ( ( 8UL * d + 44UL + ( ( 33UL + 8UL * d ) / 4UL ) ) * 1000000UL + b - 1UL ) / b )
+    #define WAIT_SEND_EXTENDED_DATA_FRAME( d, b )       TIM3_Delay_us( ( ( 8UL * d + 64UL + ( ( 53UL + 8UL * d ) / 4UL ) ) * 1000000UL + b - 1UL ) / b )
+    #define WAIT_SEND_STANDARD_REMOTE_FRAME( b )        TIM3_Delay_us( ( 50UL * 1000000UL + b - 1UL ) / b )
+    #define WAIT_SEND_EXTENDED_REMOTE_FRAME( b )        TIM3_Delay_us( ( 73UL * 1000000UL + b - 1UL ) / b )
 
     /* MCP2515 instruction definitions */
     #define RESET_INS                                   (0xC0U)
@@ -65,15 +75,37 @@
     #define RX_STATUS_INS                               (0xB0U)
     #define BIT_MODIFY_INS                              (0x05U)
 
-    /* MCP2515 baud rates definitions */
-    /* #define CAN_BAUD_1_MBPS                          (1000000U), Even though the MCP2515 supports it, sampling time falls outside the
-                                                                    60-70% of the bit due to the 8MHz external oscillator on the CAN module */
+    /* MCP2515 baud rates definitions (1Mbps and 800Kbps are only defined when OSC1_FREQ can achieve them,
+       so selecting them with a slower oscillator is a compile error) */
+    #if ( OSC1_FREQ >= 16000000U )
+        #define CAN_BAUD_1_MBPS                         (1000000U)
+        #define CAN_BAUD_800_KBPS                       (800000U)
+    #endif
     #define CAN_BAUD_500_KBPS                           (500000U)
     #define CAN_BAUD_250_KBPS                           (250000U)
     #define CAN_BAUD_125_KBPS                           (125000U)
     #define CAN_BAUD_100_KBPS                           (100000U)
     #define CAN_BAUD_50_KBPS                            (50000U)
 
+    /* Baud rates supported by CAN_Control_Set_Baud_Rate(). Their bit timings are computed from OSC1_FREQ at build time
+       (refer to CAN_TIMING_CNFn() in can_timing.h), a baud rate that cannot be achieved is a compile error.
+       1Mbps and 800Kbps need at least a 16MHz oscillator (an 8MHz oscillator gives only 4 and 5 TQ per bit respectively) */
+    #if ( OSC1_FREQ >= 16000000U )
+        #define CAN_BAUD_RATE_LIST( X )                 X( CAN_BAUD_1_MBPS )   \
+                                                        X( CAN_BAUD_800_KBPS ) \
+                                                        X( CAN_BAUD_500_KBPS ) \
+                                                        X( CAN_BAUD_250_KBPS ) \
+                                                        X( CAN_BAUD_125_KBPS ) \
+                                                        X( CAN_BAUD_100_KBPS ) \
+                                                        X( CAN_BAUD_50_KBPS )
+    #else
+        #define CAN_BAUD_RATE_LIST( X )                 X( CAN_BAUD_500_KBPS ) \
+                                                        X( CAN_BAUD_250_KBPS ) \
+                                                        X( CAN_BAUD_125_KBPS ) \
+                                                        X( CAN_BAUD_100_KBPS ) \
+                                                        X( CAN_BAUD_50_KBPS )
+    #endif
+
     /* MCP2515 operation mode definitions */
     #define NORMAL_OP_MODE                              (0x00U)
     #define SLEEP_OP_MODE                               (0x01U)
@@ -103,6 +135,13 @@
     #define WAKE_UP_FILTER_DISABLED                     WAKFIL_DISABLED
     #define WAKE_UP_FILTER_ENABLED                      WAKFIL_ENABLED
 
+    /* MCP2515 CLKOUT pin definitions */
+    #define CLKOUT_DISABLED                             CLKEN_CLKOUT_PIN_DISABLED
+    #define CLKOUT_SYSTEMCLK_NO_DIV                     ( CLKEN_CLKOUT_PIN_ENABLED | CLKPRE_SYSTEMCLK_NO_DIV )
+    #define CLKOUT_SYSTEMCLK_DIV_2                      ( CLKEN_CLKOUT_PIN_ENABLED | CLKPRE_SYSTEMCLK_DIV_2 )
+    #define CLKOUT_SYSTEMCLK_DIV_4                      ( CLKEN_CLKOUT_PIN_ENABLED | CLKPRE_SYSTEMCLK_DIV_4 )
+    #define CLKOUT_SYSTEMCLK_DIV_8                      ( CLKEN_CLKOUT_PIN_ENABLED | CLKPRE_SYSTEMCLK_DIV_8 )
+
     /* MCP2515 TX buffer number definitions */
     #define TXB0                                        (0x01U)
     #define TXB1                                        (0x02U)
@@ -154,6 +193,14 @@
     #define RXF5_EXTENDED_ID_ENABLED                    (0x20U)
     #define RXF5_EXTENDED_ID_DISABLED                   (0x00U)
 
+    /* CAN frame flag definitions (the 2 LSBs match the 'TX/RX buffer frame type definitions') */
+    #define CAN_FRAME_EXTENDED                          (0x01U)
+    #define CAN_FRAME_REMOTE                            (0x02U)
+    #define CAN_FRAME_TYPE_MASK                         (0x03U)
+    #define CAN_FRAME_FILHIT_MASK                       (0x70U) /* RX frames: RX STATUS filter match (0 to 5 = RXF0 to RXF5,
+                                                                   6 and 7 = RXF0 and RXF1 with rollover to RXB1)          */
+    #define CAN_FRAME_FILHIT_SHIFT                      (4U)
+
     /* MCP2515 CAN frame TX states definitions */
     #define TX_PENDING                                  (0x00U)
     #define TX_LOST_ARBITRATION                         (0x01U)
@@ -162,6 +209,20 @@
     #define TX_ABORTED                                  (0x04U)
     #define TX_SUCCESS                                  (0x05U)
 
+    /* Time in microseconds taken by one status poll of the batch send (refer to the delay after every SPI transaction) */
+    #define CAN_BATCH_POLL_US                           (50U)
+
+    /* Verified operation mode change results */
+    #define OPMODE_TIMEOUT                              (0x00U)
+    #define OPMODE_CHANGED                              (0x01U)
+
+    /* Time in microseconds taken by one CANSTAT poll while waiting for an operation mode change */
+    #define CAN_OPMODE_POLL_US                          (50U)
+
+    /* Default operation mode change deadline: the MCP2515 finishes the frame on the bus first
+       (the longest stuffed extended frame, 160 bits, takes 3.2ms at 50kbps) */
+    #define CAN_OPMODE_TIMEOUT_US                       (10000U)
+
     /* MCP2515 register addresses definitions */
     #define RXF0SIDH_REG                                (0x00U)
     #define RXF0SIDL_REG                                (0x01U)
@@ -457,6 +518,24 @@
     #define CLKPRE_SYSTEMCLK_DIV_4                      (0x02U)
     #define CLKPRE_SYSTEMCLK_DIV_2                      (0x01U)
     #define CLKPRE_SYSTEMCLK_NO_DIV                     (0x00U)
+    #define CLKPRE_MASK                                 (0x03U)
+
+    /* MCP2515 bit definitions for CANSTAT register */
+    #define OPMOD_CONFIGURATION_MODE                    (0x80U)
+    #define OPMOD_LISTEN_MODE                           (0x60U)
+    #define OPMOD_LOOPBACK_MODE                         (0x40U)
+    #define OPMOD_SLEEP_MODE                            (0x20U)
+    #define OPMOD_NORMAL_MODE                           (0x00U)
+    #define OPMOD_MASK                                  (0xE0U)
+    #define ICOD_NO_INTERRUPT                           (0x00U)
+    #define ICOD_ERROR_INTERRUPT                        (0x02U)
+    #define ICOD_WAKEUP_INTERRUPT                       (0x04U)
+    #define ICOD_TXB0_INTERRUPT                         (0x06U)
+    #define ICOD_TXB1_INTERRUPT                         (0x08U)
+    #define ICOD_TXB2_INTERRUPT                         (0x0AU)
+    #define ICOD_RXB0_INTERRUPT                         (0x0CU)
+    #define ICOD_RXB1_INTERRUPT                         (0x0EU)
+    #define ICOD_MASK                                   (0x0EU)
 
     /* MCP2515 bit definitions for TEC register */
     #define TEC_BIT_7                                   (0x80U)
@@ -556,6 +635,22 @@
     #define RX0IE_RXB0_FULL_INTERRUPT_ENABLED           (0x01U)
     #define RX0IE_RXB0_FULL_INTERRUPT_DISABLED          (0x00U)
 
+    /* MCP2515 bit definitions for the READ STATUS instruction response */
+    #define STATUS_TX2IF                                (0x80U)
+    #define STATUS_TX2REQ                               (0x40U)
+    #define STATUS_TX1IF                                (0x20U)
+    #define STATUS_TX1REQ                               (0x10U)
+    #define STATUS_TX0IF                                (0x08U)
+    #define STATUS_TX0REQ                               (0x04U)
+    #define STATUS_RX1IF                                (0x02U)
+    #define STATUS_RX0IF                                (0x01U)
+
+    /* MCP2515 bit definitions for the RX STATUS instruction response */
+    #define RX_STATUS_MSG_RXB1                          (0x80U)
+    #define RX_STATUS_MSG_RXB0                          (0x40U)
+    #define RX_STATUS_MSG_TYPE_MASK                     (0x18U)
+    #define RX_STATUS_FILTER_MATCH_MASK                 (0x07U)
+
     /* MCP2515 bit definitions for EFLG register */
     #define RX1OVR_RXB1_OVERFLOW                        (0x80U)
     #define RX1OVR_RXB1_NO_OVERFLOW                     (0x00U)
@@ -609,6 +704,17 @@
                                       - Only the 11 LSBs are used if the frame is STANDARD, remaining 21 MSBs are ignored              */
     } CAN_Control_TX;
     
+    /* Structure that holds a single CAN frame, 16 bytes long and 16-byte aligned so that it is copied as 4 words
+       (e.g. by structure assignment) and packs without padding into arrays, queues and pools */
+    typedef struct __ALIGNED( 16 )
+    {
+        uint32_t id;               /* CAN ID (29 LSBs if the frame is EXTENDED, 11 LSBs if it is STANDARD)              */
+        uint8_t  flags;            /* Frame flags (refer to 'CAN frame flag definitions')                               */
+        uint8_t  dlc;              /* Data length code (DLC), 0 to 8                                                    */
+        uint16_t timestamp;        /* TIM1 ticks (16 LSBs) when the frame was read from the RX buffer, 0 for TX frames */
+        uint8_t  data[ 8 ];        /* Data bytes (not used by remote frames)                                            */
+    } CAN_Control_Frame;
+
     /* Structure that holds the configuration parameters and data for receiving buffers RXB0 and RXB1 */
     typedef struct
     {	
@@ -624,40 +730,158 @@
         uint32_t rxid[ 2 ];        /* Receiving frame CAN ID for RXB0 and RXB1 (used in conjunction with rxframetype)                         */
     } CAN_Control_RX;
 
+    /* Shadow register cache definitions: configuration registers 0x00 to 0x2F (by address), RXB0CTRL and RXB1CTRL */
+    #define CAN_SHADOW_SIZE                             (0x32U)
+    #define CAN_SHADOW_RXB0CTRL                         (0x30U)
+    #define CAN_SHADOW_RXB1CTRL                         (0x31U)
+    #define CAN_SHADOW_NONE                             (0xFFU)
+
+    /* MCP2515 register image definitions: registers 0x00 (RXF0SIDH) to 0x2B (CANINTE) written in a single burst */
+    #define CAN_IMAGE_SIZE                              (0x2CU)
+
+    /* MCP2515 register image initialization results */
+    #define IMAGE_OK                                    (0x00U)
+    #define IMAGE_VERIFY_ERROR                          (0x01U)
+    #define IMAGE_OPMODE_TIMEOUT                        (0x02U)
+    #define IMAGE_RESUMED                               (0x03U) /* Warm start: MCP2515 already running with the image */
+
+    /* Number of MCP2515s whose last applied register image is remembered across STM32F070RB resets (.noinit RAM,
+       refer to CAN_Control_Warm_Start()) */
+    #ifndef CAN_WARM_START_NODES
+        #define CAN_WARM_START_NODES                    (2U)
+    #endif
+
+    /* Structure that holds a complete MCP2515 configuration as register values (refer to CAN_Control_Build_Image()) */
+    typedef struct
+    {
+        uint8_t regs[ CAN_IMAGE_SIZE ]; /* Registers 0x00 to 0x2B by address: filters, BFPCTRL, TXRTSCTRL, masks, CNF3, CNF2, CNF1 and CANINTE.
+                                           CANCTRL (0x0F) and its mirror (0x1F) request configuration mode, read-only registers are ignored */
+        uint8_t rxbctrl[ 2 ];           /* RXB0CTRL and RXB1CTRL registers                                                                  */
+        uint8_t canctrl;                /* CANCTRL register: operation mode to enter, one-shot mode and CLKOUT pin                          */
+    } CAN_Control_Image;
+
+    /* Bus-load monitor fed by the driver (refer to can_busload.h) */
+    struct CAN_Busload_Monitor;
+
     /* Structure that holds the main configuration parameters for the CAN Controller (MCP2515) */
     typedef struct
     {   
         uint8_t                spi;                /* Nucleo Board's SPI peripheral to handle the MCP2515 CAN Controller
-                                                      (refer to 'Nucleo Board's SPI peripheral to be used for handling the CAN controller' */
+                                                      (refer to 'Nucleo Board's SPI peripheral to be used for handling the CAN controller',
+                                                      only used to pick the default bus and CS pin when 'spiport' is NULL)    */
+        SPI_TypeDef           *spiport;            /* SPI bus of the CAN Controller (SPI1 or SPI2, shared by any number of controllers) */
+        GPIO_TypeDef          *csport;             /* GPIO port of the CAN Controller CS pin                                 */
+        GPIO_TypeDef          *intport;            /* GPIO port of the CAN Controller INT pin, NULL if it is not wired       */
+        uint16_t               cspin;              /* CS pin mask (GPIO_ODR_0 to GPIO_ODR_15)                                */
+        uint16_t               intpin;             /* INT pin mask (GPIO_IDR_0 to GPIO_IDR_15)                               */
         uint8_t                opmode;             /* CAN Controller operation mode (refer to 'MCP2515 operation mode definitions')        */
         uint8_t                oneshot;            /* CAN Controller one-shot mode (refer to 'one-shot mode definitions')                  */
         uint8_t                samplepoint;        /* CAN Controller sampling point (refer to 'sample point definitions')                  */
         uint8_t                wakeupfilter;       /* CAN Controller wake-up filter mode (refer to 'wake-up filter definitions')           */
         uint8_t                rxbufferopmode;     /* RX buffer/s operation mode (refer to 'RX buffer operation mode definitions')         */
         uint8_t                rxbuffer0rollover;  /* RX buffer 0 rollover configuration (refer to 'RXB0 rollover definitions')            */
+        uint8_t                clkout;             /* CLKOUT pin configuration (refer to 'CLKOUT pin definitions')                         */
+        uint8_t                rxb1older;          /* 1 when RXB1 holds the oldest received frame (managed by the driver)                  */
+        uint8_t                configmode;         /* 1 while CANSTAT is known to report configuration mode (managed by the driver)        */
         uint32_t               baudrate;           /* CAN controller baud rate (refer to 'MCP2515 baud rates')                             */
+        uint32_t               opmodetime;         /* Time taken by the last verified operation mode change, in microseconds            */
+        uint32_t               opmodetimemax;      /* Longest verified operation mode change, in microseconds                          */
+        uint32_t               opmodetimeouts;     /* Verified operation mode changes that missed their deadline                       */
+        struct CAN_Busload_Monitor *busload;       /* Bus-load monitor fed with the frames sent and received, NULL if none
+                                                      (refer to can_busload.h)                                                 */
+        uint32_t               shadowvalid[ 2 ];   /* Shadow register cache: 1 bit per 'shadow' entry, set when the entry holds the
+                                                      register value (all clear until CAN_Control_Reset(), managed by the driver) */
+        uint8_t                shadow[ CAN_SHADOW_SIZE ]; /* Shadow register cache (refer to 'shadow register cache definitions') */
     } CAN_Control_HandleTypeDef;
 
+    /* Convert an 11-bit standard ID into the 29-bit SID:EID register layout (branch-free, no shift for extended IDs) */
+    #define CAN_ID_LAYOUT_SHIFT( extended )             ( 18U & ( ( uint32_t )( extended ) - 1U ) )
+
+    /**
+     * @brief Pack a 29-bit SID[10:0]:EID[17:0] value into the SIDH, SIDL, EID8 and EID0 register values
+     *        (mask, filter and TX buffer registers share this layout). The EXIDE bit is left cleared.
+     * 
+     * @param value 29-bit register layout value (the SID occupies bits 28 to 18)
+     * @param reg   array of 4 bytes: SIDH, SIDL, EID8 and EID0
+     */
+    __STATIC_FORCEINLINE void CAN_Control_ID_Pack_Raw( uint32_t value, uint8_t *reg )
+    {
+        reg[ 0 ] = ( uint8_t )( value >> 21 );                                                /* SIDH.SID[10:3]  */
+        reg[ 1 ] = ( uint8_t )( ( ( value >> 13 ) & 0xE0U ) | ( ( value >> 16 ) & 0x03U ) ); /* SIDL.SID[2:0] and SIDL.EID[17:16] */
+        reg[ 2 ] = ( uint8_t )( value >> 8 );                                                 /* EID8.EID[15:8]  */
+        reg[ 3 ] = ( uint8_t )value;                                                          /* EID0.EID[7:0]   */
+    }
+
+    /**
+     * @brief Pack a standard or extended CAN ID into the SIDH, SIDL, EID8 and EID0 TX buffer register values,
+     *        setting the EXIDE bit for extended IDs. EID8 and EID0 are zero for standard IDs.
+     * 
+     * @param id       CAN ID (11 or 29 LSBs)
+     * @param extended 1 if the ID is extended, 0 if it is standard
+     * @param reg      array of 4 bytes: SIDH, SIDL, EID8 and EID0
+     */
+    __STATIC_FORCEINLINE void CAN_Control_ID_Pack( uint32_t id, uint8_t extended, uint8_t *reg )
+    {
+        uint32_t value = ( extended != 0U ) ? id : ( id << 18 );                              /* SID:EID layout  */
+
+        /* Same as CAN_Control_ID_Pack_Raw(), with EXIDE set in SIDL while it is built (not read back from 'reg') */
+        reg[ 0 ] = ( uint8_t )( value >> 21 );                                                /* SIDH.SID[10:3]  */
+        reg[ 1 ] = ( uint8_t )( ( ( value >> 13 ) & 0xE0U ) | ( extended << 3 ) |             /* SIDL.SID[2:0], EXIDE */
+                                ( ( value >> 16 ) & 0x03U ) );                                /* SIDL.EID[17:16] */
+        reg[ 2 ] = ( uint8_t )( value >> 8 );                                                 /* EID8.EID[15:8]  */
+        reg[ 3 ] = ( uint8_t )value;                                                          /* EID0.EID[7:0]   */
+    }
+
+    /**
+     * @brief Unpack the CAN ID held by the SIDH, SIDL, EID8 and EID0 RX buffer register values
+     *        (the IDE bit in SIDL tells whether it is a standard or an extended ID).
+     * 
+     * @param reg       array of 4 bytes: SIDH, SIDL, EID8 and EID0
+     * @return uint32_t CAN ID (11 or 29 LSBs)
+     */
+    __STATIC_FORCEINLINE uint32_t CAN_Control_ID_Unpack( const uint8_t *reg )
+    {
+        uint32_t sid = ( ( uint32_t )reg[ 0 ] << 3 ) | ( ( uint32_t )reg[ 1 ] >> 5 );         /* SIDH.SID[10:3], SIDL.SID[2:0] */
+        uint32_t eid = ( sid << 18 ) |
+                       ( ( uint32_t )( reg[ 1 ] & 0x03U ) << 16 ) |                           /* SIDL.EID[17:16] */
+                       ( ( uint32_t )reg[ 2 ] << 8 ) |                                        /* EID8.EID[15:8]  */
+                         ( uint32_t )reg[ 3 ];                                                /* EID0.EID[7:0]   */
+
+        return ( ( reg[ 1 ] & IDE_RECEIVED_EXTENDED_FRAME ) != 0U ) ? eid : sid;
+    }
+
     /* MCP2515 initialization and reset functions */
     void CAN_Control_Init( CAN_Control_HandleTypeDef *hcan );
     void CAN_Control_Reset( CAN_Control_HandleTypeDef *hcan );
+    void CAN_Control_Init_Pins( CAN_Control_HandleTypeDef *hcan );
+    uint8_t CAN_Control_Build_Image( const CAN_Control_HandleTypeDef *hcan, const CAN_Control_RX_Mask *hmask, const CAN_Control_RX_Filter *hfilter,
+                                     uint8_t interrupts, CAN_Control_Image *image );
+    uint8_t CAN_Control_Init_Image( CAN_Control_HandleTypeDef *hcan, const CAN_Control_Image *image );
+    uint8_t CAN_Control_Warm_Start( CAN_Control_HandleTypeDef *hcan, const CAN_Control_Image *image );
 
     /* MCP2515 operation mode and baud rate configuration functions */
     void CAN_Control_Set_Op_Mode( CAN_Control_HandleTypeDef *hcan, uint8_t opmode );
-    void CAN_Control_Set_Baud_Rate( CAN_Control_HandleTypeDef *hcan, uint32_t baudrate );
+    uint8_t CAN_Control_Wait_Op_Mode( CAN_Control_HandleTypeDef *hcan, uint8_t opmode, uint32_t timeout_us );
+    uint8_t CAN_Control_Set_Op_Mode_Wait( CAN_Control_HandleTypeDef *hcan, uint8_t opmode, uint32_t timeout_us );
+    uint8_t CAN_Control_Set_Baud_Rate( CAN_Control_HandleTypeDef *hcan, uint32_t baudrate );
 
     /* MCP2515 mask and filter configuration funtions */
     void CAN_Control_Set_RX_Mask( CAN_Control_HandleTypeDef *hcan, CAN_Control_RX_Mask *hmask );
     void CAN_Control_Set_RX_Filter( CAN_Control_HandleTypeDef *hcan, CAN_Control_RX_Filter *hfilter );
 
     /* MCP2515 register write, read and bit modify functions */
-    void CAN_Control_Register_Write( CAN_Control_HandleTypeDef *hcan, uint8_t reg_addr, uint8_t *data, uint8_t size );
+    void CAN_Control_Register_Write( CAN_Control_HandleTypeDef *hcan, uint8_t reg_addr, const uint8_t *data, uint8_t size );
     void CAN_Control_Register_Read( CAN_Control_HandleTypeDef *hcan, uint8_t reg_addr, uint8_t *data, uint8_t size );
     void CAN_Control_Register_Bit( CAN_Control_HandleTypeDef *hcan, uint8_t reg_addr, uint8_t mask, uint8_t data );
+    void CAN_Control_Shadow_Invalidate( CAN_Control_HandleTypeDef *hcan );
 
     /* MCP2515 CAN frame write and read functions */
     void CAN_Control_Send_CAN_Frame( CAN_Control_HandleTypeDef *hcan, CAN_Control_TX *txcan );
     void CAN_Control_Read_CAN_Frame( CAN_Control_HandleTypeDef *hcan, CAN_Control_RX *rxcan );
+    uint8_t CAN_Control_Send_Frame( CAN_Control_HandleTypeDef *hcan, const CAN_Control_Frame *frame );
+    uint8_t CAN_Control_Receive_Frame( CAN_Control_HandleTypeDef *hcan, CAN_Control_Frame *frame );
+    uint16_t CAN_Control_Send_CAN_Batch( CAN_Control_HandleTypeDef *hcan, const CAN_Control_Frame *frames, uint16_t count, uint8_t *status, uint32_t timeout_us );
+    uint16_t CAN_Control_Receive_CAN_Batch( CAN_Control_HandleTypeDef *hcan, CAN_Control_Frame *frames, uint16_t max );
 
     /* MCP2515 TX CAN frame status and aborting functions */
     uint8_t CAN_Control_TX_CAN_Status( CAN_Control_HandleTypeDef *hcan, uint8_t tx_buffer );
@@ -667,10 +891,16 @@
     /* MCP2515 Interrupt enabling, status and clearing functions */
     void CAN_Control_Enable_INT( CAN_Control_HandleTypeDef *hcan, uint8_t interrupts );
     uint8_t CAN_Control_INT_Status( CAN_Control_HandleTypeDef *hcan );
+    uint8_t CAN_Control_Read_Status( CAN_Control_HandleTypeDef *hcan );
+    uint8_t CAN_Control_RX_Status( CAN_Control_HandleTypeDef *hcan );
     void CAN_Control_Clear_INT_Status( CAN_Control_HandleTypeDef *hcan, uint8_t interrupts );
     
     /* MCP2515 Error status and clearing functions */
     uint8_t CAN_Control_ERR_Status( CAN_Control_HandleTypeDef *hcan );
     void CAN_Control_Clear_ERR_Status( CAN_Control_HandleTypeDef *hcan, uint8_t errors );
 
+    /* MCP2515 low-power sleep and wake-up functions */
+    void CAN_Control_Sleep( CAN_Control_HandleTypeDef *hcan );
+    void CAN_Control_Wake_Up( CAN_Control_HandleTypeDef *hcan );
+
 #endif
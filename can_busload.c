@@ -0,0 +1,161 @@
+/**
+ * @file      can_busload.c
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the function implementations for the CAN bus-load monitor, which estimates the
+ *            bus utilization seen by a CAN node (MCP2515) from the exact bit length of the frames it sends and receives.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ *            Frames are accounted for with CAN_Busload_Add() or CAN_Busload_Add_Frame() when a transmission completes
+ *            (TXnIF) or when a frame is drained from an RX buffer, and CAN_Busload_Tick() closes a 100ms tick. The driver
+ *            does it by itself for the controllers whose handle points to a monitor ('busload' field): frames read by
+ *            CAN_Control_Receive_Frame() and CAN_Control_Receive_CAN_Batch(), and frames sent by CAN_Control_Send_CAN_Batch().
+ *            Only frames seen by the node are accounted for, RX frames rejected by the masks and filters are not.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#include "can_busload.h"
+
+/**
+ * @brief Clear the bus-load monitor and compute the fixed-point factors that convert the bits of each window into
+ *        utilization for the given baud rate. This is the only place where a division is performed.
+ * 
+ * @param mon      pointer to the bus-load monitor to initialize
+ * @param baudrate CAN baud rate in bps
+ */
+void CAN_Busload_Init( CAN_Busload_Monitor *mon, uint32_t baudrate )
+{
+    uint32_t capacity = baudrate / ( 1000U / BUSLOAD_TICK_MS ); /* bits that fit in one tick */
+    uint8_t  slot;
+
+    for ( slot = 0U; slot < BUSLOAD_SLOTS; slot++ )
+    {
+        mon->slotbits[ slot ]                 = 0U;
+        mon->slotframes[ BUSLOAD_TX ][ slot ] = 0U;
+        mon->slotframes[ BUSLOAD_RX ][ slot ] = 0U;
+        mon->secondbits[ slot ]               = 0U;
+    }
+
+    mon->tickbits                 = 0U;
+    mon->tickframes[ BUSLOAD_TX ] = 0U;
+    mon->tickframes[ BUSLOAD_RX ] = 0U;
+    mon->sum1s                    = 0U;
+    mon->sum10s                   = 0U;
+    mon->slot                     = 0U;
+    mon->second                   = 0U;
+    mon->load100ms                = 0U;
+    mon->load1s                   = 0U;
+    mon->load10s                  = 0U;
+    mon->peakload                 = 0U;
+    mon->fps[ BUSLOAD_TX ]        = 0U;
+    mon->fps[ BUSLOAD_RX ]        = 0U;
+
+    /* utilization = bits x factor >> BUSLOAD_FACTOR_SHIFT, with factor = full scale / window capacity */
+    mon->factor[ 0 ] = ( uint32_t )( ( ( uint64_t )BUSLOAD_FULL_SCALE << BUSLOAD_FACTOR_SHIFT ) / capacity );
+    mon->factor[ 1 ] = ( uint32_t )( ( ( uint64_t )BUSLOAD_FULL_SCALE << BUSLOAD_FACTOR_SHIFT ) / ( capacity * BUSLOAD_SLOTS ) );
+    mon->factor[ 2 ] = ( uint32_t )( ( ( uint64_t )BUSLOAD_FULL_SCALE << BUSLOAD_FACTOR_SHIFT ) / ( capacity * BUSLOAD_SLOTS * BUSLOAD_SLOTS ) );
+}
+
+/**
+ * @brief Account for one frame of the given length in the current tick, along with the intermission that follows it.
+ *        Only additions are performed, so this function is cheap enough to be called from the RX/TX ISR.
+ * 
+ * @param mon       pointer to the bus-load monitor
+ * @param direction frame direction. Refer to 'Bus-load traffic direction definitions' in can_busload.h
+ * @param bits      frame length in bits (refer to CAN_Timing_Frame_Bits() in can_timing.c)
+ */
+void CAN_Busload_Add( CAN_Busload_Monitor *mon, uint8_t direction, uint8_t bits )
+{
+    uint32_t primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    mon->tickbits += ( uint32_t )bits + CAN_INTERMISSION_BITS;
+    mon->tickframes[ direction & BUSLOAD_RX ]++;
+
+    __set_PRIMASK( primask );
+}
+
+/**
+ * @brief Compute the exact length of the given frame and account for it in the current tick.
+ * 
+ * @param mon        pointer to the bus-load monitor
+ * @param direction  frame direction. Refer to 'Bus-load traffic direction definitions' in can_busload.h
+ * @param frametype  CAN frame type. Refer to 'TX buffer frame type definitions' in can.h
+ * @param id         CAN ID
+ * @param datalength DLC value
+ * @param data       data bytes of the frame (ignored for remote frames)
+ */
+void CAN_Busload_Add_Frame( CAN_Busload_Monitor *mon, uint8_t direction, uint8_t frametype, uint32_t id, uint8_t datalength, const uint8_t *data )
+{
+    CAN_Busload_Add( mon, direction, CAN_Timing_Frame_Bits( frametype, id, datalength, data ) );
+}
+
+/**
+ * @brief Close the current tick and update the sliding windows, utilizations, peak load and frames per second.
+ *        Must be called every BUSLOAD_TICK_MS milliseconds (e.g. from a periodic timer interrupt).
+ *        Windows are kept as running sums, so no division is performed.
+ * 
+ * @param mon pointer to the bus-load monitor
+ */
+void CAN_Busload_Tick( CAN_Busload_Monitor *mon )
+{
+    uint32_t primask;
+    uint32_t bits;
+    uint16_t frames[ 2 ];
+    uint8_t  slot = mon->slot;
+
+    /* take the accumulators of the tick that just ended */
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    bits                          = mon->tickbits;
+    frames[ BUSLOAD_TX ]          = mon->tickframes[ BUSLOAD_TX ];
+    frames[ BUSLOAD_RX ]          = mon->tickframes[ BUSLOAD_RX ];
+    mon->tickbits                 = 0U;
+    mon->tickframes[ BUSLOAD_TX ] = 0U;
+    mon->tickframes[ BUSLOAD_RX ] = 0U;
+
+    __set_PRIMASK( primask );
+
+    /* 1s window: replace the oldest tick by the new one */
+    mon->sum1s += bits - mon->slotbits[ slot ];
+    mon->slotbits[ slot ] = bits;
+
+    mon->fps[ BUSLOAD_TX ] += frames[ BUSLOAD_TX ] - mon->slotframes[ BUSLOAD_TX ][ slot ];
+    mon->fps[ BUSLOAD_RX ] += frames[ BUSLOAD_RX ] - mon->slotframes[ BUSLOAD_RX ][ slot ];
+    mon->slotframes[ BUSLOAD_TX ][ slot ] = frames[ BUSLOAD_TX ];
+    mon->slotframes[ BUSLOAD_RX ][ slot ] = frames[ BUSLOAD_RX ];
+
+    /* every 10 ticks (1s), 10s window: replace the oldest second by the last one */
+    if ( ++slot == BUSLOAD_SLOTS )
+    {
+        slot = 0U;
+
+        mon->sum10s += mon->sum1s - mon->secondbits[ mon->second ];
+        mon->secondbits[ mon->second ] = mon->sum1s;
+
+        if ( ++mon->second == BUSLOAD_SLOTS )
+        {
+            mon->second = 0U;
+        }
+
+        mon->load10s = ( uint16_t )( ( ( uint64_t )mon->sum10s * mon->factor[ 2 ] ) >> BUSLOAD_FACTOR_SHIFT );
+    }
+
+    mon->slot = slot;
+
+    /* utilizations of the 100ms and 1s windows */
+    mon->load100ms = ( uint16_t )( ( ( uint64_t )bits       * mon->factor[ 0 ] ) >> BUSLOAD_FACTOR_SHIFT );
+    mon->load1s    = ( uint16_t )( ( ( uint64_t )mon->sum1s * mon->factor[ 1 ] ) >> BUSLOAD_FACTOR_SHIFT );
+
+    if ( mon->load100ms > mon->peakload )
+    {
+        mon->peakload = mon->load100ms;
+    }
+}
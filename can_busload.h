@@ -0,0 +1,68 @@
+/**
+ * @file      can_busload.h
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the definitions and function prototypes for the CAN bus-load monitor, which estimates the
+ *            bus utilization seen by a CAN node (MCP2515) from the exact bit length of the frames it sends and receives.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#ifndef CAN_BUSLOAD_H
+#define CAN_BUSLOAD_H
+
+    #include <stdint.h>
+    #include "stm32f0xx.h"
+    #include "can.h"
+    #include "can_timing.h"
+
+    /* Bus-load traffic direction definitions */
+    #define BUSLOAD_TX                          (0x00U)
+    #define BUSLOAD_RX                          (0x01U)
+
+    /* Bus-load utilization full scale, utilization values are given in hundredths of a percent (10000 = 100.00%) */
+    #define BUSLOAD_FULL_SCALE                  (10000UL)
+
+    /* Bus-load window definitions: CAN_Busload_Tick() must be called every BUSLOAD_TICK_MS milliseconds,
+       the 1s window holds the last 10 ticks and the 10s window holds the last 10 seconds */
+    #define BUSLOAD_TICK_MS                     (100U)
+    #define BUSLOAD_SLOTS                       (10U)
+
+    /* Fixed-point shift of the scale factors that convert bits into utilization */
+    #define BUSLOAD_FACTOR_SHIFT                (24U)
+
+    /* Structure that holds the state and results of a bus-load monitor (tagged, so that CAN_Control_HandleTypeDef can point to it) */
+    typedef struct CAN_Busload_Monitor
+    {
+        uint32_t          factor[ 3 ];                                 /* Bits to utilization scale factors for the 100ms, 1s and 10s windows  */
+        volatile uint32_t tickbits;                                    /* Bits accumulated during the current tick (hot path)                  */
+        volatile uint16_t tickframes[ 2 ];                             /* TX and RX frames accumulated during the current tick (hot path)      */
+        uint32_t          slotbits[ BUSLOAD_SLOTS ];                   /* Bits of the last 10 ticks                                            */
+        uint16_t          slotframes[ 2 ][ BUSLOAD_SLOTS ];            /* TX and RX frames of the last 10 ticks                                */
+        uint32_t          secondbits[ BUSLOAD_SLOTS ];                 /* Bits of the last 10 seconds                                          */
+        uint32_t          sum1s;                                       /* Bits of the 1s window                                                */
+        uint32_t          sum10s;                                      /* Bits of the 10s window                                               */
+        uint8_t           slot;                                        /* Current tick slot (0 to 9)                                           */
+        uint8_t           second;                                      /* Current second slot (0 to 9)                                         */
+        uint16_t          load100ms;                                   /* Utilization over the last 100ms (refer to BUSLOAD_FULL_SCALE)        */
+        uint16_t          load1s;                                      /* Utilization over the last 1s (refer to BUSLOAD_FULL_SCALE)           */
+        uint16_t          load10s;                                     /* Utilization over the last 10s (refer to BUSLOAD_FULL_SCALE)          */
+        uint16_t          peakload;                                    /* Highest 100ms utilization seen (refer to BUSLOAD_FULL_SCALE)         */
+        uint16_t          fps[ 2 ];                                    /* TX and RX frames per second over the last 1s                         */
+    } CAN_Busload_Monitor;
+
+    /* Bus-load monitor initialization function */
+    void CAN_Busload_Init( CAN_Busload_Monitor *mon, uint32_t baudrate );
+
+    /* Bus-load monitor frame accounting functions (safe to call from an ISR) */
+    void CAN_Busload_Add( CAN_Busload_Monitor *mon, uint8_t direction, uint8_t bits );
+    void CAN_Busload_Add_Frame( CAN_Busload_Monitor *mon, uint8_t direction, uint8_t frametype, uint32_t id, uint8_t datalength, const uint8_t *data );
+
+    /* Bus-load monitor periodic update function */
+    void CAN_Busload_Tick( CAN_Busload_Monitor *mon );
+
+#endif
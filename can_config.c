@@ -0,0 +1,225 @@
+/**
+ * @file      can_config.c
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the function implementations for the CAN configuration store. The register images of the
+ *            CAN Controllers (refer to CAN_Control_Build_Image() in can.c) are kept in the last flash page (CANCFG in
+ *            linker.ld) behind a header with a magic number, a format version and a CRC-32 computed by the CRC unit.
+ *            At boot an image is used straight from flash by CAN_Control_Warm_Start() or CAN_Control_Init_Image(),
+ *            skipping the field by field configuration, and new filter sets are deployed by writing a new blob.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#include "can_config.h"
+
+/* First byte of the flash page reserved for the configuration blob (refer to linker.ld) */
+extern const uint8_t _can_config_start[];
+
+/* Build-time check of the blob layout: 12-byte header, byte-packed controller images */
+typedef char can_config_header_check[ ( sizeof( CAN_Config_Header ) == 12U ) ? 1 : -1 ];
+typedef char can_config_image_check[ ( CAN_CONFIG_IMAGE_SIZE == ( CAN_IMAGE_SIZE + 3U ) ) ? 1 : -1 ];
+
+/**
+ * @brief Compute the CRC-32 of the header fields before 'crc' followed by the controller images, with the CRC unit
+ *        (polynomial 0x04C11DB7, initial value 0xFFFFFFFF, input and output bit-reversed, final XOR 0xFFFFFFFF).
+ * 
+ * @param header    pointer to the blob header
+ * @param images    pointer to the controller images
+ * @return uint32_t CRC-32
+ */
+static uint32_t CAN_Config_CRC( const CAN_Config_Header *header, const uint8_t *images )
+{
+    const uint8_t *data = ( const uint8_t * )header;
+    uint16_t       size = ( uint16_t )( header->count * header->imagesize );
+    uint16_t       i;
+
+    /* enable CRC clock access, bit-reversed input (by byte) and output, then reset the CRC to its initial value */
+    CRC_CLK_ENBL();
+    CRC->INIT = 0xFFFFFFFFUL;
+    CRC->CR   = CRC_CR_REV_IN_0 | CRC_CR_REV_OUT | CRC_CR_RESET;
+
+    /* Header fields before the CRC (magic, version, imagesize and count) */
+    for ( i = 0U; i < 8U; i++ )
+    {
+        *( __IO uint8_t * )( &CRC->DR ) = data[ i ];
+    }
+
+    /* Controller images */
+    for ( i = 0U; i < size; i++ )
+    {
+        *( __IO uint8_t * )( &CRC->DR ) = images[ i ];
+    }
+
+    return ~CRC->DR;
+}
+
+/**
+ * @brief Wait for the current flash operation to end and check its result.
+ * 
+ * @return uint8_t CONFIG_OK or CONFIG_FLASH_ERROR
+ */
+static uint8_t CAN_Config_Flash_Wait( void )
+{
+    uint32_t status;
+
+    while ( ( FLASH->SR & FLASH_SR_BSY ) == FLASH_SR_BSY )
+    {
+        /* do nothing */
+    }
+
+    status = FLASH->SR;
+
+    /* clear the end of operation and error flags (write 1 to clear) */
+    FLASH->SR = FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+
+    return ( ( status & ( FLASH_SR_PGERR | FLASH_SR_WRPRTERR ) ) != 0U ) ? CONFIG_FLASH_ERROR : CONFIG_OK;
+}
+
+/**
+ * @brief Program bytes into the flash, one half-word at a time (an odd last byte is padded with 0xFF).
+ *        The flash must be unlocked and the half-words erased.
+ * 
+ * @param address  flash address to program (half-word aligned)
+ * @param data     bytes to program
+ * @param size     number of bytes
+ * @return uint8_t CONFIG_OK or CONFIG_FLASH_ERROR
+ */
+static uint8_t CAN_Config_Flash_Program( uint32_t address, const uint8_t *data, uint16_t size )
+{
+    uint8_t  status = CONFIG_OK;
+    uint8_t  high;
+    uint16_t i;
+
+    FLASH->CR |= FLASH_CR_PG;
+
+    for ( i = 0U; ( i < size ) && ( status == CONFIG_OK ); i += 2U )
+    {
+        high = ( ( i + 1U ) < size ) ? data[ i + 1U ] : 0xFFU;
+        *( __IO uint16_t * )( uintptr_t )( address + i ) = ( uint16_t )( data[ i ] | ( ( uint16_t )high << 8 ) );
+        status = CAN_Config_Flash_Wait();
+    }
+
+    FLASH->CR &= ~FLASH_CR_PG;
+
+    return status;
+}
+
+/**
+ * @brief Check the configuration blob stored in flash: magic number, format version, image size, number of images
+ *        and CRC-32.
+ * 
+ * @return uint8_t CONFIG_OK, CONFIG_EMPTY, CONFIG_BAD_FORMAT or CONFIG_BAD_CRC
+ *                 (refer to 'configuration blob status definitions' in can_config.h)
+ */
+uint8_t CAN_Config_Check( void )
+{
+    const CAN_Config_Header *header = ( const CAN_Config_Header * )_can_config_start;
+
+    /* Erased flash reads all ones */
+    if ( header->magic == 0xFFFFFFFFUL )
+    {
+        return CONFIG_EMPTY;
+    }
+
+    if ( ( header->magic != CAN_CONFIG_MAGIC ) || ( header->version != CAN_CONFIG_VERSION ) ||
+         ( header->imagesize != CAN_CONFIG_IMAGE_SIZE ) || ( header->count == 0U ) || ( header->count > CAN_CONFIG_MAX_NODES ) )
+    {
+        return CONFIG_BAD_FORMAT;
+    }
+
+    if ( CAN_Config_CRC( header, &_can_config_start[ sizeof( CAN_Config_Header ) ] ) != header->crc )
+    {
+        return CONFIG_BAD_CRC;
+    }
+
+    return CONFIG_OK;
+}
+
+/**
+ * @brief Get the register image of a controller from the configuration blob in flash, ready to be passed to
+ *        CAN_Control_Warm_Start() or CAN_Control_Init_Image() (the image is used in place, nothing is copied).
+ * 
+ * @param node     controller index in the blob
+ * @return const CAN_Control_Image* pointer to the image in flash, NULL if the blob is not valid or has no such controller
+ */
+const CAN_Control_Image *CAN_Config_Load( uint8_t node )
+{
+    const CAN_Config_Header *header = ( const CAN_Config_Header * )_can_config_start;
+
+    if ( ( CAN_Config_Check() != CONFIG_OK ) || ( node >= header->count ) )
+    {
+        return NULL;
+    }
+
+    return ( const CAN_Control_Image * )&_can_config_start[ sizeof( CAN_Config_Header ) + ( node * CAN_CONFIG_IMAGE_SIZE ) ];
+}
+
+/**
+ * @brief Write a new configuration blob to the reserved flash page: erase the page, program the header and the
+ *        controller images, then check the blob read back from flash.
+ * 
+ *        Note: the core stalls while the flash is erased (about 40ms) and programmed, interrupts included.
+ * 
+ * @param images   array of controller register images (refer to CAN_Control_Build_Image() in can.c)
+ * @param count    number of controller images (1 to CAN_CONFIG_MAX_NODES)
+ * @return uint8_t CONFIG_OK, CONFIG_BAD_FORMAT (wrong number of images), CONFIG_FLASH_ERROR or the result of
+ *                 CAN_Config_Check() (refer to 'configuration blob status definitions' in can_config.h)
+ */
+uint8_t CAN_Config_Store( const CAN_Control_Image *images, uint8_t count )
+{
+    CAN_Config_Header header;
+    uint32_t          address = ( uint32_t )( uintptr_t )_can_config_start;
+    uint8_t           status;
+
+    if ( ( count == 0U ) || ( count > CAN_CONFIG_MAX_NODES ) )
+    {
+        return CONFIG_BAD_FORMAT;
+    }
+
+    header.magic     = CAN_CONFIG_MAGIC;
+    header.version   = CAN_CONFIG_VERSION;
+    header.imagesize = ( uint8_t )CAN_CONFIG_IMAGE_SIZE;
+    header.count     = count;
+    header.crc       = CAN_Config_CRC( &header, ( const uint8_t * )images );
+
+    /* unlock the flash program/erase controller */
+    if ( ( FLASH->CR & FLASH_CR_LOCK ) == FLASH_CR_LOCK )
+    {
+        FLASH->KEYR = FLASH_KEY1;
+        FLASH->KEYR = FLASH_KEY2;
+    }
+
+    /* erase the configuration page */
+    FLASH->CR |= FLASH_CR_PER;
+    FLASH->AR  = address;
+    FLASH->CR |= FLASH_CR_STRT;
+    status     = CAN_Config_Flash_Wait();
+    FLASH->CR &= ~FLASH_CR_PER;
+
+    /* program the header, then the images right behind it */
+    if ( status == CONFIG_OK )
+    {
+        status = CAN_Config_Flash_Program( address, ( const uint8_t * )&header, sizeof( CAN_Config_Header ) );
+    }
+
+    if ( status == CONFIG_OK )
+    {
+        status = CAN_Config_Flash_Program( address + sizeof( CAN_Config_Header ), ( const uint8_t * )images,
+                                           ( uint16_t )( count * CAN_CONFIG_IMAGE_SIZE ) );
+    }
+
+    /* lock the flash program/erase controller again */
+    FLASH->CR |= FLASH_CR_LOCK;
+
+    if ( status != CONFIG_OK )
+    {
+        return status;
+    }
+
+    return CAN_Config_Check();
+}
@@ -0,0 +1,58 @@
+/**
+ * @file      can_config.h
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the definitions and function prototypes for the CAN configuration store, which keeps the
+ *            register images of the CAN Controllers (MCP2515) in a reserved flash page as a versioned, CRC-checked blob.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#ifndef CAN_CONFIG_H
+#define CAN_CONFIG_H
+
+    #include <stdint.h>
+    #include "stm32f0xx.h"
+    #include "can.h"
+
+    /* Macro to enable CRC clock in the RCC */
+    #define CRC_CLK_ENBL()                      (RCC->AHBENR |= RCC_AHBENR_CRCEN)
+
+    /* Configuration blob definitions: "CANC" in flash, format version and size of a controller register image */
+    #define CAN_CONFIG_MAGIC                    (0x434E4143UL)
+    #define CAN_CONFIG_VERSION                  (0x0001U)
+    #define CAN_CONFIG_IMAGE_SIZE               ( sizeof( CAN_Control_Image ) )
+
+    /* Flash page reserved for the configuration blob (refer to CANCFG in linker.ld) */
+    #define CAN_CONFIG_PAGE_SIZE                (0x800U)
+    #define CAN_CONFIG_MAX_NODES                ( ( CAN_CONFIG_PAGE_SIZE - sizeof( CAN_Config_Header ) ) / CAN_CONFIG_IMAGE_SIZE )
+
+    /* Configuration blob status definitions */
+    #define CONFIG_OK                           (0x00U)
+    #define CONFIG_EMPTY                        (0x01U) /* erased page, nothing stored yet              */
+    #define CONFIG_BAD_FORMAT                   (0x02U) /* unknown magic, version or image size         */
+    #define CONFIG_BAD_CRC                      (0x03U) /* corrupted or partially written blob          */
+    #define CONFIG_FLASH_ERROR                  (0x04U) /* erase or programming error, write protection */
+
+    /* Structure that holds the header of the configuration blob, followed in flash by 'count' CAN_Control_Image
+       (one per controller, byte-packed). The CRC-32 (IEEE 802.3, as zlib crc32()) covers the header fields before it
+       and the images, so that a blob can be generated off-target and written to the page as data */
+    typedef struct
+    {
+        uint32_t magic;                     /* CAN_CONFIG_MAGIC                                          */
+        uint16_t version;                   /* CAN_CONFIG_VERSION                                        */
+        uint8_t  imagesize;                 /* CAN_CONFIG_IMAGE_SIZE, size of every controller image     */
+        uint8_t  count;                     /* Number of controller images                               */
+        uint32_t crc;                       /* CRC-32 of magic, version, imagesize, count and the images */
+    } CAN_Config_Header;
+
+    /* CAN configuration store functions */
+    uint8_t CAN_Config_Check( void );
+    const CAN_Control_Image *CAN_Config_Load( uint8_t node );
+    uint8_t CAN_Config_Store( const CAN_Control_Image *images, uint8_t count );
+
+#endif
@@ -0,0 +1,171 @@
+/**
+ * @file      can_dispatch.c
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the CAN frame dispatch functions. Frames accepted by an MCP2515 acceptance filter reach
+ *            their handler straight from the filter match reported by RX STATUS, so when the filter is an exact match
+ *            (every mask bit set) no ID comparison nor table lookup is needed. Frames beyond the six filters are routed
+ *            by ID through a two-level perfect hash table generated at build time by tools/can_dispatch_gen.c, or a sorted
+ *            table searched by bisection.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#include <stddef.h>
+#include "can_dispatch.h"
+
+/**
+ * @brief Point every acceptance filter to the fallback handler.
+ * 
+ * @param dispatch pointer to the acceptance filter handlers
+ * @param fallback handler of the frames accepted by filters without their own handler (must not be NULL)
+ * @param context  context pointer passed to the fallback handler
+ */
+void CAN_Dispatch_Filters_Init( CAN_Dispatch_Filters *dispatch, CAN_Dispatch_Handler fallback, void *context )
+{
+    uint8_t i;
+
+    for ( i = 0U; i < CAN_DISPATCH_FILTER_MATCHES; i++ )
+    {
+        dispatch->filter[ i ].handler = fallback;
+        dispatch->filter[ i ].context = context;
+    }
+}
+
+/**
+ * @brief Register the handler of the frames accepted by an acceptance filter.
+ *        Frames accepted by RXF0 or RXF1 that rolled over into RXB1 reach the same handler.
+ * 
+ * @param dispatch pointer to the acceptance filter handlers
+ * @param filter   acceptance filter (FILHIT_ACCEPTANCE_FILTER_0 to FILHIT_ACCEPTANCE_FILTER_5)
+ * @param handler  handler function (must not be NULL)
+ * @param context  context pointer passed to the handler
+ */
+void CAN_Dispatch_Register_Filter( CAN_Dispatch_Filters *dispatch, uint8_t filter, CAN_Dispatch_Handler handler, void *context )
+{
+    if ( filter <= FILHIT_ACCEPTANCE_FILTER_5 )
+    {
+        dispatch->filter[ filter ].handler = handler;
+        dispatch->filter[ filter ].context = context;
+
+        /* RX STATUS reports 6 and 7 for RXF0 and RXF1 with rollover to RXB1 */
+        if ( filter <= FILHIT_ACCEPTANCE_FILTER_1 )
+        {
+            dispatch->filter[ filter + 6U ].handler = handler;
+            dispatch->filter[ filter + 6U ].context = context;
+        }
+    }
+}
+
+/**
+ * @brief Call the handler of the acceptance filter that let the frame through, indexed by its filter match.
+ * 
+ * @param dispatch pointer to the acceptance filter handlers
+ * @param frame    pointer to a CAN frame read by CAN_Control_Receive_Frame()
+ */
+void CAN_Dispatch_By_Filter( const CAN_Dispatch_Filters *dispatch, const CAN_Control_Frame *frame )
+{
+    const CAN_Dispatch_Entry *entry = &dispatch->filter[ ( frame->flags & CAN_FRAME_FILHIT_MASK ) >> CAN_FRAME_FILHIT_SHIFT ];
+
+    entry->handler( frame, entry->context );
+}
+
+/**
+ * @brief Read every received CAN frame and dispatch it by acceptance filter.
+ * 
+ * @param hcan      pointer to an MCP2515 configuration structure (CAN receiving node)
+ * @param dispatch  pointer to the acceptance filter handlers
+ * @return uint16_t number of frames dispatched
+ */
+uint16_t CAN_Dispatch_Receive( CAN_Control_HandleTypeDef *hcan, const CAN_Dispatch_Filters *dispatch )
+{
+    CAN_Control_Frame frame;
+    uint16_t          count = 0U;
+
+    while ( CAN_Control_Receive_Frame( hcan, &frame ) == 1U )
+    {
+        CAN_Dispatch_By_Filter( dispatch, &frame );
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Find the dispatch table entry of a CAN ID. Perfect hash tables cost two multiplications, one displacement
+ *        read and one comparison regardless of the number of messages, sorted tables cost log2( size ) comparisons.
+ * 
+ * @param ids                           pointer to the ID dispatch table
+ * @param id                            CAN ID
+ * @param extended                      1 if the ID is extended, 0 if it is standard
+ * @return const CAN_Dispatch_ID_Entry* table entry of the ID, NULL if the ID is not in the table
+ */
+const CAN_Dispatch_ID_Entry *CAN_Dispatch_Find_ID( const CAN_Dispatch_IDs *ids, uint32_t id, uint8_t extended )
+{
+    const CAN_Dispatch_ID_Entry *entry = NULL;
+    uint32_t                     key   = CAN_DISPATCH_KEY( id, extended );
+    uint16_t                     low, high, middle;
+
+    PROFILE_START( PROFILE_DISPATCH_LOOKUP );
+
+    /* Perfect hash table: the only candidate is the entry at the displaced slot */
+    if ( ids->displace != NULL )
+    {
+        entry = &ids->entries[ CAN_DISPATCH_PERFECT_SLOT( ids, key ) ];
+        entry = ( entry->key == key ) ? entry : NULL;
+    }
+    /* Sorted table: bisection */
+    else
+    {
+        low  = 0U;
+        high = ids->size;
+
+        while ( low < high )
+        {
+            middle = ( uint16_t )( ( low + high ) >> 1 );
+
+            if ( ids->entries[ middle ].key < key )
+            {
+                low = middle + 1U;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+
+        if ( ( low < ids->size ) && ( ids->entries[ low ].key == key ) )
+        {
+            entry = &ids->entries[ low ];
+        }
+    }
+
+    PROFILE_STOP( PROFILE_DISPATCH_LOOKUP );
+
+    return entry;
+}
+
+/**
+ * @brief Call the handler registered for the ID of a CAN frame.
+ * 
+ * @param ids      pointer to the ID dispatch table
+ * @param frame    pointer to the received CAN frame
+ * @return uint8_t 1 if the frame was handled, 0 if its ID is not in the table
+ */
+uint8_t CAN_Dispatch_By_ID( const CAN_Dispatch_IDs *ids, const CAN_Control_Frame *frame )
+{
+    const CAN_Dispatch_ID_Entry *entry = CAN_Dispatch_Find_ID( ids, frame->id, frame->flags & CAN_FRAME_EXTENDED );
+
+    if ( entry == NULL )
+    {
+        return 0U;
+    }
+
+    entry->handler( frame, entry->context );
+
+    return 1U;
+}
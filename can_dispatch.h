@@ -0,0 +1,111 @@
+/**
+ * @file      can_dispatch.h
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the definitions and function prototypes for the CAN frame dispatcher, which routes the
+ *            received CAN frames to application handlers.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#ifndef CAN_DISPATCH_H
+#define CAN_DISPATCH_H
+
+    #include <stdint.h>
+    #include "stm32f0xx.h"
+    #include "can.h"
+    #include "profile.h"
+
+    /* Number of filter match values reported by RX STATUS (RXF0 to RXF5, plus RXF0 and RXF1 with rollover to RXB1) */
+    #define CAN_DISPATCH_FILTER_MATCHES         (8U)
+
+    /* ID dispatch table key: CAN ID, IDE bit in bit 31 and a valid entry marker in bit 30
+       (empty entries of a perfect hash table are zero, so they never match) */
+    #define CAN_DISPATCH_KEY( id, extended )    ( ( ( uint32_t )( id ) & 0x1FFFFFFFUL ) | ( ( uint32_t )( extended ) << 31 ) | 0x40000000UL )
+
+    /* Multiplicative hash of a key, the upper 32 - shift bits of the product (same 32-bit arithmetic on the host
+       generator and on the target) */
+    #define CAN_DISPATCH_HASH( key, seed, shift ) \
+        ( ( uint32_t )( ( ( uint32_t )( key ) * ( uint32_t )( seed ) ) >> ( shift ) ) )
+
+    /* Two-level perfect hash (hash and displace): the bucket hash of a key picks a displacement, which is XORed with
+       its slot hash. The displacements are searched bucket by bucket at build time by tools/can_dispatch_gen.c, so
+       every key of the message list lands on a slot of its own and a lookup is two multiplications, one displacement
+       read and one key comparison, whatever the number of messages */
+    #define CAN_DISPATCH_PERFECT_SLOT( ids, key )                                                                   \
+        ( CAN_DISPATCH_HASH( key, ( ids )->slotseed, ( ids )->slotshift ) ^                                       \
+          ( ids )->displace[ CAN_DISPATCH_HASH( key, ( ids )->bucketseed, ( ids )->bucketshift ) ] )
+
+    /* Message list entry expansion: the application describes its messages with an X-macro list of
+       X( id, extended, handler, context ) entries, e.g.:
+
+           #define APP_MESSAGES( X )                      \
+               X( 0x0CF00400UL, 1U, App_EEC1, &engine   ) \
+               X( 0x18FEF100UL, 1U, App_CCVS, &vehicle  )
+
+       'make' builds tools/can_dispatch_gen with the list and runs it to generate the perfect hash table source
+       (refer to can_messages.h), or the list instantiates a sorted table with CAN_DISPATCH_SORTED_TABLE() */
+    #define CAN_DISPATCH_SORTED_ENTRY( id, extended, handler, context ) \
+        { CAN_DISPATCH_KEY( id, extended ), ( handler ), ( context ) },
+
+    /* Sorted ID dispatch table instantiation (binary search fallback, logarithmic lookup cost). The list must be in
+       ascending key order: standard IDs first, then extended IDs, each in ascending ID order */
+    #define CAN_DISPATCH_SORTED_TABLE( name, LIST )                                                                 \
+        static const CAN_Dispatch_ID_Entry name##_entries[] =                                                       \
+        {                                                                                                           \
+            LIST( CAN_DISPATCH_SORTED_ENTRY )                                                                       \
+        };                                                                                                          \
+        const CAN_Dispatch_IDs name = { name##_entries, NULL, ( uint16_t )( sizeof( name##_entries ) / sizeof( name##_entries[ 0 ] ) ), \
+                                        0U, 0U, 0U, 0U }
+
+    /* CAN frame handler, called with the received frame and the context pointer given at registration */
+    typedef void ( *CAN_Dispatch_Handler )( const CAN_Control_Frame *frame, void *context );
+
+    /* Structure that holds a handler along with its context */
+    typedef struct
+    {
+        CAN_Dispatch_Handler handler;                                  /* Handler function                                                     */
+        void                *context;                                  /* Context pointer passed to the handler                                */
+    } CAN_Dispatch_Entry;
+
+    /* Structure that holds the handlers of the MCP2515 acceptance filters */
+    typedef struct
+    {
+        CAN_Dispatch_Entry filter[ CAN_DISPATCH_FILTER_MATCHES ];      /* Handlers indexed by the frame filter match (refer to CAN_FRAME_FILHIT_MASK) */
+    } CAN_Dispatch_Filters;
+
+    /* Structure that holds an ID dispatch table entry */
+    typedef struct
+    {
+        uint32_t             key;                                      /* Dispatch key (refer to CAN_DISPATCH_KEY()), 0 if the entry is empty  */
+        CAN_Dispatch_Handler handler;                                  /* Handler function                                                     */
+        void                *context;                                  /* Context pointer passed to the handler                                */
+    } CAN_Dispatch_ID_Entry;
+
+    /* Structure that describes an ID dispatch table (refer to tools/can_dispatch_gen.c and CAN_DISPATCH_SORTED_TABLE()) */
+    typedef struct
+    {
+        const CAN_Dispatch_ID_Entry *entries;                          /* Table entries                                                        */
+        const uint16_t              *displace;                         /* Bucket displacements, NULL for a sorted table                        */
+        uint16_t                     size;                             /* Number of entries                                                    */
+        uint32_t                     bucketseed;                       /* Bucket hash seed, 0 for a sorted table                               */
+        uint32_t                     slotseed;                         /* Slot hash seed, 0 for a sorted table                                 */
+        uint8_t                      bucketshift;                      /* Bucket hash shift (32 - bucket bits), 0 for a sorted table           */
+        uint8_t                      slotshift;                        /* Slot hash shift (32 - slot bits), 0 for a sorted table               */
+    } CAN_Dispatch_IDs;
+
+    /* Acceptance filter dispatch functions */
+    void CAN_Dispatch_Filters_Init( CAN_Dispatch_Filters *dispatch, CAN_Dispatch_Handler fallback, void *context );
+    void CAN_Dispatch_Register_Filter( CAN_Dispatch_Filters *dispatch, uint8_t filter, CAN_Dispatch_Handler handler, void *context );
+    void CAN_Dispatch_By_Filter( const CAN_Dispatch_Filters *dispatch, const CAN_Control_Frame *frame );
+    uint16_t CAN_Dispatch_Receive( CAN_Control_HandleTypeDef *hcan, const CAN_Dispatch_Filters *dispatch );
+
+    /* ID dispatch functions */
+    const CAN_Dispatch_ID_Entry *CAN_Dispatch_Find_ID( const CAN_Dispatch_IDs *ids, uint32_t id, uint8_t extended );
+    uint8_t CAN_Dispatch_By_ID( const CAN_Dispatch_IDs *ids, const CAN_Control_Frame *frame );
+
+#endif
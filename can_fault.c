@@ -0,0 +1,278 @@
+/**
+ * @file      can_fault.c
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the function implementations for the fault confinement manager, which tracks the
+ *            error state of a CAN Controller (MCP2515) and brings it back to the bus after a bus-off without user intervention.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ *            CAN_Fault_ERR_IRQ() must be called when the ERRIF interrupt flag is set and CAN_Fault_Process() periodically
+ *            (e.g. from the main loop), timestamps are taken from the TIM1 timebase (refer to TIM1_ETR_Init()).
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#include "can_fault.h"
+
+/**
+ * @brief Get the fault confinement state that corresponds to the given EFLG register value.
+ * 
+ * @param eflg     EFLG register value
+ * @return uint8_t fault confinement state. Refer to 'Fault confinement state definitions' in can_fault.h
+ */
+static uint8_t CAN_Fault_Get_State( uint8_t eflg )
+{
+    uint8_t state = FAULT_ERROR_ACTIVE;
+
+    if ( ( eflg & TXB0_BUS_OFF_ERROR ) == TXB0_BUS_OFF_ERROR )
+    {
+        state = FAULT_BUS_OFF;
+    }
+    else if ( ( eflg & ( TXEP_TEC_GREATER_127 | RXEP_REC_GREATER_127 ) ) != 0U )
+    {
+        state = FAULT_ERROR_PASSIVE;
+    }
+    else if ( ( eflg & EWARN_TEC_OR_REC_GREATER_95 ) == EWARN_TEC_OR_REC_GREATER_95 )
+    {
+        state = FAULT_ERROR_WARNING;
+    }
+    else
+    {
+        /* Do nothing, error-active */
+    }
+
+    return state;
+}
+
+/**
+ * @brief Move the manager to the given state and record the transition in the event log.
+ * 
+ * @param mgr   pointer to the fault confinement manager
+ * @param state new state. Refer to 'Fault confinement state definitions' in can_fault.h
+ * @param eflg  EFLG register value that caused the transition
+ */
+static void CAN_Fault_Set_State( CAN_Fault_Manager *mgr, uint8_t state, uint8_t eflg )
+{
+    if ( state != mgr->state )
+    {
+        mgr->log[ mgr->logindex ].timestamp = TIM1_Get_Ticks();
+        mgr->log[ mgr->logindex ].from      = mgr->state;
+        mgr->log[ mgr->logindex ].to        = state;
+        mgr->log[ mgr->logindex ].eflg      = eflg;
+
+        if ( ++mgr->logindex == FAULT_LOG_SIZE )
+        {
+            mgr->logindex = 0U;
+        }
+
+        mgr->state = state;
+    }
+}
+
+/**
+ * @brief Bring the MCP2515 back to the bus: going through configuration mode clears the TEC and REC counters
+ *        (back to error-active), then the operation mode selected by user is restored and the TX buffers
+ *        flushed at bus-off are requested for transmission again (their contents are kept by the MCP2515).
+ * 
+ * @param mgr pointer to the fault confinement manager
+ */
+static void CAN_Fault_Recover( CAN_Fault_Manager *mgr )
+{
+    CAN_Control_Set_Op_Mode_Wait( mgr->hcan, CONFIGURATION_OP_MODE, CAN_OPMODE_TIMEOUT_US );
+    CAN_Control_Set_Op_Mode( mgr->hcan, mgr->hcan->opmode );
+
+    if ( ( mgr->pendingtx & TXB0 ) == TXB0 )
+    {
+        CAN_Control_Register_Bit( mgr->hcan, TXB0CTRL_REG, TXREQ_PENDING, TXREQ_PENDING );
+    }
+
+    if ( ( mgr->pendingtx & TXB1 ) == TXB1 )
+    {
+        CAN_Control_Register_Bit( mgr->hcan, TXB1CTRL_REG, TXREQ_PENDING, TXREQ_PENDING );
+    }
+
+    if ( ( mgr->pendingtx & TXB2 ) == TXB2 )
+    {
+        CAN_Control_Register_Bit( mgr->hcan, TXB2CTRL_REG, TXREQ_PENDING, TXREQ_PENDING );
+    }
+
+    mgr->pendingtx    = 0U;
+    mgr->recoverytick = TIM1_Get_Ticks();
+    /* Saturate, a wrap to 0 would restart the backoff from 'delayms' */
+    if ( mgr->retries < 0xFFU )
+    {
+        mgr->retries++;
+    }
+
+    CAN_Fault_Set_State( mgr, FAULT_ERROR_ACTIVE, 0U );
+}
+
+/**
+ * @brief Handle a bus-off: remember and abort the pending transmissions (a mode change does not complete while
+ *        transmissions are pending) and schedule the recovery according to the policy.
+ * 
+ * @param mgr  pointer to the fault confinement manager
+ * @param eflg EFLG register value
+ */
+static void CAN_Fault_Bus_Off( CAN_Fault_Manager *mgr, uint8_t eflg )
+{
+    uint8_t txbctrl[ 3 ];
+
+    mgr->busofftick = TIM1_Get_Ticks();
+    mgr->busoffcount++;
+    CAN_Fault_Set_State( mgr, FAULT_BUS_OFF, eflg );
+
+    /* Flush the pending transmissions, they are requeued at recovery */
+    CAN_Control_Register_Read( mgr->hcan, TXB0CTRL_REG, &txbctrl[ 0 ], 1U );
+    CAN_Control_Register_Read( mgr->hcan, TXB1CTRL_REG, &txbctrl[ 1 ], 1U );
+    CAN_Control_Register_Read( mgr->hcan, TXB2CTRL_REG, &txbctrl[ 2 ], 1U );
+
+    mgr->pendingtx = ( ( txbctrl[ 0 ] & TXREQ_PENDING ) ? TXB0 : 0U ) |
+                     ( ( txbctrl[ 1 ] & TXREQ_PENDING ) ? TXB1 : 0U ) |
+                     ( ( txbctrl[ 2 ] & TXREQ_PENDING ) ? TXB2 : 0U );
+
+    CAN_Control_TX_CAN_Abort_All( mgr->hcan );
+
+    /* Schedule the recovery */
+    switch ( mgr->policy )
+    {
+        case FAULT_POLICY_BACKOFF:
+            /* First bus-off waits 'delayms', every consecutive one doubles it up to 'maxdelayms' */
+            mgr->backoffms = ( mgr->retries == 0U ) ? mgr->delayms : ( mgr->backoffms << 1 );
+
+            if ( mgr->backoffms > mgr->maxdelayms )
+            {
+                mgr->backoffms = mgr->maxdelayms;
+            }
+            break;
+
+        case FAULT_POLICY_RETRIES:
+            mgr->backoffms = mgr->delayms;
+
+            /* Too many consecutive bus-offs, stay off the bus */
+            if ( mgr->retries >= mgr->maxretries )
+            {
+                CAN_Control_Set_Op_Mode( mgr->hcan, CONFIGURATION_OP_MODE );
+                CAN_Fault_Set_State( mgr, FAULT_OFFLINE, eflg );
+            }
+            break;
+
+        default:
+            /* FAULT_POLICY_IMMEDIATE */
+            CAN_Fault_Recover( mgr );
+            break;
+    }
+}
+
+/**
+ * @brief Initialize the fault confinement manager according to the configuration set by user (hcan, policy, maxretries,
+ *        delayms, maxdelayms and ticksperms), read the current error state and enable the error interrupt (ERRIE)
+ *        without modifying any other interrupt enabled in CANINTE.
+ * 
+ * @param mgr pointer to the fault confinement manager
+ */
+void CAN_Fault_Init( CAN_Fault_Manager *mgr )
+{
+    uint8_t i;
+
+    for ( i = 0U; i < FAULT_LOG_SIZE; i++ )
+    {
+        mgr->log[ i ].timestamp = 0U;
+        mgr->log[ i ].from      = FAULT_ERROR_ACTIVE;
+        mgr->log[ i ].to        = FAULT_ERROR_ACTIVE;
+        mgr->log[ i ].eflg      = 0U;
+    }
+
+    mgr->state       = FAULT_ERROR_ACTIVE;
+    mgr->retries     = 0U;
+    mgr->pendingtx   = 0U;
+    mgr->backoffms   = 0U;
+    mgr->busofftick   = 0U;
+    mgr->recoverytick = 0U;
+    mgr->busoffcount  = 0U;
+    mgr->logindex    = 0U;
+
+    /* Enable the error interrupt (ERRIE bit in CANINTE) */
+    CAN_Control_Register_Bit( mgr->hcan, CANINTE_REG, ERRIE_ERROR_INTERRUPT_ENABLED, ERRIE_ERROR_INTERRUPT_ENABLED );
+
+    /* Start from the current error state */
+    CAN_Fault_ERR_IRQ( mgr );
+}
+
+/**
+ * @brief Handle an error interrupt (ERRIF) of the supervised MCP2515: read EFLG, update the state and, on bus-off,
+ *        flush the pending transmissions and apply the recovery policy. The ERRIF flag is cleared here.
+ * 
+ * @param mgr pointer to the fault confinement manager
+ */
+void CAN_Fault_ERR_IRQ( CAN_Fault_Manager *mgr )
+{
+    uint8_t eflg  = CAN_Control_ERR_Status( mgr->hcan );
+    uint8_t state = CAN_Fault_Get_State( eflg );
+
+    /* Clear the error interrupt flag (ERRIF bit in CANINTF) */
+    CAN_Control_Clear_INT_Status( mgr->hcan, ERRIE_ERROR_INTERRUPT_ENABLED );
+
+    /* A node taken offline by the RETRIES policy stays so */
+    if ( mgr->state == FAULT_OFFLINE )
+    {
+        return;
+    }
+
+    if ( state == FAULT_BUS_OFF )
+    {
+        /* Bus-off is handled only once, until the node recovers */
+        if ( mgr->state != FAULT_BUS_OFF )
+        {
+            CAN_Fault_Bus_Off( mgr, eflg );
+        }
+    }
+    else
+    {
+        CAN_Fault_Set_State( mgr, state, eflg );
+    }
+}
+
+/**
+ * @brief Periodic processing of the fault confinement manager: perform the scheduled bus-off recovery once its delay
+ *        has elapsed and follow the error counters back down (the MCP2515 does not interrupt when they decrease).
+ *        Recovery is bounded by 'maxdelayms' (BACKOFF) or 'delayms' (RETRIES) after the bus-off.
+ * 
+ *        A recovery is considered successful once the node stays out of bus-off for FAULT_STABLE_MS,
+ *        which resets the consecutive bus-off count used by the BACKOFF and RETRIES policies.
+ * 
+ * @param mgr pointer to the fault confinement manager
+ */
+void CAN_Fault_Process( CAN_Fault_Manager *mgr )
+{
+    /* Node stayed on the bus long enough after its last recovery */
+    if ( ( mgr->retries != 0U ) && ( mgr->state <= FAULT_ERROR_PASSIVE ) &&
+         ( ( TIM1_Get_Ticks() - mgr->recoverytick ) >= ( FAULT_STABLE_MS * mgr->ticksperms ) ) )
+    {
+        mgr->retries = 0U;
+    }
+
+    switch ( mgr->state )
+    {
+        case FAULT_BUS_OFF:
+            /* Recovery delay elapsed */
+            if ( ( TIM1_Get_Ticks() - mgr->busofftick ) >= ( mgr->backoffms * mgr->ticksperms ) )
+            {
+                CAN_Fault_Recover( mgr );
+            }
+            break;
+
+        case FAULT_ERROR_WARNING:
+        case FAULT_ERROR_PASSIVE:
+            /* Re-evaluate the state as the error counters decrease */
+            CAN_Fault_ERR_IRQ( mgr );
+            break;
+
+        default:
+            /* Do nothing: error-active or offline */
+            break;
+    }
+}
@@ -0,0 +1,80 @@
+/**
+ * @file      can_fault.h
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the definitions and function prototypes for the fault confinement manager, which tracks the
+ *            error state of a CAN Controller (MCP2515) and brings it back to the bus after a bus-off without user intervention.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#ifndef CAN_FAULT_H
+#define CAN_FAULT_H
+
+    #include <stdint.h>
+    #include "stm32f0xx.h"
+    #include "timer.h"
+    #include "can.h"
+
+    /* Fault confinement state definitions */
+    #define FAULT_ERROR_ACTIVE                  (0x00U)
+    #define FAULT_ERROR_WARNING                 (0x01U)
+    #define FAULT_ERROR_PASSIVE                 (0x02U)
+    #define FAULT_BUS_OFF                       (0x03U)
+    #define FAULT_OFFLINE                       (0x04U)
+
+    /* Bus-off recovery policy definitions:
+       - IMMEDIATE: rejoin the bus as soon as bus-off is detected.
+       - BACKOFF:   rejoin after 'delayms', doubled on every consecutive bus-off up to 'maxdelayms'.
+       - RETRIES:   rejoin after 'delayms' up to 'maxretries' consecutive times, then stay offline (configuration mode) */
+    #define FAULT_POLICY_IMMEDIATE              (0x00U)
+    #define FAULT_POLICY_BACKOFF                (0x01U)
+    #define FAULT_POLICY_RETRIES                (0x02U)
+
+    /* Time in milliseconds a node must stay out of bus-off after a recovery for it to be considered successful */
+    #define FAULT_STABLE_MS                     (1000U)
+
+    /* Number of state transitions kept in the fault event log */
+    #define FAULT_LOG_SIZE                      (8U)
+
+    /* Structure that holds a fault confinement state transition */
+    typedef struct
+    {
+        uint32_t timestamp;        /* TIM1 ticks when the transition occurred (refer to TIM1_Get_Ticks())    */
+        uint8_t  from;             /* Previous state (refer to 'Fault confinement state definitions')        */
+        uint8_t  to;               /* New state (refer to 'Fault confinement state definitions')             */
+        uint8_t  eflg;             /* EFLG register value that caused the transition                         */
+    } CAN_Fault_Event;
+
+    /* Structure that holds the configuration and state of the fault confinement manager of one MCP2515 */
+    typedef struct
+    {
+        CAN_Control_HandleTypeDef *hcan;                   /* CAN Controller supervised by this manager                       */
+        uint8_t                   policy;                  /* Bus-off recovery policy (refer to 'Bus-off recovery policy')    */
+        uint8_t                   maxretries;              /* Consecutive recoveries before going offline (RETRIES policy)    */
+        uint32_t                  delayms;                 /* Recovery delay in milliseconds (BACKOFF and RETRIES policies)   */
+        uint32_t                  maxdelayms;              /* Longest recovery delay in milliseconds (BACKOFF policy)         */
+        uint32_t                  ticksperms;              /* TIM1 ticks per millisecond (refer to GET_CLKOUT_FREQ())         */
+        uint8_t                   state;                   /* Current state (refer to 'Fault confinement state definitions')  */
+        uint8_t                   retries;                 /* Consecutive bus-off recoveries, up to 255 (FAULT_STABLE_MS)   */
+        uint8_t                   pendingtx;               /* TX buffers flushed at bus-off, requeued at recovery             */
+        uint32_t                  backoffms;               /* Delay of the recovery in progress, in milliseconds              */
+        uint32_t                  busofftick;              /* TIM1 ticks when the last bus-off was detected                   */
+        uint32_t                  recoverytick;            /* TIM1 ticks when the last bus-off recovery was performed         */
+        uint32_t                  busoffcount;             /* Number of bus-off events since initialization                   */
+        uint8_t                   logindex;                /* Next entry to be written in the event log                       */
+        CAN_Fault_Event           log[ FAULT_LOG_SIZE ];   /* Last state transitions (circular)                               */
+    } CAN_Fault_Manager;
+
+    /* Fault confinement manager initialization function */
+    void CAN_Fault_Init( CAN_Fault_Manager *mgr );
+
+    /* Fault confinement manager error interrupt and periodic processing functions */
+    void CAN_Fault_ERR_IRQ( CAN_Fault_Manager *mgr );
+    void CAN_Fault_Process( CAN_Fault_Manager *mgr );
+
+#endif
@@ -0,0 +1,599 @@
+/**
+ * @file      can_filter.c
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the CAN acceptance filter optimizer. The accepted ID ranges are split into aligned blocks
+ *            (a value and the bits that must match), the blocks are merged pairwise at the lowest cost until six are left,
+ *            and the six filters are then spread over RXB0 (2 filters) and RXB1 (4 filters), each buffer sharing a mask.
+ *            The cost of a block is the unwanted measured traffic it lets through, or the number of IDs it accepts when
+ *            no traffic is given.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#include <stddef.h>
+#include "can_filter.h"
+
+/* Build-time check of the software filter hash table size */
+typedef char can_filter_sw_size_check[ ( ( CAN_FILTER_SW_EXT_SIZE >= 4U ) && ( CAN_FILTER_SW_EXT_SIZE <= 256U ) &&
+                                         ( ( CAN_FILTER_SW_EXT_SIZE & ( CAN_FILTER_SW_EXT_SIZE - 1U ) ) == 0U ) ) ? 1 : -1 ];
+
+/* Structure that holds an aligned block of IDs in the 29-bit SID:EID register layout */
+typedef struct
+{
+    uint32_t value;    /* ID bits (only the 'care' bits are meaningful) */
+    uint32_t care;     /* Bits that must match                          */
+    uint8_t  extended; /* 1 for extended IDs, 0 for standard IDs        */
+} CAN_Filter_Term;
+
+/* Structure that holds the optimizer inputs */
+typedef struct
+{
+    const CAN_Filter_Range   *ranges;
+    const CAN_Filter_Traffic *traffic;
+    uint16_t                  trafficcount;
+    uint8_t                   count;
+} CAN_Filter_Context;
+
+/**
+ * @brief Get the 29-bit register layout of a CAN ID (standard IDs occupy the SID bits only).
+ */
+static uint32_t CAN_Filter_Layout( uint32_t id, uint8_t extended )
+{
+    return ( id << CAN_ID_LAYOUT_SHIFT( extended ) ) & CAN_FILTER_ID_MASK;
+}
+
+/**
+ * @brief Get the number of IDs accepted by a block, that is 2 to the power of its don't care ID bits.
+ */
+static uint32_t CAN_Filter_Size( uint32_t care, uint8_t extended )
+{
+    uint32_t dontcare = ( ( extended == 1U ) ? CAN_FILTER_ID_MASK : CAN_FILTER_SID_MASK ) & ~care;
+    uint8_t  bits     = 0U;
+
+    while ( dontcare != 0U )
+    {
+        dontcare &= dontcare - 1U;
+        bits++;
+    }
+
+    return 1UL << bits;
+}
+
+/**
+ * @brief Check whether a CAN ID belongs to the accept-list.
+ */
+static uint8_t CAN_Filter_Wanted( const CAN_Filter_Context *ctx, uint32_t id, uint8_t extended )
+{
+    uint8_t i;
+
+    for ( i = 0U; i < ctx->count; i++ )
+    {
+        if ( ( ctx->ranges[ i ].extended == extended ) && ( id >= ctx->ranges[ i ].first ) && ( id <= ctx->ranges[ i ].last ) )
+        {
+            return 1U;
+        }
+    }
+
+    return 0U;
+}
+
+/**
+ * @brief Get the cost of accepting a block with the given mask: the unwanted measured traffic let through (rate)
+ *        and the number of IDs accepted (size). Costs are compared by rate first and by size second.
+ */
+static void CAN_Filter_Cost( const CAN_Filter_Context *ctx, uint32_t value, uint32_t care, uint8_t extended, int64_t *rate, int64_t *size )
+{
+    uint16_t i;
+
+    *size = ( int64_t )CAN_Filter_Size( care, extended );
+    *rate = 0;
+
+    for ( i = 0U; i < ctx->trafficcount; i++ )
+    {
+        if ( ( ctx->traffic[ i ].extended == extended ) &&
+             ( ( ( CAN_Filter_Layout( ctx->traffic[ i ].id, extended ) ^ value ) & care ) == 0U ) &&
+             ( CAN_Filter_Wanted( ctx, ctx->traffic[ i ].id, extended ) == 0U ) )
+        {
+            *rate += ( int64_t )ctx->traffic[ i ].rate;
+        }
+    }
+}
+
+/**
+ * @brief Merge the pair of blocks of the same ID type whose union adds the lowest cost, reducing the number of blocks by one.
+ */
+static void CAN_Filter_Merge_Best( const CAN_Filter_Context *ctx, CAN_Filter_Term *terms, uint8_t *count )
+{
+    int64_t ratei, sizei, ratej, sizej, rate, size;
+    int64_t bestrate = INT64_MAX;
+    int64_t bestsize = INT64_MAX;
+    uint8_t besti    = 0U;
+    uint8_t bestj    = 0U;
+    uint32_t care;
+    uint8_t i, j;
+
+    for ( i = 0U; i < *count; i++ )
+    {
+        CAN_Filter_Cost( ctx, terms[ i ].value, terms[ i ].care, terms[ i ].extended, &ratei, &sizei );
+
+        for ( j = i + 1U; j < *count; j++ )
+        {
+            if ( terms[ i ].extended != terms[ j ].extended )
+            {
+                continue;
+            }
+
+            /* The merged block only keeps the bits both blocks care about and agree on */
+            care = terms[ i ].care & terms[ j ].care & ~( terms[ i ].value ^ terms[ j ].value );
+
+            CAN_Filter_Cost( ctx, terms[ j ].value, terms[ j ].care, terms[ j ].extended, &ratej, &sizej );
+            CAN_Filter_Cost( ctx, terms[ i ].value & care, care, terms[ i ].extended, &rate, &size );
+
+            rate -= ratei + ratej;
+            size -= sizei + sizej;
+
+            if ( ( rate < bestrate ) || ( ( rate == bestrate ) && ( size < bestsize ) ) )
+            {
+                bestrate = rate;
+                bestsize = size;
+                besti    = i;
+                bestj    = j;
+            }
+        }
+    }
+
+    /* Replace block i by the union and block j by the last block */
+    terms[ besti ].care  &= terms[ bestj ].care & ~( terms[ besti ].value ^ terms[ bestj ].value );
+    terms[ besti ].value &= terms[ besti ].care;
+    terms[ bestj ]        = terms[ *count - 1U ];
+    ( *count )--;
+}
+
+/**
+ * @brief Get the shared mask of the blocks selected for a RX buffer and the cost of accepting all of them with it.
+ *        Standard frames compare the EID mask bits against their first two data bytes, so a buffer holding any
+ *        standard block only masks the SID bits.
+ */
+static void CAN_Filter_Buffer_Cost( const CAN_Filter_Context *ctx, const CAN_Filter_Term *terms, uint8_t count, uint8_t select,
+                                    uint32_t *mask, int64_t *rate, int64_t *size )
+{
+    int64_t termrate, termsize;
+    uint8_t i;
+
+    *mask = CAN_FILTER_ID_MASK;
+    *rate = 0;
+    *size = 0;
+
+    for ( i = 0U; i < count; i++ )
+    {
+        if ( ( select & ( 1U << i ) ) != 0U )
+        {
+            *mask &= ( terms[ i ].extended == 1U ) ? terms[ i ].care : ( terms[ i ].care & CAN_FILTER_SID_MASK );
+        }
+    }
+
+    for ( i = 0U; i < count; i++ )
+    {
+        if ( ( select & ( 1U << i ) ) != 0U )
+        {
+            CAN_Filter_Cost( ctx, terms[ i ].value & *mask, *mask, terms[ i ].extended, &termrate, &termsize );
+            *rate += termrate;
+            *size += termsize;
+        }
+    }
+}
+
+/**
+ * @brief Compute the MCP2515 masks and filters that accept every ID of the accept-list while letting through as little
+ *        unwanted traffic as possible.
+ * 
+ *        Note: the result is meant for RX buffers receiving valid messages (RXM bits = 00) with RXB0 rollover enabled
+ *              if RXB1 must also catch the frames accepted by RXF0 and RXF1 when RXB0 is full.
+ * 
+ * @param ranges       array of ID ranges to be accepted
+ * @param count        number of ID ranges (at least 1)
+ * @param traffic      array of measured per-ID bus rates, NULL if not available
+ * @param trafficcount number of measured IDs (0 if 'traffic' is NULL)
+ * @param result       pointer to the structure where the settings and the residual false-accept figures are stored
+ * @param residual     array where the unwanted measured IDs let through by the settings are stored (may be NULL)
+ * @param maxresidual  size of the 'residual' array
+ * @return uint8_t     1 if the settings were computed, 0 if the accept-list is empty
+ */
+uint8_t CAN_Filter_Optimize( const CAN_Filter_Range *ranges, uint8_t count, const CAN_Filter_Traffic *traffic, uint16_t trafficcount,
+                             CAN_Filter_Result *result, CAN_Filter_Traffic *residual, uint16_t maxresidual )
+{
+    CAN_Filter_Context ctx;
+    CAN_Filter_Term    terms[ CAN_FILTER_MAX_TERMS ];
+    uint8_t            nterms = 0U;
+    uint32_t           first, last, limit, block, wantedsize = 0U, acceptedsize = 0U;
+    uint32_t           mask0, mask1, bestmask0 = 0U, bestmask1 = 0U;
+    int64_t            rate0, size0, rate1, size1;
+    int64_t            bestrate = INT64_MAX;
+    int64_t            bestsize = INT64_MAX;
+    uint8_t            bestselect = 0U;
+    uint8_t            select, selected, slot, rxb0, rxb1, i, j;
+
+    ctx.ranges       = ranges;
+    ctx.count        = count;
+    ctx.traffic      = traffic;
+    ctx.trafficcount = ( traffic == NULL ) ? 0U : trafficcount;
+
+    if ( count == 0U )
+    {
+        return 0U;
+    }
+
+    /* Split every range into the largest aligned blocks it holds */
+    for ( i = 0U; i < count; i++ )
+    {
+        limit = ( ranges[ i ].extended == 1U ) ? ( CAN_FILTER_ID_MASK ) : ( CAN_FILTER_SID_MASK >> 18 );
+        first = ( ranges[ i ].first > limit ) ? limit : ranges[ i ].first;
+        last  = ( ranges[ i ].last  > limit ) ? limit : ranges[ i ].last;
+        last  = ( last < first ) ? first : last;
+
+        wantedsize += last - first + 1U;
+
+        while ( 1 )
+        {
+            block = 1U;
+
+            while ( ( ( first & ( ( block << 1 ) - 1U ) ) == 0U ) && ( ( first + ( block << 1 ) - 1U ) <= last ) )
+            {
+                block <<= 1;
+            }
+
+            /* Keep the number of blocks bounded by merging the cheapest pair once the table is full */
+            if ( nterms == CAN_FILTER_MAX_TERMS )
+            {
+                CAN_Filter_Merge_Best( &ctx, terms, &nterms );
+            }
+
+            terms[ nterms ].extended = ranges[ i ].extended;
+            terms[ nterms ].care     = ( ( ranges[ i ].extended == 1U ) ? CAN_FILTER_ID_MASK : CAN_FILTER_SID_MASK ) &
+                                       ~CAN_Filter_Layout( block - 1U, ranges[ i ].extended );
+            terms[ nterms ].value    = CAN_Filter_Layout( first, ranges[ i ].extended );
+            nterms++;
+
+            if ( ( last - first ) < block )
+            {
+                break;
+            }
+
+            first += block;
+        }
+    }
+
+    /* Merge down to one block per hardware filter */
+    while ( nterms > CAN_FILTER_HW_FILTERS )
+    {
+        CAN_Filter_Merge_Best( &ctx, terms, &nterms );
+    }
+
+    /* Try every split of the blocks between RXB0 (up to 2) and RXB1 (up to 4) and keep the cheapest one */
+    for ( select = 0U; select < ( 1U << nterms ); select++ )
+    {
+        selected = 0U;
+
+        for ( i = 0U; i < nterms; i++ )
+        {
+            selected += ( select >> i ) & 0x01U;
+        }
+
+        if ( ( selected > CAN_FILTER_RXB0_FILTERS ) || ( ( uint8_t )( nterms - selected ) > CAN_FILTER_RXB1_FILTERS ) )
+        {
+            continue;
+        }
+
+        CAN_Filter_Buffer_Cost( &ctx, terms, nterms, select, &mask0, &rate0, &size0 );
+        CAN_Filter_Buffer_Cost( &ctx, terms, nterms, ( uint8_t )~select, &mask1, &rate1, &size1 );
+
+        if ( ( ( rate0 + rate1 ) < bestrate ) || ( ( ( rate0 + rate1 ) == bestrate ) && ( ( size0 + size1 ) < bestsize ) ) )
+        {
+            bestrate   = rate0 + rate1;
+            bestsize   = size0 + size1;
+            bestselect = select;
+            bestmask0  = mask0;
+            bestmask1  = mask1;
+        }
+    }
+
+    /* Fill the filters of each buffer, repeating its first block in the unused filters.
+       A buffer without blocks keeps a full mask and gets a filter that only matches an ID already accepted by the other one */
+    rxb0 = 0U;
+    rxb1 = CAN_FILTER_RXB0_FILTERS;
+
+    result->filters.extendedidenable = 0U;
+
+    for ( i = 0U; i < nterms; i++ )
+    {
+        slot = ( ( bestselect & ( 1U << i ) ) != 0U ) ? rxb0++ : rxb1++;
+
+        result->filters.rxfiltervalue[ slot ]  = terms[ i ].value & ( ( slot < CAN_FILTER_RXB0_FILTERS ) ? bestmask0 : bestmask1 );
+        result->filters.extendedidenable      |= ( uint8_t )( terms[ i ].extended << slot );
+    }
+
+    for ( slot = 0U; slot < CAN_FILTER_HW_FILTERS; slot++ )
+    {
+        /* Source filter: first filter of the same buffer if it has any block, first filter of the other buffer if not */
+        if ( slot < CAN_FILTER_RXB0_FILTERS )
+        {
+            j = ( rxb0 == 0U ) ? CAN_FILTER_RXB0_FILTERS : 0U;
+            i = ( slot >= rxb0 ) ? 1U : 0U;
+        }
+        else
+        {
+            j = ( rxb1 == CAN_FILTER_RXB0_FILTERS ) ? 0U : CAN_FILTER_RXB0_FILTERS;
+            i = ( slot >= rxb1 ) ? 1U : 0U;
+        }
+
+        if ( i == 1U )
+        {
+            result->filters.rxfiltervalue[ slot ]  = result->filters.rxfiltervalue[ j ];
+            result->filters.extendedidenable      |= ( uint8_t )( ( ( result->filters.extendedidenable >> j ) & 0x01U ) << slot );
+        }
+    }
+
+    result->filters.rxfilternmbr = RXF0 | RXF1 | RXF2 | RXF3 | RXF4 | RXF5;
+    result->masks.rxmasknmbr     = RXM0 | RXM1;
+    result->masks.rxmaskvalue[ 0 ] = bestmask0;
+    result->masks.rxmaskvalue[ 1 ] = bestmask1;
+
+    /* Residual false accepts: IDs let through by the distinct filters beyond the accept-list ... */
+    for ( slot = 0U; slot < CAN_FILTER_HW_FILTERS; slot++ )
+    {
+        for ( j = ( slot < CAN_FILTER_RXB0_FILTERS ) ? 0U : CAN_FILTER_RXB0_FILTERS; j < slot; j++ )
+        {
+            if ( ( result->filters.rxfiltervalue[ j ] == result->filters.rxfiltervalue[ slot ] ) &&
+                 ( ( ( result->filters.extendedidenable >> j ) & 0x01U ) == ( ( result->filters.extendedidenable >> slot ) & 0x01U ) ) )
+            {
+                break;
+            }
+        }
+
+        if ( j == slot )
+        {
+            acceptedsize += CAN_Filter_Size( ( slot < CAN_FILTER_RXB0_FILTERS ) ? bestmask0 : bestmask1,
+                                             ( result->filters.extendedidenable >> slot ) & 0x01U );
+        }
+    }
+
+    result->falseaccepts  = ( acceptedsize > wantedsize ) ? ( acceptedsize - wantedsize ) : 0U;
+    result->falserate     = 0U;
+    result->residualcount = 0U;
+
+    /* ... and the unwanted measured IDs that software filtering must still discard */
+    for ( i = 0U; i < ctx.trafficcount; i++ )
+    {
+        if ( ( CAN_Filter_HW_Accepts( result, traffic[ i ].id, traffic[ i ].extended ) == 1U ) &&
+             ( CAN_Filter_Wanted( &ctx, traffic[ i ].id, traffic[ i ].extended ) == 0U ) )
+        {
+            result->falserate += traffic[ i ].rate;
+
+            if ( ( residual != NULL ) && ( result->residualcount < maxresidual ) )
+            {
+                residual[ result->residualcount ] = traffic[ i ];
+            }
+
+            result->residualcount++;
+        }
+    }
+
+    return 1U;
+}
+
+/**
+ * @brief Check whether the computed settings let a CAN ID through (data bytes of standard frames are not considered).
+ * 
+ * @param result   pointer to the settings computed by CAN_Filter_Optimize()
+ * @param id       CAN ID
+ * @param extended 1 if the ID is extended, 0 if it is standard
+ * @return uint8_t 1 if any filter accepts the ID, 0 if not
+ */
+uint8_t CAN_Filter_HW_Accepts( const CAN_Filter_Result *result, uint32_t id, uint8_t extended )
+{
+    uint32_t layout = CAN_Filter_Layout( id, extended );
+    uint32_t mask;
+    uint8_t  slot;
+
+    for ( slot = 0U; slot < CAN_FILTER_HW_FILTERS; slot++ )
+    {
+        mask = result->masks.rxmaskvalue[ ( slot < CAN_FILTER_RXB0_FILTERS ) ? 0U : 1U ];
+        mask = ( extended == 1U ) ? mask : ( mask & CAN_FILTER_SID_MASK );
+
+        if ( ( ( ( result->filters.extendedidenable >> slot ) & 0x01U ) == extended ) &&
+             ( ( ( layout ^ result->filters.rxfiltervalue[ slot ] ) & mask ) == 0U ) )
+        {
+            return 1U;
+        }
+    }
+
+    return 0U;
+}
+
+/**
+ * @brief Get the home slot of an extended ID in the software filter hash table (Fibonacci hashing, the Cortex-M0
+ *        of the STM32F070 multiplies in a single cycle).
+ */
+static uint8_t CAN_Filter_SW_Hash( uint32_t id )
+{
+    return ( uint8_t )( ( ( id * 2654435761UL ) >> 24 ) & ( CAN_FILTER_SW_EXT_SIZE - 1U ) );
+}
+
+/**
+ * @brief Empty the software filter (every frame is discarded) and clear its counters.
+ * 
+ * @param filter pointer to the software filter
+ */
+void CAN_Filter_SW_Init( CAN_Filter_SW *filter )
+{
+    uint16_t i;
+
+    for ( i = 0U; i < 256U; i++ )
+    {
+        filter->stdbitmap[ i ] = 0U;
+    }
+
+    for ( i = 0U; i < CAN_FILTER_SW_EXT_SIZE; i++ )
+    {
+        filter->exttable[ i ] = CAN_FILTER_SW_EMPTY;
+    }
+
+    filter->extcount = 0U;
+    filter->accepted = 0U;
+    filter->rejected = 0U;
+}
+
+/**
+ * @brief Add a CAN ID to the software filter.
+ * 
+ * @param filter   pointer to the software filter
+ * @param id       CAN ID
+ * @param extended 1 if the ID is extended, 0 if it is standard
+ * @return uint8_t 1 if the ID is accepted from now on, 0 if the extended ID hash table is full
+ */
+uint8_t CAN_Filter_SW_Add( CAN_Filter_SW *filter, uint32_t id, uint8_t extended )
+{
+    uint8_t slot;
+
+    /* Standard IDs: set the ID bit */
+    if ( extended == 0U )
+    {
+        id &= CAN_FILTER_SID_MASK >> 18;
+        filter->stdbitmap[ id >> 3 ] |= ( uint8_t )( 1U << ( id & 0x07U ) );
+
+        return 1U;
+    }
+
+    id  &= CAN_FILTER_ID_MASK;
+    slot = CAN_Filter_SW_Hash( id );
+
+    /* Extended IDs: probe from the home slot until the ID or an empty entry is found */
+    while ( filter->exttable[ slot ] != CAN_FILTER_SW_EMPTY )
+    {
+        if ( filter->exttable[ slot ] == id )
+        {
+            return 1U;
+        }
+
+        slot = ( slot + 1U ) & ( CAN_FILTER_SW_EXT_SIZE - 1U );
+    }
+
+    /* Keep the load factor at 3/4 or below so that probe sequences stay short */
+    if ( filter->extcount >= ( ( CAN_FILTER_SW_EXT_SIZE * 3U ) / 4U ) )
+    {
+        return 0U;
+    }
+
+    filter->exttable[ slot ] = id;
+    filter->extcount++;
+
+    return 1U;
+}
+
+/**
+ * @brief Add every ID of the given ranges to the software filter (the same accept-list given to CAN_Filter_Optimize()).
+ *        Ranges are clamped to the last ID of their type (0x7FF for standard IDs, 0x1FFFFFFF for extended IDs),
+ *        so out-of-range IDs are not folded onto unrelated accepted IDs.
+ * 
+ * @param filter   pointer to the software filter
+ * @param ranges   array of ID ranges to be accepted
+ * @param count    number of ID ranges
+ * @return uint8_t 1 if every ID was added, 0 if the extended ID hash table got full
+ */
+uint8_t CAN_Filter_SW_Add_Ranges( CAN_Filter_SW *filter, const CAN_Filter_Range *ranges, uint8_t count )
+{
+    uint32_t id, last, limit;
+    uint8_t  i;
+
+    for ( i = 0U; i < count; i++ )
+    {
+        limit = ( ranges[ i ].extended == 1U ) ? ( CAN_FILTER_ID_MASK ) : ( CAN_FILTER_SID_MASK >> 18 );
+        last  = ( ranges[ i ].last > limit ) ? limit : ranges[ i ].last;
+
+        /* IDs above the limit do not exist for this ID type (the loop never wraps around, last <= 0x1FFFFFFF) */
+        for ( id = ranges[ i ].first; id <= last; id++ )
+        {
+            if ( CAN_Filter_SW_Add( filter, id, ranges[ i ].extended ) == 0U )
+            {
+                return 0U;
+            }
+        }
+    }
+
+    return 1U;
+}
+
+/**
+ * @brief Check a received CAN frame against the software filter and update the accept and reject counters.
+ *        Standard IDs cost a single bitmap lookup and extended IDs a short hash table probe.
+ * 
+ * @param filter   pointer to the software filter
+ * @param frame    pointer to the received CAN frame
+ * @return uint8_t 1 if the frame is accepted, 0 if it must be discarded
+ */
+uint8_t CAN_Filter_SW_Accepts( CAN_Filter_SW *filter, const CAN_Control_Frame *frame )
+{
+    uint32_t id     = frame->id;
+    uint8_t  accept = 0U;
+    uint8_t  slot;
+
+    /* If the CAN frame is extended */
+    if ( ( frame->flags & CAN_FRAME_EXTENDED ) == CAN_FRAME_EXTENDED )
+    {
+        slot = CAN_Filter_SW_Hash( id );
+
+        while ( filter->exttable[ slot ] != CAN_FILTER_SW_EMPTY )
+        {
+            if ( filter->exttable[ slot ] == id )
+            {
+                accept = 1U;
+                break;
+            }
+
+            slot = ( slot + 1U ) & ( CAN_FILTER_SW_EXT_SIZE - 1U );
+        }
+    }
+    /* If the CAN frame is standard */
+    else
+    {
+        accept = ( filter->stdbitmap[ ( id >> 3 ) & 0xFFU ] >> ( id & 0x07U ) ) & 0x01U;
+    }
+
+    if ( accept == 1U )
+    {
+        filter->accepted++;
+    }
+    else
+    {
+        filter->rejected++;
+    }
+
+    return accept;
+}
+
+/**
+ * @brief Read received CAN frames (refer to CAN_Control_Receive_Frame() in can.c) until one passes the software filter,
+ *        discarding the rest before they reach any queue.
+ * 
+ * @param hcan     pointer to an MCP2515 configuration structure (CAN receiving node)
+ * @param filter   pointer to the software filter
+ * @param frame    pointer to the CAN frame where the accepted frame is stored
+ * @return uint8_t 1 if an accepted CAN frame was read, 0 if both RX buffers are empty
+ */
+uint8_t CAN_Filter_SW_Receive( CAN_Control_HandleTypeDef *hcan, CAN_Filter_SW *filter, CAN_Control_Frame *frame )
+{
+    while ( CAN_Control_Receive_Frame( hcan, frame ) == 1U )
+    {
+        if ( CAN_Filter_SW_Accepts( filter, frame ) == 1U )
+        {
+            return 1U;
+        }
+    }
+
+    return 0U;
+}
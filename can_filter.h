@@ -0,0 +1,92 @@
+/**
+ * @file      can_filter.h
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the definitions and function prototypes for the CAN acceptance filter optimizer, which
+ *            compiles a list of accepted CAN IDs and ID ranges into the two masks and six filters of the MCP2515.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#ifndef CAN_FILTER_H
+#define CAN_FILTER_H
+
+    #include <stdint.h>
+    #include "stm32f0xx.h"
+    #include "can.h"
+
+    /* Maximum number of aligned ID blocks the ranges are split into (blocks beyond it are merged on the fly) */
+    #ifndef CAN_FILTER_MAX_TERMS
+        #define CAN_FILTER_MAX_TERMS            (24U)
+    #endif
+
+    /* Number of entries of the software filter extended ID hash table (power of two, 4 to 256) */
+    #ifndef CAN_FILTER_SW_EXT_SIZE
+        #define CAN_FILTER_SW_EXT_SIZE          (64U)
+    #endif
+
+    /* Software filter empty hash table entry (not a valid 29-bit ID) */
+    #define CAN_FILTER_SW_EMPTY                 (0xFFFFFFFFUL)
+
+    /* MCP2515 acceptance resources */
+    #define CAN_FILTER_HW_FILTERS               (6U)
+    #define CAN_FILTER_RXB0_FILTERS             (2U)
+    #define CAN_FILTER_RXB1_FILTERS             (4U)
+
+    /* ID field masks in the 29-bit SID:EID register layout */
+    #define CAN_FILTER_SID_MASK                 (0x1FFC0000UL)
+    #define CAN_FILTER_ID_MASK                  (0x1FFFFFFFUL)
+
+    /* Structure that holds a range of CAN IDs to be accepted (first == last for a single ID) */
+    typedef struct
+    {
+        uint32_t first;                                                /* First CAN ID of the range                                            */
+        uint32_t last;                                                 /* Last CAN ID of the range                                             */
+        uint8_t  extended;                                             /* 1 if the range holds extended IDs, 0 if it holds standard IDs        */
+    } CAN_Filter_Range;
+
+    /* Structure that holds the measured bus rate of a CAN ID (accepted or not) */
+    typedef struct
+    {
+        uint32_t id;                                                   /* CAN ID                                                               */
+        uint16_t rate;                                                 /* Frames per second seen on the bus                                    */
+        uint8_t  extended;                                             /* 1 if the ID is extended, 0 if it is standard                         */
+    } CAN_Filter_Traffic;
+
+    /* Structure that holds the acceptance settings computed by the optimizer */
+    typedef struct
+    {
+        CAN_Control_RX_Mask   masks;                                   /* RXM0 and RXM1 settings (ready for CAN_Control_Set_RX_Mask())         */
+        CAN_Control_RX_Filter filters;                                 /* RXF0 to RXF5 settings (ready for CAN_Control_Set_RX_Filter())        */
+        uint32_t              falseaccepts;                            /* Unwanted IDs let through by the settings (upper bound)               */
+        uint32_t              falserate;                               /* Unwanted frames per second let through (only with measured traffic) */
+        uint16_t              residualcount;                           /* Unwanted measured IDs let through (software filtering required)      */
+    } CAN_Filter_Result;
+
+    /* Structure that holds a second-stage software acceptance filter, applied to the frames let through by the MCP2515 */
+    typedef struct
+    {
+        uint8_t               stdbitmap[ 256 ];                        /* One bit per standard ID (2048 IDs)                                   */
+        uint32_t              exttable[ CAN_FILTER_SW_EXT_SIZE ];      /* Extended IDs, open addressing with linear probing                    */
+        uint16_t              extcount;                                /* Extended IDs in the hash table (up to 3/4 of its size)               */
+        uint32_t              accepted;                                /* Frames accepted                                                      */
+        uint32_t              rejected;                                /* Frames discarded (let through by the hardware filters only)          */
+    } CAN_Filter_SW;
+
+    /* Acceptance filter optimizer functions */
+    uint8_t CAN_Filter_Optimize( const CAN_Filter_Range *ranges, uint8_t count, const CAN_Filter_Traffic *traffic, uint16_t trafficcount,
+                                 CAN_Filter_Result *result, CAN_Filter_Traffic *residual, uint16_t maxresidual );
+    uint8_t CAN_Filter_HW_Accepts( const CAN_Filter_Result *result, uint32_t id, uint8_t extended );
+
+    /* Software acceptance filter functions */
+    void CAN_Filter_SW_Init( CAN_Filter_SW *filter );
+    uint8_t CAN_Filter_SW_Add( CAN_Filter_SW *filter, uint32_t id, uint8_t extended );
+    uint8_t CAN_Filter_SW_Add_Ranges( CAN_Filter_SW *filter, const CAN_Filter_Range *ranges, uint8_t count );
+    uint8_t CAN_Filter_SW_Accepts( CAN_Filter_SW *filter, const CAN_Control_Frame *frame );
+    uint8_t CAN_Filter_SW_Receive( CAN_Control_HandleTypeDef *hcan, CAN_Filter_SW *filter, CAN_Control_Frame *frame );
+
+#endif
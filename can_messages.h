@@ -0,0 +1,45 @@
+/**
+ * @file      can_messages.h
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the list of CAN messages handled by ID on the MCP2515 #2 of the example (main.c).
+ *            'make' builds tools/can_dispatch_gen.c with this list and runs it to generate can_dispatch_table.c, the
+ *            two-level perfect hash table of the messages, so adding a message only takes a new list entry.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#ifndef CAN_MESSAGES_H
+#define CAN_MESSAGES_H
+
+    #include <stdint.h>
+    #include "can_dispatch.h"
+
+    /* Number of messages in the list (size of the per-message frame counters) */
+    #define BOARD_CAN_MESSAGE_COUNT             (8U)
+
+    /* Message list: X( id, extended, handler, context ) */
+    #define BOARD_CAN_MESSAGES( X )                                                    \
+        X( 0x555UL,       0U, Board_CAN_Message, &board_can_count[ 0 ] ) /* RXF0 */   \
+        X( 0x1D0CAFC8UL,  1U, Board_CAN_Message, &board_can_count[ 1 ] ) /* RXF2 */   \
+        X( 0x0CF00400UL,  1U, Board_CAN_Message, &board_can_count[ 2 ] ) /* EEC1 */   \
+        X( 0x0CF00300UL,  1U, Board_CAN_Message, &board_can_count[ 3 ] ) /* EEC2 */   \
+        X( 0x18FEF100UL,  1U, Board_CAN_Message, &board_can_count[ 4 ] ) /* CCVS */   \
+        X( 0x18FEEE00UL,  1U, Board_CAN_Message, &board_can_count[ 5 ] ) /* ET1  */   \
+        X( 0x100UL,       0U, Board_CAN_Message, &board_can_count[ 6 ] )              \
+        X( 0x7DFUL,       0U, Board_CAN_Message, &board_can_count[ 7 ] ) /* OBD  */
+
+    /* Frames received per message of the list (main.c) */
+    extern uint32_t board_can_count[ BOARD_CAN_MESSAGE_COUNT ];
+
+    /* Message handler of the example (main.c), counts the frames of each message */
+    void Board_CAN_Message( const CAN_Control_Frame *frame, void *context );
+
+    /* Perfect hash ID dispatch table of the message list (generated can_dispatch_table.c) */
+    extern const CAN_Dispatch_IDs board_can_ids;
+
+#endif
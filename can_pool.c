@@ -0,0 +1,252 @@
+/**
+ * @file      can_pool.c
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the CAN frame pool and handle ring functions. The pool free-list is updated within a
+ *            short PRIMASK critical section (the Cortex-M0 has no exclusive load/store instructions), while the rings
+ *            are lock-free since each index is written by a single side.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#include <stddef.h>
+#include "can_pool.h"
+
+/* Build-time checks of the pool and ring sizes */
+typedef char can_pool_size_check[ ( ( CAN_POOL_SIZE > 0U ) && ( CAN_POOL_SIZE < CAN_POOL_NONE ) ) ? 1 : -1 ];
+typedef char can_pool_ring_size_check[ ( ( CAN_POOL_RING_SIZE >= 2U ) && ( CAN_POOL_RING_SIZE <= 128U ) &&
+                                         ( ( CAN_POOL_RING_SIZE & ( CAN_POOL_RING_SIZE - 1U ) ) == 0U ) ) ? 1 : -1 ];
+
+/**
+ * @brief Link every frame of the pool into the free-list and clear its statistics.
+ * 
+ * @param pool pointer to the frame pool
+ */
+void CAN_Pool_Init( CAN_Pool *pool )
+{
+    uint8_t i;
+
+    for ( i = 0U; i < ( CAN_POOL_SIZE - 1U ); i++ )
+    {
+        pool->next[ i ] = i + 1U;
+    }
+
+    pool->next[ CAN_POOL_SIZE - 1U ] = CAN_POOL_NONE;
+    pool->head                       = 0U;
+    pool->used                       = 0U;
+    pool->highwater                  = 0U;
+    pool->failures                   = 0U;
+}
+
+/**
+ * @brief Take a frame from the pool. Safe to be called from both thread and ISR context.
+ * 
+ * @param pool             pointer to the frame pool
+ * @return CAN_Pool_Handle handle of the frame, CAN_POOL_NONE if the pool is exhausted
+ */
+CAN_Pool_Handle CAN_Pool_Alloc( CAN_Pool *pool )
+{
+    uint32_t        primask;
+    CAN_Pool_Handle handle;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    handle = pool->head;
+
+    if ( handle != CAN_POOL_NONE )
+    {
+        pool->head = pool->next[ handle ];
+        pool->used++;
+
+        if ( pool->used > pool->highwater )
+        {
+            pool->highwater = pool->used;
+        }
+    }
+    else
+    {
+        pool->failures++;
+    }
+
+    __set_PRIMASK( primask );
+
+    return handle;
+}
+
+/**
+ * @brief Give a frame back to the pool. Safe to be called from both thread and ISR context.
+ * 
+ * @param pool   pointer to the frame pool
+ * @param handle handle of the frame (CAN_POOL_NONE is ignored)
+ */
+void CAN_Pool_Free( CAN_Pool *pool, CAN_Pool_Handle handle )
+{
+    uint32_t primask;
+
+    if ( handle < CAN_POOL_SIZE )
+    {
+        primask = __get_PRIMASK();
+        __disable_irq();
+
+        pool->next[ handle ] = pool->head;
+        pool->head           = handle;
+        pool->used--;
+
+        __set_PRIMASK( primask );
+    }
+}
+
+/**
+ * @brief Empty the ring and clear its statistics.
+ * 
+ * @param ring pointer to the handle ring
+ */
+void CAN_Pool_Ring_Init( CAN_Pool_Ring *ring )
+{
+    ring->head      = 0U;
+    ring->tail      = 0U;
+    ring->highwater = 0U;
+    ring->overruns  = 0U;
+}
+
+/**
+ * @brief Queue a handle (producer side).
+ * 
+ * @param ring     pointer to the handle ring
+ * @param handle   handle to be queued
+ * @return uint8_t 1 if the handle was queued, 0 if the ring is full (the caller still owns the frame)
+ */
+uint8_t CAN_Pool_Ring_Put( CAN_Pool_Ring *ring, CAN_Pool_Handle handle )
+{
+    uint8_t head  = ring->head;
+    uint8_t count = ( uint8_t )( head - ring->tail );
+
+    if ( count >= CAN_POOL_RING_SIZE )
+    {
+        ring->overruns++;
+        return 0U;
+    }
+
+    ring->slot[ head & ( CAN_POOL_RING_SIZE - 1U ) ] = handle;
+
+    /* The slot must be written before the consumer sees the new head */
+    __DMB();
+    ring->head = head + 1U;
+
+    if ( ( count + 1U ) > ring->highwater )
+    {
+        ring->highwater = count + 1U;
+    }
+
+    return 1U;
+}
+
+/**
+ * @brief Get the oldest queued handle without removing it from the ring (consumer side).
+ * 
+ * @param ring             pointer to the handle ring
+ * @return CAN_Pool_Handle oldest handle, CAN_POOL_NONE if the ring is empty
+ */
+CAN_Pool_Handle CAN_Pool_Ring_Peek( const CAN_Pool_Ring *ring )
+{
+    uint8_t tail = ring->tail;
+
+    if ( ring->head == tail )
+    {
+        return CAN_POOL_NONE;
+    }
+
+    return ring->slot[ tail & ( CAN_POOL_RING_SIZE - 1U ) ];
+}
+
+/**
+ * @brief Remove the oldest queued handle from the ring (consumer side).
+ * 
+ * @param ring             pointer to the handle ring
+ * @return CAN_Pool_Handle oldest handle, CAN_POOL_NONE if the ring is empty
+ */
+CAN_Pool_Handle CAN_Pool_Ring_Get( CAN_Pool_Ring *ring )
+{
+    CAN_Pool_Handle handle = CAN_Pool_Ring_Peek( ring );
+
+    if ( handle != CAN_POOL_NONE )
+    {
+        /* The slot must be read before the producer sees the new tail */
+        __DMB();
+        ring->tail = ring->tail + 1U;
+    }
+
+    return handle;
+}
+
+/**
+ * @brief Read every received CAN frame straight into pool frames and queue their handles (e.g. from the RX ISR).
+ *        Stops when both RX buffers are empty, the pool is exhausted or the ring is full, frames not read then are
+ *        left in the RX buffers for the next call (ring space is checked before a frame is read).
+ *        Frames rejected by the software filter reuse the same pool frame, so they never reach the ring.
+ * 
+ * @param hcan      pointer to an MCP2515 configuration structure (CAN receiving node)
+ * @param pool      pointer to the frame pool
+ * @param ring      pointer to the RX handle ring
+ * @param filter    pointer to the software acceptance filter, NULL to queue every frame
+ * @return uint16_t number of frames queued
+ */
+uint16_t CAN_Pool_Receive( CAN_Control_HandleTypeDef *hcan, CAN_Pool *pool, CAN_Pool_Ring *ring, CAN_Filter_SW *filter )
+{
+    CAN_Pool_Handle handle;
+    uint16_t        count = 0U;
+
+    while ( ( ( uint8_t )( ring->head - ring->tail ) < CAN_POOL_RING_SIZE ) &&
+            ( ( handle = CAN_Pool_Alloc( pool ) ) != CAN_POOL_NONE ) )
+    {
+        /* Both RX buffers are empty */
+        if ( ( ( filter == NULL ) && ( CAN_Control_Receive_Frame( hcan, CAN_POOL_FRAME( pool, handle ) ) == 0U ) ) ||
+             ( ( filter != NULL ) && ( CAN_Filter_SW_Receive( hcan, filter, CAN_POOL_FRAME( pool, handle ) ) == 0U ) ) )
+        {
+            CAN_Pool_Free( pool, handle );
+            break;
+        }
+
+        /* The ring only drains while the frame is read, there is still room for its handle */
+        ( void )CAN_Pool_Ring_Put( ring, handle );
+
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Load queued frames into the free TX buffers and give them back to the pool once loaded.
+ *        Stops when the ring is empty or the three TX buffers are pending.
+ * 
+ * @param hcan      pointer to an MCP2515 configuration structure (CAN sending node)
+ * @param pool      pointer to the frame pool
+ * @param ring      pointer to the TX handle ring
+ * @return uint16_t number of frames loaded
+ */
+uint16_t CAN_Pool_Transmit( CAN_Control_HandleTypeDef *hcan, CAN_Pool *pool, CAN_Pool_Ring *ring )
+{
+    CAN_Pool_Handle handle;
+    uint16_t        count = 0U;
+
+    while ( ( handle = CAN_Pool_Ring_Peek( ring ) ) != CAN_POOL_NONE )
+    {
+        /* The frame stays queued until a TX buffer is free */
+        if ( CAN_Control_Send_Frame( hcan, CAN_POOL_FRAME( pool, handle ) ) == 0U )
+        {
+            break;
+        }
+
+        ( void )CAN_Pool_Ring_Get( ring );
+        CAN_Pool_Free( pool, handle );
+        count++;
+    }
+
+    return count;
+}
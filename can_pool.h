@@ -0,0 +1,79 @@
+/**
+ * @file      can_pool.h
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the definitions and function prototypes for the CAN frame pool, a statically sized set of
+ *            CAN frames handed over by handle (instead of by value) through RX rings, TX queues and routing stages, so
+ *            that each frame is written once by the SPI driver and read once by its consumer.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#ifndef CAN_POOL_H
+#define CAN_POOL_H
+
+    #include <stdint.h>
+    #include "stm32f0xx.h"
+    #include "can.h"
+    #include "can_filter.h"
+
+    /* Number of frames in a pool (1 to 255) */
+    #ifndef CAN_POOL_SIZE
+        #define CAN_POOL_SIZE                   (32U)
+    #endif
+
+    /* Number of handles in a ring (power of two, 2 to 128) */
+    #ifndef CAN_POOL_RING_SIZE
+        #define CAN_POOL_RING_SIZE              (16U)
+    #endif
+
+    /* Invalid handle, returned when the pool or a ring is empty */
+    #define CAN_POOL_NONE                       (0xFFU)
+
+    /* Pointer to the frame of a handle */
+    #define CAN_POOL_FRAME( pool, handle )      ( &( pool )->frames[ ( handle ) ] )
+
+    /* Frame handle (index of the frame within its pool) */
+    typedef uint8_t CAN_Pool_Handle;
+
+    /* Structure that holds the frames of a pool along with its free-list and statistics */
+    typedef struct
+    {
+        CAN_Control_Frame frames[ CAN_POOL_SIZE ];                     /* Frame storage                                                        */
+        uint8_t           next[ CAN_POOL_SIZE ];                       /* Free-list links (next free handle)                                   */
+        volatile uint8_t  head;                                        /* First free handle, CAN_POOL_NONE if the pool is exhausted            */
+        volatile uint8_t  used;                                        /* Frames currently allocated                                           */
+        uint8_t           highwater;                                   /* Highest number of frames allocated at the same time                  */
+        uint32_t          failures;                                    /* Allocations refused because the pool was exhausted                   */
+    } CAN_Pool;
+
+    /* Structure that holds a single-producer/single-consumer ring of frame handles (e.g. ISR to thread) */
+    typedef struct
+    {
+        uint8_t           slot[ CAN_POOL_RING_SIZE ];                  /* Queued handles                                                       */
+        volatile uint8_t  head;                                        /* Free-running write index (only written by the producer)              */
+        volatile uint8_t  tail;                                        /* Free-running read index (only written by the consumer)               */
+        uint8_t           highwater;                                   /* Highest number of handles queued at the same time                    */
+        uint32_t          overruns;                                    /* Handles refused because the ring was full                            */
+    } CAN_Pool_Ring;
+
+    /* Frame pool functions */
+    void CAN_Pool_Init( CAN_Pool *pool );
+    CAN_Pool_Handle CAN_Pool_Alloc( CAN_Pool *pool );
+    void CAN_Pool_Free( CAN_Pool *pool, CAN_Pool_Handle handle );
+
+    /* Handle ring functions */
+    void CAN_Pool_Ring_Init( CAN_Pool_Ring *ring );
+    uint8_t CAN_Pool_Ring_Put( CAN_Pool_Ring *ring, CAN_Pool_Handle handle );
+    CAN_Pool_Handle CAN_Pool_Ring_Peek( const CAN_Pool_Ring *ring );
+    CAN_Pool_Handle CAN_Pool_Ring_Get( CAN_Pool_Ring *ring );
+
+    /* MCP2515 zero-copy transfer functions */
+    uint16_t CAN_Pool_Receive( CAN_Control_HandleTypeDef *hcan, CAN_Pool *pool, CAN_Pool_Ring *ring, CAN_Filter_SW *filter );
+    uint16_t CAN_Pool_Transmit( CAN_Control_HandleTypeDef *hcan, CAN_Pool *pool, CAN_Pool_Ring *ring );
+
+#endif
@@ -0,0 +1,314 @@
+/**
+ * @file      can_service.c
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the CAN controller service routine. Controllers are visited in round-robin order and
+ *            each one reads at most 'budget' frames per turn, so a busy bus can not starve the other controllers.
+ *            The INT pin of each controller tells whether it needs service without any SPI transaction; controllers
+ *            without a wired INT pin are polled through CANINTF. The service can be called from the main loop or
+ *            from the EXTI interrupt of the INT pins. Controllers whose INT pins share an EXTI line are demultiplexed
+ *            with one READ STATUS instruction per controller (refer to CAN_Service_Demux()).
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#include "can_service.h"
+
+/* Controller group serviced by the shared INT line interrupt (refer to CAN_Service_Attach()) */
+static CAN_Service_Group *can_service_irq_group = NULL;
+
+/**
+ * @brief Service the interrupt flags of a controller: read up to 'budget' received frames and acknowledge the
+ *        TX, error and wake-up flags.
+ * 
+ * @param node     pointer to the serviced controller
+ * @param flags    CANINTF flags to service
+ * @param budget   maximum number of frames to read
+ * @return uint8_t 1 if received frames are still waiting, 0 if not
+ */
+static uint8_t CAN_Service_Node_Flags( CAN_Service_Node *node, uint8_t flags, uint8_t budget )
+{
+    CAN_Control_Frame frame;
+    uint8_t           clear;
+    uint8_t           count = 0U;
+
+    node->stats.services++;
+
+    /* Received frames (reading an RX buffer clears its RXnIF flag) */
+    if ( ( flags & ( RX1IE_RXB1_FULL_INTERRUPT_ENABLED | RX0IE_RXB0_FULL_INTERRUPT_ENABLED ) ) != 0U )
+    {
+        while ( ( count < budget ) && ( CAN_Control_Receive_Frame( node->hcan, &frame ) == 1U ) )
+        {
+            node->handler( node->hcan, &frame, node->context );
+            count++;
+        }
+
+        node->stats.rxframes += count;
+    }
+
+    /* Sent frames */
+    clear = flags & ( TX2IE_TXB2_EMPTY_INTERRUPT_ENABLED | TX1IE_TXB1_EMPTY_INTERRUPT_ENABLED | TX0IE_TXB0_EMPTY_INTERRUPT_ENABLED );
+    node->stats.txframes += ( ( clear >> 4 ) & 0x01U ) + ( ( clear >> 3 ) & 0x01U ) + ( ( clear >> 2 ) & 0x01U );
+
+    /* Message errors and wake-ups */
+    if ( ( flags & MERRE_MSG_ERROR_INTERRUPT_ENABLED ) != 0U )
+    {
+        node->stats.errors++;
+        clear |= MERRE_MSG_ERROR_INTERRUPT_ENABLED;
+    }
+
+    if ( ( flags & WAKIE_WAKEUP_INTERRUPT_ENABLED ) != 0U )
+    {
+        node->stats.wakeups++;
+        clear |= WAKIE_WAKEUP_INTERRUPT_ENABLED;
+    }
+
+    /* Errors: the fault manager reads EFLG and clears ERRIF itself */
+    if ( ( flags & ERRIE_ERROR_INTERRUPT_ENABLED ) != 0U )
+    {
+        node->stats.errors++;
+
+        if ( node->fault != NULL )
+        {
+            CAN_Fault_ERR_IRQ( node->fault );
+        }
+        else
+        {
+            clear |= ERRIE_ERROR_INTERRUPT_ENABLED;
+        }
+    }
+
+    if ( clear != 0U )
+    {
+        CAN_Control_Clear_INT_Status( node->hcan, clear );
+    }
+
+    /* Budget exhausted: check whether frames are still waiting */
+    if ( ( count == budget ) && ( ( CAN_Control_RX_Status( node->hcan ) & ( RX_STATUS_MSG_RXB1 | RX_STATUS_MSG_RXB0 ) ) != 0U ) )
+    {
+        node->stats.deferrals++;
+        return 1U;
+    }
+
+    return 0U;
+}
+
+/**
+ * @brief Service the pending interrupts of a controller, reading its CANINTF register to find them.
+ * 
+ * @param node     pointer to the serviced controller
+ * @param budget   maximum number of frames to read
+ * @return uint8_t 1 if received frames are still waiting, 0 if not
+ */
+static uint8_t CAN_Service_Node_Run( CAN_Service_Node *node, uint8_t budget )
+{
+    uint8_t flags = CAN_Control_INT_Status( node->hcan );
+
+    if ( flags == 0U )
+    {
+        return 0U;
+    }
+
+    return CAN_Service_Node_Flags( node, flags, budget );
+}
+
+/**
+ * @brief Initialize a group of controllers serviced together. The controllers must be initialized already
+ *        (refer to CAN_Control_Init() in can.c) and their nodes must hold their handler, context and fault manager.
+ * 
+ * @param group  pointer to the controller group
+ * @param nodes  array of controllers
+ * @param count  number of controllers
+ * @param budget frames read from a controller per turn (0 selects CAN_SERVICE_BUDGET)
+ */
+void CAN_Service_Init( CAN_Service_Group *group, CAN_Service_Node *nodes, uint8_t count, uint8_t budget )
+{
+    CAN_Service_Stats empty = { 0U };
+    uint8_t           i;
+
+    group->nodes  = nodes;
+    group->count  = count;
+    group->budget = ( budget == 0U ) ? CAN_SERVICE_BUDGET : budget;
+    group->next   = 0U;
+
+    group->lineport     = NULL;
+    group->linepin      = 0U;
+    group->irqs         = 0U;
+    group->retriggers   = 0U;
+    group->busdeferrals = 0U;
+
+    for ( i = 0U; i < count; i++ )
+    {
+        nodes[ i ].stats = empty;
+    }
+}
+
+/**
+ * @brief Service every controller whose INT pin is asserted, in round-robin order, until none is left with work
+ *        or CAN_SERVICE_MAX_ROUNDS rounds were made. Each call starts with the controller after the one that started
+ *        the previous call, so no controller is always serviced last.
+ * 
+ * @param group     pointer to the controller group
+ * @return uint16_t number of frames received
+ */
+uint16_t CAN_Service_Run( CAN_Service_Group *group )
+{
+    CAN_Service_Node *node;
+    uint32_t          rxframes = 0U;
+    uint8_t           pending  = 1U;
+    uint8_t           round, turn, index;
+
+    for ( round = 0U; ( round < CAN_SERVICE_MAX_ROUNDS ) && ( pending == 1U ); round++ )
+    {
+        pending = 0U;
+        index   = group->next;
+
+        for ( turn = 0U; turn < group->count; turn++ )
+        {
+            node = &group->nodes[ index ];
+
+            if ( CAN_INT_ASSERTED( node->hcan ) )
+            {
+                rxframes -= node->stats.rxframes;
+                pending  |= CAN_Service_Node_Run( node, group->budget );
+                rxframes += node->stats.rxframes;
+
+                /* The INT pin stays LOW while any enabled flag is set */
+                pending |= ( node->hcan->intport != NULL ) && CAN_INT_ASSERTED( node->hcan );
+            }
+
+            index = ( uint8_t )( ( index + 1U ) % group->count );
+        }
+    }
+
+    group->next = ( uint8_t )( ( group->next + 1U ) % ( ( group->count == 0U ) ? 1U : group->count ) );
+
+    return ( uint16_t )rxframes;
+}
+
+/**
+ * @brief Find and service the sources of a shared INT line, with the INT pins of the group wired-OR'd (or grouped)
+ *        on a single input. Controllers are visited in priority order (first node first), and each one costs
+ *        a single READ STATUS instruction to find out whether it has received or sent frames. Error, wake-up and
+ *        message error flags are not part of the READ STATUS response, so CANINTF is read only if the line is still
+ *        LOW after a round where no controller had RX/TX flags.
+ * 
+ *        The line level is checked again before returning: while any controller keeps its INT pin LOW the shared
+ *        line can not produce a new falling edge, so it is serviced again, at most CAN_SERVICE_MAX_ROUNDS times.
+ * 
+ * @param group    pointer to the controller group (its lineport and linepin must be set, refer to CAN_Service_Attach())
+ * @return uint8_t 1 if the line is HIGH (all the sources serviced), 0 if it is still LOW after the last round
+ */
+uint8_t CAN_Service_Demux( CAN_Service_Group *group )
+{
+    CAN_Service_Node *node;
+    uint8_t           status, flags, found, i;
+    uint8_t           round;
+
+    group->irqs++;
+
+    for ( round = 0U; round < CAN_SERVICE_MAX_ROUNDS; round++ )
+    {
+        found = 0U;
+
+        for ( i = 0U; i < group->count; i++ )
+        {
+            node   = &group->nodes[ i ];
+            status = CAN_Control_Read_Status( node->hcan );
+
+            /* READ STATUS bits to CANINTF bits: RXnIF keep their position, TXnIF are every other bit */
+            flags = ( uint8_t )( ( status & ( STATUS_RX1IF | STATUS_RX0IF ) ) |
+                                 ( ( status & STATUS_TX0IF ) >> 1 ) |
+                                 ( ( status & STATUS_TX1IF ) >> 2 ) |
+                                 ( ( status & STATUS_TX2IF ) >> 3 ) );
+
+            if ( flags != 0U )
+            {
+                found = 1U;
+                CAN_Service_Node_Flags( node, flags, group->budget );
+            }
+        }
+
+        /* Re-check the line level, no edge is left behind while it is HIGH */
+        if ( ( group->lineport->IDR & group->linepin ) != 0U )
+        {
+            return 1U;
+        }
+
+        /* Line still LOW without RX/TX flags: error, wake-up or message error interrupt */
+        if ( found == 0U )
+        {
+            for ( i = 0U; i < group->count; i++ )
+            {
+                CAN_Service_Node_Run( &group->nodes[ i ], group->budget );
+            }
+        }
+    }
+
+    return ( ( group->lineport->IDR & group->linepin ) != 0U ) ? 1U : 0U;
+}
+
+/**
+ * @brief Attach a controller group to its shared INT line, serviced from then on by CAN_Service_EXTI_IRQ().
+ *        The line must be an EXTI input triggered on falling edge (refer to PWR_INT_Pin_Init() in power.c), and
+ *        CAN_Service_Run() must not be called for the same group anymore, since both use the SPI bus.
+ *        Thread code may keep using the controllers: every driver transaction holds its SPI bus (refer to
+ *        SPI_Bus_Lock() in spi.c), and an interrupt that preempts one is deferred until the bus is released. Driver
+ *        calls made of several transactions (receive and send frames, operation mode changes, sleep and wake-up...)
+ *        hold the bus from the first to the last one, so the interrupt service never sees them half done. Thread
+ *        sequences of driver calls that must not be interleaved with it hold the bus lock around them as well.
+ *        The controllers must be initialized before the group is attached.
+ * 
+ * @param group pointer to the controller group, NULL to detach
+ * @param port  GPIO port of the shared INT line
+ * @param pin   GPIO pin of the shared INT line (GPIO_IDR_x, the EXTI line has the same number)
+ */
+void CAN_Service_Attach( CAN_Service_Group *group, GPIO_TypeDef *port, uint16_t pin )
+{
+    if ( group != NULL )
+    {
+        group->lineport = port;
+        group->linepin  = pin;
+    }
+
+    can_service_irq_group = group;
+}
+
+/**
+ * @brief Shared INT line interrupt service, to be called from the EXTI interrupt handler once the line pending
+ *        request is cleared. If the line is still LOW after CAN_SERVICE_MAX_ROUNDS rounds, the EXTI request is
+ *        raised again by software, so that the ISR time stays bounded and the remaining sources are serviced
+ *        right after any other pending interrupt.
+ *        If the interrupted code is in the middle of a transaction on the SPI bus of any controller of the group,
+ *        nothing is serviced: the EXTI request is raised again when that bus is released (refer to SPI_Bus_Defer()).
+ */
+void CAN_Service_EXTI_IRQ( void )
+{
+    CAN_Service_Group *group = can_service_irq_group;
+    uint8_t            i;
+
+    if ( group == NULL )
+    {
+        return;
+    }
+
+    for ( i = 0U; i < group->count; i++ )
+    {
+        if ( SPI_Bus_Busy( group->nodes[ i ].hcan->spiport ) == 1U )
+        {
+            group->busdeferrals++;
+            SPI_Bus_Defer( group->nodes[ i ].hcan->spiport, group->linepin );
+            return;
+        }
+    }
+
+    if ( CAN_Service_Demux( group ) == 0U )
+    {
+        group->retriggers++;
+        EXTI->SWIER = group->linepin;
+    }
+}
@@ -0,0 +1,77 @@
+/**
+ * @file      can_service.h
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the definitions and function prototypes for the CAN controller service routine, which
+ *            services the interrupts of any number of MCP2515 controllers in turn, with statistics per controller,
+ *            either polled or from a shared INT line interrupt.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#ifndef CAN_SERVICE_H
+#define CAN_SERVICE_H
+
+    #include <stdint.h>
+    #include "stm32f0xx.h"
+    #include "can.h"
+    #include "can_fault.h"
+
+    /* Default number of frames read from a controller before moving on to the next one */
+    #define CAN_SERVICE_BUDGET                  (4U)
+
+    /* Maximum number of rounds over all the controllers per service call */
+    #define CAN_SERVICE_MAX_ROUNDS              (8U)
+
+    /* Received CAN frame handler, called with the controller that received the frame */
+    typedef void ( *CAN_Service_Handler )( CAN_Control_HandleTypeDef *hcan, const CAN_Control_Frame *frame, void *context );
+
+    /* Structure that holds the statistics of a serviced controller */
+    typedef struct
+    {
+        uint32_t rxframes;                                             /* Frames received                                                      */
+        uint32_t txframes;                                             /* Frames sent (TXnIF flags)                                            */
+        uint32_t errors;                                               /* Error interrupts (ERRIF) and message errors (MERRF)                  */
+        uint32_t wakeups;                                              /* Wake-up interrupts (WAKIF)                                           */
+        uint32_t services;                                             /* Times the controller was serviced                                    */
+        uint32_t deferrals;                                            /* Times the frame budget ran out with frames still waiting             */
+    } CAN_Service_Stats;
+
+    /* Structure that holds a serviced controller */
+    typedef struct
+    {
+        CAN_Control_HandleTypeDef *hcan;                               /* CAN controller                                                       */
+        CAN_Service_Handler        handler;                            /* Received frame handler                                               */
+        void                      *context;                            /* Context pointer passed to the handler                                */
+        CAN_Fault_Manager         *fault;                              /* Fault manager fed with ERRIF, NULL to just clear ERRIF               */
+        CAN_Service_Stats          stats;                              /* Controller statistics                                                */
+    } CAN_Service_Node;
+
+    /* Structure that holds a group of controllers serviced together, in priority order for the shared INT line */
+    typedef struct
+    {
+        CAN_Service_Node *nodes;                                       /* Array of controllers                                                 */
+        uint8_t           count;                                       /* Number of controllers                                                */
+        uint8_t           budget;                                      /* Frames read from a controller per turn                               */
+        uint8_t           next;                                        /* Controller serviced first by the next call (round-robin)             */
+        GPIO_TypeDef     *lineport;                                    /* GPIO port of the shared INT line, NULL if not attached               */
+        uint16_t          linepin;                                     /* GPIO pin of the shared INT line                                      */
+        uint32_t          irqs;                                        /* Shared INT line interrupts serviced                                  */
+        uint32_t          retriggers;                                  /* Interrupts raised again with the line still LOW                      */
+        uint32_t          busdeferrals;                                /* Interrupts deferred because the preempted code held the SPI bus      */
+    } CAN_Service_Group;
+
+    /* CAN controller service functions */
+    void CAN_Service_Init( CAN_Service_Group *group, CAN_Service_Node *nodes, uint8_t count, uint8_t budget );
+    uint16_t CAN_Service_Run( CAN_Service_Group *group );
+
+    /* Shared INT line interrupt demultiplexer functions */
+    uint8_t CAN_Service_Demux( CAN_Service_Group *group );
+    void CAN_Service_Attach( CAN_Service_Group *group, GPIO_TypeDef *port, uint16_t pin );
+    void CAN_Service_EXTI_IRQ( void );
+
+#endif
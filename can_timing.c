@@ -0,0 +1,462 @@
+/**
+ * @file      can_timing.c
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the function implementations for the CAN bit-level timing computations
+ *            of the CAN Controller Module (MCP2515), such as the exact on-wire length of a CAN frame.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#include "can_timing.h"
+
+/* CAN CRC-15 lookup table, crc15_table[ n ] = CRC-15 of the byte n (processed MSB first) */
+static const uint16_t crc15_table[ 256 ] =
+{
+    0x0000U, 0x4599U, 0x4EABU, 0x0B32U, 0x58CFU, 0x1D56U, 0x1664U, 0x53FDU,
+    0x7407U, 0x319EU, 0x3AACU, 0x7F35U, 0x2CC8U, 0x6951U, 0x6263U, 0x27FAU,
+    0x2D97U, 0x680EU, 0x633CU, 0x26A5U, 0x7558U, 0x30C1U, 0x3BF3U, 0x7E6AU,
+    0x5990U, 0x1C09U, 0x173BU, 0x52A2U, 0x015FU, 0x44C6U, 0x4FF4U, 0x0A6DU,
+    0x5B2EU, 0x1EB7U, 0x1585U, 0x501CU, 0x03E1U, 0x4678U, 0x4D4AU, 0x08D3U,
+    0x2F29U, 0x6AB0U, 0x6182U, 0x241BU, 0x77E6U, 0x327FU, 0x394DU, 0x7CD4U,
+    0x76B9U, 0x3320U, 0x3812U, 0x7D8BU, 0x2E76U, 0x6BEFU, 0x60DDU, 0x2544U,
+    0x02BEU, 0x4727U, 0x4C15U, 0x098CU, 0x5A71U, 0x1FE8U, 0x14DAU, 0x5143U,
+    0x73C5U, 0x365CU, 0x3D6EU, 0x78F7U, 0x2B0AU, 0x6E93U, 0x65A1U, 0x2038U,
+    0x07C2U, 0x425BU, 0x4969U, 0x0CF0U, 0x5F0DU, 0x1A94U, 0x11A6U, 0x543FU,
+    0x5E52U, 0x1BCBU, 0x10F9U, 0x5560U, 0x069DU, 0x4304U, 0x4836U, 0x0DAFU,
+    0x2A55U, 0x6FCCU, 0x64FEU, 0x2167U, 0x729AU, 0x3703U, 0x3C31U, 0x79A8U,
+    0x28EBU, 0x6D72U, 0x6640U, 0x23D9U, 0x7024U, 0x35BDU, 0x3E8FU, 0x7B16U,
+    0x5CECU, 0x1975U, 0x1247U, 0x57DEU, 0x0423U, 0x41BAU, 0x4A88U, 0x0F11U,
+    0x057CU, 0x40E5U, 0x4BD7U, 0x0E4EU, 0x5DB3U, 0x182AU, 0x1318U, 0x5681U,
+    0x717BU, 0x34E2U, 0x3FD0U, 0x7A49U, 0x29B4U, 0x6C2DU, 0x671FU, 0x2286U,
+    0x2213U, 0x678AU, 0x6CB8U, 0x2921U, 0x7ADCU, 0x3F45U, 0x3477U, 0x71EEU,
+    0x5614U, 0x138DU, 0x18BFU, 0x5D26U, 0x0EDBU, 0x4B42U, 0x4070U, 0x05E9U,
+    0x0F84U, 0x4A1DU, 0x412FU, 0x04B6U, 0x574BU, 0x12D2U, 0x19E0U, 0x5C79U,
+    0x7B83U, 0x3E1AU, 0x3528U, 0x70B1U, 0x234CU, 0x66D5U, 0x6DE7U, 0x287EU,
+    0x793DU, 0x3CA4U, 0x3796U, 0x720FU, 0x21F2U, 0x646BU, 0x6F59U, 0x2AC0U,
+    0x0D3AU, 0x48A3U, 0x4391U, 0x0608U, 0x55F5U, 0x106CU, 0x1B5EU, 0x5EC7U,
+    0x54AAU, 0x1133U, 0x1A01U, 0x5F98U, 0x0C65U, 0x49FCU, 0x42CEU, 0x0757U,
+    0x20ADU, 0x6534U, 0x6E06U, 0x2B9FU, 0x7862U, 0x3DFBU, 0x36C9U, 0x7350U,
+    0x51D6U, 0x144FU, 0x1F7DU, 0x5AE4U, 0x0919U, 0x4C80U, 0x47B2U, 0x022BU,
+    0x25D1U, 0x6048U, 0x6B7AU, 0x2EE3U, 0x7D1EU, 0x3887U, 0x33B5U, 0x762CU,
+    0x7C41U, 0x39D8U, 0x32EAU, 0x7773U, 0x248EU, 0x6117U, 0x6A25U, 0x2FBCU,
+    0x0846U, 0x4DDFU, 0x46EDU, 0x0374U, 0x5089U, 0x1510U, 0x1E22U, 0x5BBBU,
+    0x0AF8U, 0x4F61U, 0x4453U, 0x01CAU, 0x5237U, 0x17AEU, 0x1C9CU, 0x5905U,
+    0x7EFFU, 0x3B66U, 0x3054U, 0x75CDU, 0x2630U, 0x63A9U, 0x689BU, 0x2D02U,
+    0x276FU, 0x62F6U, 0x69C4U, 0x2C5DU, 0x7FA0U, 0x3A39U, 0x310BU, 0x7492U,
+    0x5368U, 0x16F1U, 0x1DC3U, 0x585AU, 0x0BA7U, 0x4E3EU, 0x450CU, 0x0095U
+};
+
+/* Bit stuffing lookup table, indexed by ( state << 4 ) | nibble (nibble processed MSB first).
+   A state holds the value of the last bit on the bus (bit 2) and the length of its run minus 1 (bits 1:0).
+   Each entry holds the state after the nibble (bits 2:0) and the number of stuff bits inserted (bit 3) */
+static const uint8_t stuff_table[ 128 ] =
+{
+    0x0CU, 0x04U, 0x00U, 0x05U, 0x01U, 0x04U, 0x00U, 0x06U, 0x02U, 0x04U, 0x00U, 0x05U, 0x01U, 0x04U, 0x00U, 0x07U,
+    0x08U, 0x0DU, 0x00U, 0x05U, 0x01U, 0x04U, 0x00U, 0x06U, 0x02U, 0x04U, 0x00U, 0x05U, 0x01U, 0x04U, 0x00U, 0x07U,
+    0x09U, 0x0CU, 0x08U, 0x0EU, 0x01U, 0x04U, 0x00U, 0x06U, 0x02U, 0x04U, 0x00U, 0x05U, 0x01U, 0x04U, 0x00U, 0x07U,
+    0x0AU, 0x0CU, 0x08U, 0x0DU, 0x09U, 0x0CU, 0x08U, 0x0FU, 0x02U, 0x04U, 0x00U, 0x05U, 0x01U, 0x04U, 0x00U, 0x07U,
+    0x03U, 0x04U, 0x00U, 0x05U, 0x01U, 0x04U, 0x00U, 0x06U, 0x02U, 0x04U, 0x00U, 0x05U, 0x01U, 0x04U, 0x00U, 0x08U,
+    0x03U, 0x04U, 0x00U, 0x05U, 0x01U, 0x04U, 0x00U, 0x06U, 0x02U, 0x04U, 0x00U, 0x05U, 0x01U, 0x04U, 0x09U, 0x0CU,
+    0x03U, 0x04U, 0x00U, 0x05U, 0x01U, 0x04U, 0x00U, 0x06U, 0x02U, 0x04U, 0x00U, 0x05U, 0x0AU, 0x0CU, 0x08U, 0x0DU,
+    0x03U, 0x04U, 0x00U, 0x05U, 0x01U, 0x04U, 0x00U, 0x06U, 0x0BU, 0x0CU, 0x08U, 0x0DU, 0x09U, 0x0CU, 0x08U, 0x0EU
+};
+
+/* Candidate baud rates of the automatic baud rate detection (refer to CAN_BAUD_RATE_LIST in can.h) */
+#define CAN_AUTO_BAUD_ENTRY( b )                ( b ),
+static const uint32_t auto_baud_rates[] =
+{
+    CAN_BAUD_RATE_LIST( CAN_AUTO_BAUD_ENTRY )
+};
+
+/* Initial bit stuffing state: last bit recessive with a run of 1 (the bus is idle before SOF) */
+#define STUFF_STATE_IDLE                        (0x04U)
+
+/**
+ * @brief Compute the exact number of bits that the specified CAN frame takes on the bus, from SOF up to the last EOF bit,
+ *        including the stuff bits that result from its actual ID, DLC, data and CRC-15 values.
+ *        The 3 bits of intermission between frames are not included (refer to CAN_INTERMISSION_BITS).
+ * 
+ *        CRC-15 is computed one byte at a time and bit stuffing one nibble at a time, both through lookup tables.
+ *        Since the CAN CRC register starts at 0, leading zero bits do not change the CRC, which allows the frame
+ *        header to be right aligned into whole bytes.
+ * 
+ * @param frametype  CAN frame type. Refer to 'TX buffer frame type definitions' in can.h
+ * @param id         CAN ID (11 LSBs for standard frames, 29 LSBs for extended frames)
+ * @param datalength DLC value (0 to 15, data frames carry up to 8 data bytes)
+ * @param data       data bytes of the frame (ignored for remote frames)
+ * @return uint8_t   number of bits of the frame on the bus
+ */
+uint8_t CAN_Timing_Frame_Bits( uint8_t frametype, uint32_t id, uint8_t datalength, const uint8_t *data )
+{
+    uint8_t  stream[ 5U + 8U + 2U ]; /* padding + header, data bytes and CRC sequence, MSB first */
+    uint8_t  dlc       = datalength & ( DLC_BIT_3 | DLC_BIT_2 | DLC_BIT_1 | DLC_BIT_0 );
+    uint8_t  rtr       = 0U;
+    uint8_t  databytes = 0U;
+    uint8_t  nbytes;
+    uint8_t  headerbits;
+    uint8_t  pad;
+    uint8_t  item;
+    uint8_t  state;
+    uint8_t  stuffbits = 0U;
+    uint8_t  endbit;
+    uint8_t  bit;
+    uint16_t crc = 0U;
+    uint32_t low;
+    uint32_t sid;
+
+    /* If CAN frame is remote (either standard or extended frame), it has no data field */
+    if ( ( frametype == TX_STANDARD_REMOTE_FRAME ) || ( frametype == TX_EXTENDED_REMOTE_FRAME ) )
+    {
+        rtr = 1U;
+    }
+    else
+    {
+        databytes = ( dlc > 8U ) ? 8U : dlc;
+    }
+
+    /* If CAN frame is extended (either data or remote frame) */
+    if ( ( frametype == TX_EXTENDED_DATA_FRAME ) || ( frametype == TX_EXTENDED_REMOTE_FRAME ) )
+    {
+        /* SOF | SID[10:0] | SRR | IDE | EID[17:0] | RTR | r1 | r0 | DLC[3:0], right aligned into 5 bytes */
+        sid = ( id >> 18 ) & 0x000007FFUL;
+        low = ( sid << 27 ) | 0x06000000UL | ( ( id & 0x0003FFFFUL ) << 7 ) | ( ( uint32_t )rtr << 6 ) | dlc;
+
+        stream[ 0 ] = ( uint8_t )( sid >> 5 ); /* SOF + SID[10:5] */
+        stream[ 1 ] = ( uint8_t )( low >> 24 );
+        stream[ 2 ] = ( uint8_t )( low >> 16 );
+        stream[ 3 ] = ( uint8_t )( low >> 8 );
+        stream[ 4 ] = ( uint8_t )( low );
+
+        headerbits = CAN_EXTENDED_HEADER_BITS;
+        nbytes     = 5U;
+    }
+    /* If CAN frame is standard (either data or remote frame) */
+    else
+    {
+        /* SOF | SID[10:0] | RTR | IDE | r0 | DLC[3:0], right aligned into 3 bytes */
+        low = ( ( id & 0x000007FFUL ) << 7 ) | ( ( uint32_t )rtr << 6 ) | dlc;
+
+        stream[ 0 ] = ( uint8_t )( low >> 16 );
+        stream[ 1 ] = ( uint8_t )( low >> 8 );
+        stream[ 2 ] = ( uint8_t )( low );
+
+        headerbits = CAN_STANDARD_HEADER_BITS;
+        nbytes     = 3U;
+    }
+
+    /* Number of leading padding bits in the stream */
+    pad = ( uint8_t )( ( nbytes * 8U ) - headerbits );
+
+    /* Append the data field */
+    for ( item = 0U; item < databytes; item++ )
+    {
+        stream[ nbytes++ ] = data[ item ];
+    }
+
+    /* Compute CRC-15 from SOF up to the last data bit (the leading zero padding does not affect it) */
+    for ( item = 0U; item < nbytes; item++ )
+    {
+        crc = ( uint16_t )( ( ( crc << 8 ) ^ crc15_table[ ( ( crc >> 7 ) ^ stream[ item ] ) & 0xFFU ] ) & 0x7FFFU );
+    }
+
+    /* Append the CRC sequence (15 bits, MSB first) */
+    stream[ nbytes ]      = ( uint8_t )( crc >> 7 );
+    stream[ nbytes + 1U ] = ( uint8_t )( crc << 1 );
+
+    /* Stuffing applies from SOF up to the last CRC bit */
+    endbit = ( uint8_t )( ( nbytes * 8U ) + CAN_CRC_BITS );
+
+    /* Force the padding bits of the first nibble to recessive, since the bus is recessive before SOF
+       they cannot complete a run of 5 bits (at most 3 padding bits fall into the first nibble) */
+    item  = pad >> 2;
+    bit   = ( uint8_t )( ( 0xF0U >> ( pad & 0x03U ) ) & 0x0FU );
+    state = STUFF_STATE_IDLE;
+
+    /* Count the stuff bits one nibble at a time */
+    for ( ; ( ( item + 1U ) * 4U ) <= endbit; item++ )
+    {
+        state = stuff_table[ ( state << 4 ) | ( ( ( stream[ item >> 1 ] >> ( ( ~item & 0x01U ) << 2 ) ) & 0x0FU ) | bit ) ];
+        bit   = 0U;
+
+        stuffbits += state >> 3;
+        state     &= 0x07U;
+    }
+
+    /* Count the stuff bits of the last bits that do not fill a whole nibble, one bit at a time */
+    for ( item = ( uint8_t )( item * 4U ); item < endbit; item++ )
+    {
+        bit = ( stream[ item >> 3 ] >> ( 7U - ( item & 0x07U ) ) ) & 0x01U;
+
+        /* same bit as the last one, the run grows */
+        if ( bit == ( state >> 2 ) )
+        {
+            state++;
+
+            /* run of 5 bits, insert a complementary stuff bit which starts a new run */
+            if ( ( state & 0x03U ) == 0x00U )
+            {
+                stuffbits++;
+                state = ( uint8_t )( ( bit ^ 0x01U ) << 2 );
+            }
+        }
+        /* different bit, a new run starts */
+        else
+        {
+            state = ( uint8_t )( bit << 2 );
+        }
+    }
+
+    /* Header + data + CRC sequence + stuff bits + CRC delimiter + ACK field + EOF */
+    return ( uint8_t )( headerbits + ( databytes * 8U ) + CAN_CRC_BITS + stuffbits
+                        + CAN_CRC_DELIMITER_BITS + CAN_ACK_FIELD_BITS + CAN_EOF_BITS );
+}
+
+/**
+ * @brief Convert a number of bits into the time they take on the bus at the specified baud rate, in microseconds.
+ *        The result is rounded up and, unlike dividing 1000000 by the baud rate first, keeps its precision at any baud rate.
+ * 
+ *        Note: 'bits' must be lower than 4295 to prevent the intermediate product from overflowing.
+ * 
+ * @param bits      number of bits on the bus
+ * @param baudrate  CAN baud rate in bps
+ * @return uint32_t time in microseconds
+ */
+uint32_t CAN_Timing_Bits_To_us( uint32_t bits, uint32_t baudrate )
+{
+    return ( ( bits * 1000000UL ) + baudrate - 1UL ) / baudrate;
+}
+
+/**
+ * @brief Search the MCP2515 bit timing (BRP, PropSeg, PS1, PS2 and SJW) that best produces the requested baud rate
+ *        from the given oscillator frequency, with its sample point inside the requested window.
+ * 
+ *        Candidates are ranked by baud rate error first, then by how close the sample point is to the center
+ *        of the window and finally by the number of TQ per bit (more TQ give a finer resynchronization).
+ *        For each BRP only the 2 bit lengths (in TQ) closest to the requested baud rate are evaluated.
+ *        SJW is set to the largest value allowed by PS1, PS2 and the MCP2515 (4TQ), kept below PS2 (PS2 > SJW).
+ * 
+ * @param osc_freq MCP2515 oscillator frequency in Hz (e.g. OSC1_FREQ)
+ * @param baudrate requested CAN baud rate in bps
+ * @param spmin    earliest sample point accepted, in tenths of a percent of the bit time (e.g. 600 = 60.0%)
+ * @param spmax    latest sample point accepted, in tenths of a percent of the bit time (e.g. 875 = 87.5%)
+ * @param cfg      pointer to the bit timing configuration where the solution is stored
+ * @return uint8_t 1 if a bit timing within CAN_TIMING_MAX_ERROR_PPM was found, 0 otherwise
+ */
+uint8_t CAN_Timing_Solve( uint32_t osc_freq, uint32_t baudrate, uint16_t spmin, uint16_t spmax, CAN_Timing_Bit_Config *cfg )
+{
+    uint32_t prescaler;
+    uint32_t ntq;
+    uint32_t tqs;
+    uint32_t ps2;
+    uint32_t tseg1;
+    uint32_t samplepoint;
+    uint32_t distance;
+    uint32_t error;
+    uint64_t actual;
+    uint32_t besterror    = CAN_TIMING_MAX_ERROR_PPM;
+    uint32_t bestdistance = 0xFFFFFFFFUL;
+    uint32_t bestntq      = 0U;
+    uint32_t center       = ( ( uint32_t )spmin + spmax ) / 2U;
+    uint8_t  found        = 0U;
+
+    if ( baudrate == 0U )
+    {
+        return 0U;
+    }
+
+    for ( prescaler = 1U; prescaler <= ( CAN_TIMING_MAX_BRP + 1U ); prescaler++ )
+    {
+        /* bit length (in TQ) right below the requested baud rate */
+        tqs = osc_freq / ( 2U * prescaler * baudrate );
+
+        for ( ntq = tqs; ntq <= ( tqs + 1U ); ntq++ )
+        {
+            if ( ( ntq < CAN_TIMING_MIN_TQ ) || ( ntq > CAN_TIMING_MAX_TQ ) )
+            {
+                continue;
+            }
+
+            /* error = | fosc - baudrate x 2(BRP + 1) x NTQ | / ( baudrate x 2(BRP + 1) x NTQ ), in ppm */
+            actual = ( uint64_t )baudrate * 2U * prescaler * ntq;
+            error  = ( uint32_t )( ( ( ( actual > osc_freq ) ? ( actual - osc_freq ) : ( osc_freq - actual ) ) * 1000000ULL ) / actual );
+
+            if ( error > besterror )
+            {
+                continue;
+            }
+
+            for ( ps2 = CAN_TIMING_MIN_PS2_TQ; ps2 <= CAN_TIMING_MAX_SEG_TQ; ps2++ )
+            {
+                /* PropSeg + PS1 must fit in 2 segments of 8TQ and be at least PS2 */
+                tseg1 = ntq - 1U - ps2;
+
+                if ( ( tseg1 < ps2 ) || ( tseg1 > ( 2U * CAN_TIMING_MAX_SEG_TQ ) ) )
+                {
+                    continue;
+                }
+
+                samplepoint = ( ( ntq - ps2 ) * 1000U ) / ntq;
+
+                if ( ( samplepoint < spmin ) || ( samplepoint > spmax ) )
+                {
+                    continue;
+                }
+
+                distance = ( samplepoint > center ) ? ( samplepoint - center ) : ( center - samplepoint );
+
+                /* keep the candidate if it is better than the best one found so far */
+                if ( ( error < besterror ) ||
+                     ( distance < bestdistance ) ||
+                     ( ( distance == bestdistance ) && ( ntq > bestntq ) ) )
+                {
+                    besterror    = error;
+                    bestdistance = distance;
+                    bestntq      = ntq;
+                    found        = 1U;
+
+                    /* split PropSeg + PS1 evenly, PropSeg takes the odd TQ */
+                    cfg->ps1     = ( uint8_t )( tseg1 / 2U );
+                    cfg->propseg = ( uint8_t )( tseg1 - cfg->ps1 );
+                    cfg->ps2     = ( uint8_t )ps2;
+                    cfg->brp     = ( uint8_t )( prescaler - 1U );
+                    cfg->sjw     = ( cfg->ps1 < ( ps2 - 1U ) ) ? cfg->ps1 : ( uint8_t )( ps2 - 1U ); /* PS2 > SJW */
+
+                    if ( cfg->sjw > CAN_TIMING_MAX_SJW_TQ )
+                    {
+                        cfg->sjw = CAN_TIMING_MAX_SJW_TQ;
+                    }
+
+                    cfg->samplepoint = ( uint16_t )samplepoint;
+                    cfg->baudrate    = baudrate;
+                    cfg->error       = error;
+                }
+            }
+        }
+    }
+
+    if ( found == 1U )
+    {
+        /* Get the bit timing register values (every segment length is stored minus 1) */
+        cfg->cnf[ 0 ] = ( uint8_t )( cfg->ps2 - 1U );                                                                    /* CNF3 register */
+        cfg->cnf[ 1 ] = ( uint8_t )( BTLMODE_PS2_PHSEG2_CNF3 | ( ( cfg->ps1 - 1U ) << 3 ) | ( cfg->propseg - 1U ) );     /* CNF2 register */
+        cfg->cnf[ 2 ] = ( uint8_t )( ( ( cfg->sjw - 1U ) << 6 ) | cfg->brp );                                           /* CNF1 register */
+    }
+
+    return found;
+}
+
+/**
+ * @brief Write the given bit timing configuration to the CNF3, CNF2 and CNF1 registers of the MCP2515 in a single burst,
+ *        keeping the wake-up filter and sample point settings of the handle.
+ * 
+ *        Note: bit timing registers are only modifiable when the MCP2515 is in configuration mode, it is advised then,
+ *              to set it to the proper operation mode before and after calling this function.
+ * 
+ * @param hcan pointer to an MCP2515 configuration structure (CAN module to be configured)
+ * @param cfg  pointer to a bit timing configuration (refer to CAN_Timing_Solve())
+ */
+void CAN_Timing_Set_Bit_Config( CAN_Control_HandleTypeDef *hcan, const CAN_Timing_Bit_Config *cfg )
+{
+    uint8_t spi_write[ 3 ];
+
+    spi_write[ 0 ] = hcan->wakeupfilter | cfg->cnf[ 0 ]; /* CNF3 register */
+    spi_write[ 1 ] = hcan->samplepoint  | cfg->cnf[ 1 ]; /* CNF2 register */
+    spi_write[ 2 ] = cfg->cnf[ 2 ];                      /* CNF1 register */
+    CAN_Control_Register_Write( hcan, CNF3_REG, spi_write, 3U );
+
+    hcan->baudrate = cfg->baudrate;
+}
+
+/**
+ * @brief Detect the baud rate of the CAN bus the MCP2515 is connected to, without ever transmitting on it.
+ * 
+ *        Each candidate baud rate (refer to CAN_BAUD_RATE_LIST in can.h) is written to CNF3..CNF1 in a single burst
+ *        and the MCP2515 listens to the bus in listen-only mode, where it neither acknowledges frames nor sends error frames.
+ *        CANINTF is then polled every CAN_AUTO_BAUD_POLL_US:
+ *        - a frame received in RXB0 or RXB1 (RX0IF/RX1IF) means the candidate is right, detection stops here.
+ *        - a message error (MERRF) means the candidate is wrong, the next one is tried right away.
+ *        - with no traffic the next candidate is tried after 'timeout_ms', which bounds the detection time
+ *          to 'timeout_ms' times the number of candidates.
+ * 
+ *        On success the MCP2515 is left in listen-only mode at the detected baud rate (the received frame is kept in its
+ *        RX buffer) and hcan->baudrate is updated, so the application decides when to join the bus with CAN_Control_Set_Op_Mode().
+ *        On failure the previous baud rate is restored and the MCP2515 is left in configuration mode.
+ * 
+ *        Note: RX buffers are set to receive valid messages only while detecting, and their RXBnCTRL settings restored
+ *              afterwards. Masks must accept every frame (as after a reset) so that any valid frame sets RX0IF/RX1IF.
+ * 
+ * @param hcan       pointer to an MCP2515 configuration structure (CAN node listening to the bus)
+ * @param timeout_ms time to wait for traffic on each candidate baud rate, in milliseconds
+ * @return uint32_t detected baud rate in bps, 0 if none of the candidates received a valid frame
+ */
+uint32_t CAN_Timing_Auto_Baud( CAN_Control_HandleTypeDef *hcan, uint32_t timeout_ms )
+{
+    uint8_t  rxbctrl[ 2 ];
+    uint8_t  spi_write = RXM_RECEIVE_ONLY_VALID_MESSAGE;
+    uint8_t  intf;
+    uint8_t  i;
+    uint32_t polls;
+    uint32_t baudrate = 0U;
+
+    /* Save RXB0CTRL and RXB1CTRL and let both RX buffers receive valid messages only */
+    CAN_Control_Register_Read( hcan, RXB0CTRL_REG, &rxbctrl[ 0 ], 1U );
+    CAN_Control_Register_Read( hcan, RXB1CTRL_REG, &rxbctrl[ 1 ], 1U );
+    CAN_Control_Register_Bit( hcan, RXB0CTRL_REG, RXM_BIT_1 | RXM_BIT_0, spi_write );
+    CAN_Control_Register_Bit( hcan, RXB1CTRL_REG, RXM_BIT_1 | RXM_BIT_0, spi_write );
+
+    for ( i = 0U; ( i < ( sizeof( auto_baud_rates ) / sizeof( auto_baud_rates[ 0 ] ) ) ) && ( baudrate == 0U ); i++ )
+    {
+        /* Write the candidate bit timing (CNF registers are only modifiable in configuration mode) */
+        CAN_Control_Set_Op_Mode_Wait( hcan, CONFIGURATION_OP_MODE, CAN_OPMODE_TIMEOUT_US );
+        CAN_Control_Set_Baud_Rate( hcan, auto_baud_rates[ i ] );
+
+        /* Clear any stale message error and RX flags, then listen to the bus */
+        CAN_Control_Register_Bit( hcan, CANINTF_REG, MERRE_MSG_ERROR_INTERRUPT_ENABLED | RX1IE_RXB1_FULL_INTERRUPT_ENABLED |
+                                                     RX0IE_RXB0_FULL_INTERRUPT_ENABLED, 0U );
+        CAN_Control_Set_Op_Mode( hcan, LISTEN_ONLY_OP_MODE );
+
+        for ( polls = ( timeout_ms * 1000U ) / CAN_AUTO_BAUD_POLL_US; polls > 0U; polls-- )
+        {
+            TIM3_Delay_us( CAN_AUTO_BAUD_POLL_US );
+            intf = CAN_Control_INT_Status( hcan );
+
+            /* A valid frame was received, candidate is right */
+            if ( ( intf & ( RX1IE_RXB1_FULL_INTERRUPT_ENABLED | RX0IE_RXB0_FULL_INTERRUPT_ENABLED ) ) != 0U )
+            {
+                baudrate = auto_baud_rates[ i ];
+                break;
+            }
+
+            /* A frame could not be decoded, candidate is wrong */
+            if ( ( intf & MERRE_MSG_ERROR_INTERRUPT_ENABLED ) != 0U )
+            {
+                break;
+            }
+        }
+    }
+
+    /* Clear the message error flag left by the wrong candidates */
+    CAN_Control_Register_Bit( hcan, CANINTF_REG, MERRE_MSG_ERROR_INTERRUPT_ENABLED, 0U );
+
+    if ( baudrate != 0U )
+    {
+        hcan->baudrate = baudrate;
+    }
+    else
+    {
+        /* No candidate worked, restore the previous baud rate */
+        CAN_Control_Set_Op_Mode_Wait( hcan, CONFIGURATION_OP_MODE, CAN_OPMODE_TIMEOUT_US );
+        CAN_Control_Set_Baud_Rate( hcan, hcan->baudrate );
+    }
+
+    /* Restore RXB0CTRL and RXB1CTRL */
+    CAN_Control_Register_Write( hcan, RXB0CTRL_REG, &rxbctrl[ 0 ], 1U );
+    CAN_Control_Register_Write( hcan, RXB1CTRL_REG, &rxbctrl[ 1 ], 1U );
+
+    return baudrate;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file      can_timing.h
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the definitions and function prototypes for the CAN bit-level timing computations
+ *            of the CAN Controller Module (MCP2515), such as the exact on-wire length of a CAN frame.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#ifndef CAN_TIMING_H
+#define CAN_TIMING_H
+
+    #include <stdint.h>
+    #include "can.h"
+
+    /* CAN frame field lengths (in bits) that are not subject to bit stuffing */
+    #define CAN_CRC_DELIMITER_BITS              (1U)
+    #define CAN_ACK_FIELD_BITS                  (2U)
+    #define CAN_EOF_BITS                        (7U)
+    #define CAN_INTERMISSION_BITS               (3U)
+
+    /* CAN frame header lengths (in bits), from SOF up to the last DLC bit */
+    #define CAN_STANDARD_HEADER_BITS            (19U)
+    #define CAN_EXTENDED_HEADER_BITS            (39U)
+
+    /* CAN CRC-15 sequence length (in bits) and generator polynomial x^15 + x^14 + x^10 + x^8 + x^7 + x^4 + x^3 + 1 */
+    #define CAN_CRC_BITS                        (15U)
+    #define CAN_CRC_POLYNOMIAL                  (0x4599U)
+
+    /* MCP2515 bit timing limits (in TQ). A nominal bit time is SyncSeg (1TQ) + PropSeg + PS1 + PS2 */
+    #define CAN_TIMING_MIN_TQ                   (5U)
+    #define CAN_TIMING_MAX_TQ                   (25U)
+    #define CAN_TIMING_MAX_SEG_TQ               (8U)
+    #define CAN_TIMING_MIN_PS2_TQ               (2U)
+    #define CAN_TIMING_MAX_SJW_TQ               (4U)
+    #define CAN_TIMING_MAX_BRP                  (63U)
+
+    /* Largest bit rate error (in ppm) accepted by the bit timing solver */
+    #define CAN_TIMING_MAX_ERROR_PPM            (5000U)
+
+    /* Sample point targeted by the compile-time bit timings, in tenths of a percent of the bit time */
+    #define CAN_TIMING_SAMPLE_POINT             (700U)
+
+    /* Macros to compute at build time the MCP2515 bit timing for the oscillator frequency 'osc' and baud rate 'b'.
+       The longest bit (in TQ) that divides the oscillator exactly is taken, if there is none, the smallest prescaler
+       that fits the bit in CAN_TIMING_MAX_TQ is taken instead. PS2 is rounded to the closest CAN_TIMING_SAMPLE_POINT and
+       PropSeg + PS1 is split evenly, PropSeg takes the odd TQ.
+       CAN_TIMING_VALID() tells whether the result meets the MCP2515 limits and CAN_TIMING_MAX_ERROR_PPM */
+    #define CAN_TIMING_EXACT( osc, b, n )       ( ( ( (osc) % ( 2UL * (b) * (n) ) ) == 0UL ) && ( ( (osc) / ( 2UL * (b) * (n) ) ) <= ( CAN_TIMING_MAX_BRP + 1UL ) ) )
+    #define CAN_TIMING_EXACT_NTQ( osc, b )      ( \
+                                                  CAN_TIMING_EXACT( osc, b, 25UL ) ? 25UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 24UL ) ? 24UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 23UL ) ? 23UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 22UL ) ? 22UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 21UL ) ? 21UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 20UL ) ? 20UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 19UL ) ? 19UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 18UL ) ? 18UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 17UL ) ? 17UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 16UL ) ? 16UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 15UL ) ? 15UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 14UL ) ? 14UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 13UL ) ? 13UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 12UL ) ? 12UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 11UL ) ? 11UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 10UL ) ? 10UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 9UL ) ? 9UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 8UL ) ? 8UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 7UL ) ? 7UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 6UL ) ? 6UL : \
+                                                  CAN_TIMING_EXACT( osc, b, 5UL ) ? 5UL : 0UL )
+    #define CAN_TIMING_CEIL_PRESCALER( osc, b ) ( ( (osc) + 2UL * (b) * CAN_TIMING_MAX_TQ - 1UL ) / ( 2UL * (b) * CAN_TIMING_MAX_TQ ) )
+    #define CAN_TIMING_PRESCALER( osc, b )      ( ( CAN_TIMING_EXACT_NTQ( osc, b ) != 0UL ) ? ( (osc) / ( 2UL * (b) * CAN_TIMING_EXACT_NTQ( osc, b ) ) ) : \
+                                                  CAN_TIMING_CEIL_PRESCALER( osc, b ) )
+    #define CAN_TIMING_NTQ( osc, b )            ( ( CAN_TIMING_EXACT_NTQ( osc, b ) != 0UL ) ? CAN_TIMING_EXACT_NTQ( osc, b ) : \
+                                                  ( (osc) / ( 2UL * (b) * CAN_TIMING_CEIL_PRESCALER( osc, b ) ) ) )
+    #define CAN_TIMING_PS2_ROUND( osc, b )      ( ( CAN_TIMING_NTQ( osc, b ) * ( 1000UL - CAN_TIMING_SAMPLE_POINT ) + 500UL ) / 1000UL )
+    #define CAN_TIMING_PS2( osc, b )            ( ( CAN_TIMING_PS2_ROUND( osc, b ) < CAN_TIMING_MIN_PS2_TQ ) ? CAN_TIMING_MIN_PS2_TQ :   \
+                                                  ( ( CAN_TIMING_PS2_ROUND( osc, b ) > CAN_TIMING_MAX_SEG_TQ ) ? CAN_TIMING_MAX_SEG_TQ : \
+                                                    CAN_TIMING_PS2_ROUND( osc, b ) ) )
+    #define CAN_TIMING_TSEG1( osc, b )          ( CAN_TIMING_NTQ( osc, b ) - 1UL - CAN_TIMING_PS2( osc, b ) )
+    #define CAN_TIMING_PS1( osc, b )            ( CAN_TIMING_TSEG1( osc, b ) / 2UL )
+    #define CAN_TIMING_PROPSEG( osc, b )        ( CAN_TIMING_TSEG1( osc, b ) - CAN_TIMING_PS1( osc, b ) )
+    #define CAN_TIMING_SJW( osc, b )            ( ( CAN_TIMING_PS1( osc, b ) < ( CAN_TIMING_PS2( osc, b ) - 1UL ) ) ?           \
+                                                  ( ( CAN_TIMING_PS1( osc, b ) < CAN_TIMING_MAX_SJW_TQ ) ? CAN_TIMING_PS1( osc, b ) : CAN_TIMING_MAX_SJW_TQ ) : \
+                                                  ( ( ( CAN_TIMING_PS2( osc, b ) - 1UL ) < CAN_TIMING_MAX_SJW_TQ ) ? ( CAN_TIMING_PS2( osc, b ) - 1UL ) : \
+                                                    CAN_TIMING_MAX_SJW_TQ ) )
+    #define CAN_TIMING_ERROR_PPM( osc, b )      ( ( ( (osc) - 2ULL * (b) * CAN_TIMING_PRESCALER( osc, b ) * CAN_TIMING_NTQ( osc, b ) ) * 1000000ULL ) / \
+                                                  ( 2ULL * (b) * CAN_TIMING_PRESCALER( osc, b ) * CAN_TIMING_NTQ( osc, b ) ) )
+    #define CAN_TIMING_VALID( osc, b )          ( ( CAN_TIMING_PRESCALER( osc, b ) <= ( CAN_TIMING_MAX_BRP + 1UL ) ) && \
+                                                  ( CAN_TIMING_NTQ( osc, b ) >= CAN_TIMING_MIN_TQ )                    && \
+                                                  ( CAN_TIMING_TSEG1( osc, b ) >= CAN_TIMING_PS2( osc, b ) )           && \
+                                                  ( CAN_TIMING_TSEG1( osc, b ) <= ( 2UL * CAN_TIMING_MAX_SEG_TQ ) )    && \
+                                                  ( CAN_TIMING_PS2( osc, b ) > CAN_TIMING_SJW( osc, b ) )              && \
+                                                  ( CAN_TIMING_ERROR_PPM( osc, b ) <= CAN_TIMING_MAX_ERROR_PPM ) )
+
+    /* Macros to compute at build time the CNF3, CNF2 and CNF1 register values (without WAKFIL, SOF and SAM bits) */
+    #define CAN_TIMING_CNF3( osc, b )           ( ( uint8_t )( CAN_TIMING_PS2( osc, b ) - 1UL ) )
+    #define CAN_TIMING_CNF2( osc, b )           ( ( uint8_t )( BTLMODE_PS2_PHSEG2_CNF3 | ( ( CAN_TIMING_PS1( osc, b ) - 1UL ) << 3 ) | \
+                                                               ( CAN_TIMING_PROPSEG( osc, b ) - 1UL ) ) )
+    #define CAN_TIMING_CNF1( osc, b )           ( ( uint8_t )( ( ( CAN_TIMING_SJW( osc, b ) - 1UL ) << 6 ) | ( CAN_TIMING_PRESCALER( osc, b ) - 1UL ) ) )
+
+    /* Automatic baud rate detection polling period in microseconds */
+    #define CAN_AUTO_BAUD_POLL_US               (100U)
+
+    /* Structure that holds a bit timing configuration found by the bit timing solver */
+    typedef struct
+    {
+        uint8_t  brp;              /* Baud rate prescaler, TQ = 2(BRP + 1)/fosc (0 to 63)                          */
+        uint8_t  propseg;          /* Propagation segment length in TQ (1 to 8)                                    */
+        uint8_t  ps1;              /* Phase segment 1 length in TQ (1 to 8)                                        */
+        uint8_t  ps2;              /* Phase segment 2 length in TQ (2 to 8)                                        */
+        uint8_t  sjw;              /* Synchronization jump width in TQ (1 to 4)                                    */
+        uint8_t  cnf[ 3 ];         /* CNF3, CNF2 and CNF1 register values (without WAKFIL, SOF and SAM bits)       */
+        uint16_t samplepoint;      /* Sample point position in tenths of a percent of the bit time (e.g. 875)      */
+        uint32_t baudrate;         /* Requested baud rate in bps                                                   */
+        uint32_t error;            /* Achieved baud rate error in ppm                                              */
+    } CAN_Timing_Bit_Config;
+
+    /* CAN frame bit length and duration functions */
+    uint8_t CAN_Timing_Frame_Bits( uint8_t frametype, uint32_t id, uint8_t datalength, const uint8_t *data );
+    uint32_t CAN_Timing_Bits_To_us( uint32_t bits, uint32_t baudrate );
+
+    /* MCP2515 bit timing solver and configuration functions */
+    uint8_t CAN_Timing_Solve( uint32_t osc_freq, uint32_t baudrate, uint16_t spmin, uint16_t spmax, CAN_Timing_Bit_Config *cfg );
+    void CAN_Timing_Set_Bit_Config( CAN_Control_HandleTypeDef *hcan, const CAN_Timing_Bit_Config *cfg );
+
+    /* MCP2515 automatic baud rate detection function */
+    uint32_t CAN_Timing_Auto_Baud( CAN_Control_HandleTypeDef *hcan, uint32_t timeout_ms );
+
+#endif
@@ -3,7 +3,7 @@
  * @author    Julio Cesar Bernal Mendez
  * 
  * @brief     This file contains the bit definitions for the STM32F070RBT6 board's GPIOs needed for the
- *            SPI 1 and 2 peripherals that can handle the CAN Controller Driver.
+ *            SPI 1 and 2 peripherals that can handle the CAN Controller Driver and for the TIM1 external clock input.
  *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
  * 
  * @version   1.0
@@ -17,6 +17,10 @@
 
     #include "stm32f0xx.h"
 
+    /* Macro to enable the clock of any GPIO port in the RCC (GPIOA to GPIOF are 0x400 apart, IOPxEN bits are contiguous) */
+    #define GPIO_CLK_ENBL( port ) \
+        (RCC->AHBENR |= ( RCC_AHBENR_GPIOAEN << ( ( ( uint32_t )( uintptr_t )( port ) - GPIOA_BASE ) / 0x400U ) ))
+
     /* --------------------------------- SPI1 --------------------------------- */
     /* Macro to enable GPIOA clock in the RCC */
     #define GPIOA_CLK_ENBL()      (RCC->AHBENR |= RCC_AHBENR_GPIOAEN)
@@ -61,4 +65,11 @@
     #define GPIO_AFRH_AFSEL15_1   (0x01U << 29)
     #define GPIO_AFRH_AFSEL15_0   (0x01U << 28)
 
+    /* ------------------------------- TIM1_ETR ------------------------------- */
+    /* GPIOx pin 12 alternate function mode bit definitions */
+    #define GPIO_AFRH_AFSEL12_3   (0x01U << 19)
+    #define GPIO_AFRH_AFSEL12_2   (0x01U << 18)
+    #define GPIO_AFRH_AFSEL12_1   (0x01U << 17)
+    #define GPIO_AFRH_AFSEL12_0   (0x01U << 16)
+
 #endif
@@ -14,6 +14,8 @@
  *                            | PA5 (SPI1_SCK)   |     Controller1_SCK      |
  *                            | PA6 (SPI1_MISO)  |     Controller1_MISO     |
  *                            | PA7 (SPI1_MOSI)  |     Controller1_MOSI     |
+ *                            | PA8 (EXTI8)      |     Controller1_INT      |
+ *                            | PA12 (TIM1_ETR)  |     Controller1_CLKOUT   |
  *                            |                  |                          |
  *                            | PB12 (SPI2_CS)   |     Controller2_CS       |
  *                            | PB13 (SPI2_SCK)  |     Controller2_SCK      |
@@ -37,6 +39,9 @@
 /* System clock frequency global variable (system_stm32f0xx.c) */
 extern uint32_t SystemCoreClock;
 
+/* Frames received by MCP2515 #2 per message of the list in can_messages.h */
+uint32_t board_can_count[ BOARD_CAN_MESSAGE_COUNT ] = { 0U };
+
 /**
  * @brief  Main function used for CAN controller driver testing
  */
@@ -55,6 +60,9 @@ int main( void )
    CAN_Control_TX CAN1_TX = { 0U };
    CAN_Control_RX CAN2_RX = { 0U };
 
+   /* CAN frame received by MCP2515 #2, dispatched by ID (see can_messages.h) */
+   CAN_Control_Frame CAN2_Frame;
+
    /* TX statuses of TXB0, TXB1 and TXB2 respectively for MCP2515 #1 */
    uint8_t tx_status[ 3 ] = { 0U };
 
@@ -64,12 +72,28 @@ int main( void )
    /* uint8_t Error flags for MCP2515 #1 */
    uint8_t err_status = 0U;
 
+   /* Fault confinement manager (bus-off recovery) of the MCP2515 #1 */
+   CAN_Fault_Manager CAN1_Fault = { 0U };
+
    /* Transmission Error Counter (TEC) and Receive Error Counter (REC) of the MCP2515 #1 */
    uint8_t tec = 0U;
    uint8_t rec = 0U;
 
+#ifdef CAN_FAST_BOOT
+   /* Register image of the MCP2515 #1 configuration (written in a single burst at boot), either stored
+      in the configuration flash page or built from CAN1_Handler when none is stored yet */
+   CAN_Control_Image        CAN1_Image;
+   const CAN_Control_Image *CAN1_Stored;
+
+   /* Result of the MCP2515 #1 initialization from its register image (IMAGE_OK or IMAGE_RESUMED when it succeeded,
+      refer to 'MCP2515 register image initialization results' in can.h) and of the image storage (CONFIG_OK when
+      the image was stored, refer to can_config.h). Read them with the debugger when MCP2515 #1 does not come up */
+   uint8_t image_status  = IMAGE_VERIFY_ERROR;
+   uint8_t config_status = CONFIG_EMPTY;
+#else
    /* Milliseconds variable used for testing */
    uint16_t ms;
+#endif
 
    /* Update SystemCoreClock global variable (should be read as 48000000 after this function's execution) */
    SystemCoreClockUpdate();
@@ -77,15 +101,19 @@ int main( void )
    /* Initialize TIM3 peripheral for debugging purposes (0.5us time base) */
    TIM3_Init();
 
-   /* 3 secs delay for debugging purposes */
+   /* Start the SysTick cycle counter for the profiling counters (regions are only recorded
+      when PROFILE_ENABLED is defined, read them back with PROFILE_Get_Stats()) */
+   PROFILE_Init();
+
+#ifndef CAN_FAST_BOOT
+   /* 3 secs delay for debugging purposes (pass -DCAN_FAST_BOOT to the compiler to skip it and to initialize
+      MCP2515 #1 from a register image, on the bus within a few milliseconds from power-up) */
    for ( ms = 0U; ms < 3000U; ms++ )
    {  
       /* 1ms delay */
       TIM3_Delay_us( 1000U );
    }
-
-   /* Initialize Nucleo board's user button */
-   Board_Button_Init();
+#endif
 
    /* Initialize CAN controller MCP2515 #1 (uses SPI1, see pinout at the top of this file) */
    CAN1_Handler.spi               = CAN_SPI1;
@@ -95,8 +123,47 @@ int main( void )
    CAN1_Handler.wakeupfilter      = WAKE_UP_FILTER_DISABLED;
    CAN1_Handler.rxbufferopmode    = RXB0_RECEIVE_VALID_MSG | RXB1_TURN_MASKS_FILTERS_OFF;
    CAN1_Handler.rxbuffer0rollover = RXB0_ROLLOVER_DISABLED;
+   CAN1_Handler.clkout            = CLKOUT_SYSTEMCLK_NO_DIV;
    CAN1_Handler.opmode            = NORMAL_OP_MODE;
+#ifdef CAN_FAST_BOOT
+   CAN1_Stored = CAN_Config_Load( 0U );
+
+   if ( CAN1_Stored != NULL )
+   {
+      /* no MCP2515 reset when it kept running across an MCU reset */
+      image_status  = CAN_Control_Warm_Start( &CAN1_Handler, CAN1_Stored );
+      config_status = CONFIG_OK;
+   }
+   else if ( CAN_Control_Build_Image( &CAN1_Handler, NULL, NULL, 0U, &CAN1_Image ) == 1U )
+   {
+      /* first boot: build the image, join the bus, then store the image for the next boots,
+         only once the MCP2515 runs with it (a failed image is never persisted). The image enables
+         no interrupts, they are enabled further down on every boot (a warm start does not check them) */
+      image_status = CAN_Control_Warm_Start( &CAN1_Handler, &CAN1_Image );
+
+      if ( ( image_status == IMAGE_OK ) || ( image_status == IMAGE_RESUMED ) )
+      {
+         config_status = CAN_Config_Store( &CAN1_Image, 1U );
+      }
+   }
+   else
+   {
+      /* Do nothing (no image for this configuration, e.g. baud rate not supported with OSC1_FREQ) */
+   }
+
+   /* the image did not come up or could not be built: field by field initialization instead
+      (image_status and config_status are kept for the debugger) */
+   if ( ( image_status != IMAGE_OK ) && ( image_status != IMAGE_RESUMED ) )
+   {
+      CAN_Control_Init( &CAN1_Handler );
+   }
+#else
    CAN_Control_Init( &CAN1_Handler );
+#endif
+
+   /* Clock TIM1 from the MCP2515 #1 CLKOUT pin (8MHz, see pinout at the top of this file),
+      TIM1_Get_Ticks() then returns timestamps in the CAN controller's oscillator domain */
+   TIM1_ETR_Init();
 
    /* Initialize CAN controller MCP2515 #2 (uses SPI2, see pinout at the top of this file) */
    CAN2_Handler.spi               = CAN_SPI2;
@@ -106,11 +173,13 @@ int main( void )
    CAN2_Handler.wakeupfilter      = WAKE_UP_FILTER_DISABLED;
    CAN2_Handler.rxbufferopmode    = RXB0_RECEIVE_VALID_MSG | RXB1_RECEIVE_VALID_MSG;
    CAN2_Handler.rxbuffer0rollover = RXB0_ROLLOVER_DISABLED;
+   CAN2_Handler.clkout            = CLKOUT_DISABLED;
    CAN2_Handler.opmode            = NORMAL_OP_MODE;
    CAN_Control_Init( &CAN2_Handler );
 
-   /* Set MCP2515 #2 into configuration mode in order to write to its mask and filter registers */
-   CAN_Control_Set_Op_Mode( &CAN2_Handler, CONFIGURATION_OP_MODE );
+   /* Set MCP2515 #2 into configuration mode in order to write to its mask and filter registers
+      (and wait for it to be there, the registers are not writable before) */
+   CAN_Control_Set_Op_Mode_Wait( &CAN2_Handler, CONFIGURATION_OP_MODE, CAN_OPMODE_TIMEOUT_US );
 
    /* Set all the 11 bits (standard ID field) in the RXM0 mask (RX buffer 0)
       and set all the 29 bit (standard ID and extended ID fields) in the RXM1 mask (RX buffer 1)
@@ -219,29 +288,38 @@ int main( void )
    /* Read TX status of TX buffer 0 on the MCP2515 #1 */
    tx_status[ 0 ] = CAN_Control_TX_CAN_Status( &CAN1_Handler, TXB0 ); /* should be read TX_SUCCESS (0x05) */
 
-   /* Continue only if shortcirtuit was undone before executing previous line and TXEP = 1 in err_status,
-      the idea is the MCP2515 to be in passive-error state, unless error counters TEC and REC are cleared */
+   /* From here on the fault confinement manager supervises MCP2515 #1: it follows the error-passive state
+      down to error-active as TEC and REC decrease and, if the bus is shortcircuited again until bus-off,
+      brings the node back to the bus 100ms later (200ms, 400ms... on consecutive bus-offs, up to 1.6s)
+      and requeues the frames that were pending, no manual reset is needed */
+   CAN1_Fault.hcan       = &CAN1_Handler;
+   CAN1_Fault.policy     = FAULT_POLICY_BACKOFF;
+   CAN1_Fault.delayms    = 100U;
+   CAN1_Fault.maxdelayms = 1600U;
+   CAN1_Fault.maxretries = 0U;                                                         /* not used by the backoff policy */
+   CAN1_Fault.ticksperms = GET_CLKOUT_FREQ( OSC1_FREQ, CLKOUT_SYSTEMCLK_NO_DIV ) / 1000U; /* TIM1 is clocked by MCP2515 #1 CLKOUT */
+   CAN_Fault_Init( &CAN1_Fault );
 
    while( 1 )
    {  
-      /* Read both MCP2515 #1 TEC and REC counters.
-         Their values should be fixed since the MCP2515 is stuck at passive-error state
-         and there are no more errors on the bus */
+      /* Read both MCP2515 #1 TEC and REC counters */
       CAN_Control_Register_Read( &CAN1_Handler, TEC_REG, &tec, 1U );
       CAN_Control_Register_Read( &CAN1_Handler, REC_REG, &rec, 1U );
 
-      /* If user button on the Nucleo board is pressed */
-      if ( ( GPIOC->IDR & GPIO_IDR_13 ) == 0U )
+      /* If the error interrupt flag (ERRIF) of MCP2515 #1 is set, let the fault confinement manager handle it */
+      if ( ( CAN_Control_INT_Status( &CAN1_Handler ) & ERRIE_ERROR_INTERRUPT_ENABLED ) == ERRIE_ERROR_INTERRUPT_ENABLED )
       {
-         /* Set MCP2515 #1 into configuration mode in order to clear
-            TEC and REC error counters and return to active-error state */
-         CAN_Control_Set_Op_Mode( &CAN1_Handler, CONFIGURATION_OP_MODE );
-         
-         /* Set MCP2515 #1 back to normal operation mode */
-         CAN_Control_Set_Op_Mode( &CAN1_Handler, NORMAL_OP_MODE );
-
-         /* Read MCP2515 #1 Errors */
-         err_status = CAN_Control_ERR_Status( &CAN1_Handler ); /* no more errors */
+         CAN_Fault_ERR_IRQ( &CAN1_Fault );
+      }
+
+      /* Scheduled bus-off recovery and error state tracking of MCP2515 #1 */
+      CAN_Fault_Process( &CAN1_Fault );
+
+      /* Route the frames received by MCP2515 #2 to the handlers of their IDs (perfect hash table generated
+         at build time from the message list in can_messages.h, frames of other IDs are dropped) */
+      while ( CAN_Control_Receive_Frame( &CAN2_Handler, &CAN2_Frame ) == 1U )
+      {
+         CAN_Dispatch_By_ID( &board_can_ids, &CAN2_Frame );
       }
 
       /* 50 ms delay */
@@ -252,15 +330,14 @@ int main( void )
 }
 
 /**
- * @brief Initialize the Nucleo board's user button as digital input
+ * @brief Handler of the messages in can_messages.h, counts the frames received of each message
  * 
+ * @param frame   pointer to the received CAN frame
+ * @param context pointer to the frame counter of the message
  */
-void Board_Button_Init( void )
-{  
-   /* Enable GPIOC clock access */
-   RCC->AHBENR |= RCC_AHBENR_GPIOCEN;
+void Board_CAN_Message( const CAN_Control_Frame *frame, void *context )
+{
+   ( void )frame;
 
-   /* Enable GPIOC13 as digital input */
-   GPIOC->MODER &= ~GPIO_MODER_MODER13_1;
-   GPIOC->MODER &= ~GPIO_MODER_MODER13_0;
+   ( *( uint32_t * )context )++;
 }
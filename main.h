@@ -16,8 +16,15 @@
     #include "spi.h"
     #include "timer.h"
     #include "can.h"
-
-    /* STM32F070RB Nucleo board's user button function */
-    void Board_Button_Init( void );
+    #include "can_timing.h"
+    #include "can_busload.h"
+    #include "can_fault.h"
+    #include "can_pool.h"
+    #include "can_filter.h"
+    #include "can_dispatch.h"
+    #include "can_service.h"
+    #include "can_config.h"
+    #include "can_messages.h"
+    #include "power.h"
 
 #endif
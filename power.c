@@ -0,0 +1,224 @@
+/**
+ * @file      power.c
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the function implementations for the low-power manager, which coordinates
+ *            the MCP2515 sleep mode with the STOP mode of the STM32F070RB (wake-on-CAN through the MCP2515 INT pin).
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ *            STM32F070RB MCP2515 INT pinout:
+ *            -------------------------------
+ *            - PA8 (EXTI8, MCP2515 INT)
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#include "power.h"
+
+/* Set by the EXTI8 interrupt when the MCP2515 INT pin goes LOW */
+static volatile uint8_t pwr_wake_flag = 0U;
+
+/* TIM1 ticks captured by the EXTI8 interrupt, first instruction executed after the STM32F070RB wakes up */
+static volatile uint32_t pwr_wake_tick = 0U;
+
+/**
+ * @brief Initialize PA8 as the input for the MCP2515 INT pin (active LOW) and map it to the EXTI line 8:
+ *        - Input with pull-up
+ *        - EXTI line 8 interrupt on falling edge (also a wake-up source from STOP mode)
+ */
+void PWR_INT_Pin_Init( void )
+{
+    /* enable GPIOA and SYSCFG clock access */
+    GPIOA_CLK_ENBL();
+    SYSCFG_CLK_ENBL();
+
+    /* PA8 as input */
+    GPIOA->MODER &= ~GPIO_MODER_MODER8_1;
+    GPIOA->MODER &= ~GPIO_MODER_MODER8_0;
+
+    /* PA8 with pull-up (INT pin idle state is HIGH) */
+    GPIOA->PUPDR &= ~GPIO_PUPDR_PUPDR8_1;
+    GPIOA->PUPDR |=  GPIO_PUPDR_PUPDR8_0;
+
+    /* Map PA8 to EXTI line 8 */
+    SYSCFG->EXTICR[ 2 ] &= ~SYSCFG_EXTICR3_EXTI8;
+    SYSCFG->EXTICR[ 2 ] |=  SYSCFG_EXTICR3_EXTI8_PA;
+
+    /* EXTI line 8 triggers on falling edge only */
+    EXTI->FTSR |=  EXTI_FTSR_TR8;
+    EXTI->RTSR &= ~EXTI_RTSR_TR8;
+
+    /* Clear any pending EXTI line 8 request and unmask its interrupt */
+    EXTI->PR   =  EXTI_PR_PR8;
+    EXTI->IMR |=  EXTI_IMR_MR8;
+
+    NVIC_EnableIRQ( EXTI4_15_IRQn );
+}
+
+/**
+ * @brief Put the STM32F070RB into STOP mode (voltage regulator in low-power mode) until an EXTI interrupt occurs.
+ * 
+ *        Note: when the STM32F070RB leaves STOP mode, HSI (8MHz) is the system clock, therefore PWR_Restore_Clocks()
+ *              must be called before using any peripheral whose timing depends on the 48MHz clock (SPI, TIM3 delays).
+ *              If the MCP2515 INT pin went LOW before this function is called, or is already held LOW (an enabled
+ *              interrupt flag is still set, so no falling edge can come), STOP mode is not entered.
+ *              Any other interrupt that wakes the core up (e.g. TIM1 update) is serviced and STOP mode is entered
+ *              again, the function only returns once the wake-up from the MCP2515 INT pin has happened.
+ */
+void PWR_Enter_Stop_Mode( void )
+{
+    /* enable PWR clock access */
+    PWR_CLK_ENBL();
+
+    /* STOP mode on deepsleep (not STANDBY), voltage regulator in low-power mode */
+    PWR->CR &= ~PWR_CR_PDDS;
+    PWR->CR |=  PWR_CR_LPDS;
+
+    /* Cortex-M0 deepsleep on WFI */
+    SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+
+    /* With interrupts masked, WFI still wakes the core up on a pending interrupt. This prevents a wake-up
+       edge that arrives right before WFI from being serviced and then leaving the core asleep */
+    __disable_irq();
+
+    while ( pwr_wake_flag == 0U )
+    {
+        if ( ( GPIOA->IDR & GPIO_IDR_8 ) == GPIO_IDR_8 )
+        {
+            __WFI();
+
+            /* Service the interrupt that woke the core up: the EXTI line 8 one sets pwr_wake_flag, after any other
+               one the core goes back to STOP mode */
+            __enable_irq();
+            __ISB();
+            __disable_irq();
+        }
+        else
+        {
+            /* INT pin held LOW, no falling edge to wait for: the wake-up is now */
+            pwr_wake_tick = TIM1_Get_Ticks();
+            pwr_wake_flag = 1U;
+        }
+    }
+
+    __enable_irq();
+
+    /* Back to regular sleep on WFI */
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+}
+
+/**
+ * @brief Restore the 48MHz system clock after leaving STOP mode (PLL is turned off in STOP mode).
+ *        PLL source, PREDIV and PLLMUL keep the values set by SystemInit() in system_stm32f0xx.c,
+ *        so only the PLL needs to be turned back on and selected as system clock.
+ */
+void PWR_Restore_Clocks( void )
+{
+    /* turn on PLL */
+    RCC->CR |= RCC_CR_PLLON;
+
+    /* wait for PLL to be ready */
+    while ( ( RCC->CR & RCC_CR_PLLRDY ) != RCC_CR_PLLRDY )
+    {
+        /* do nothing */
+    }
+
+    /* select PLL as system clock (SYSCLK = 48MHz) */
+    RCC->CFGR |=  RCC_CFGR_SW_1;
+    RCC->CFGR &= ~RCC_CFGR_SW_0;
+
+    /* wait for PLL to be selected as system clock */
+    while ( ( RCC->CFGR & RCC_CFGR_SWS ) != RCC_CFGR_SWS_PLL )
+    {
+        /* do nothing */
+    }
+}
+
+/**
+ * @brief Put both the MCP2515 and the STM32F070RB to sleep until activity on the CAN bus wakes them up:
+ *        - put the MCP2515 to sleep with the wake-up filter and wake-up interrupt enabled
+ *        - enter STOP mode on the STM32F070RB with the MCP2515 INT pin (PA8) as EXTI wake-up source
+ *        - restore the 48MHz system clock and bring the MCP2515 back to its operation mode
+ * 
+ *        Frames received by the MCP2515 after waking up are kept in its RX buffers (see CAN_Control_Wake_Up()).
+ *        An attached controller group (refer to CAN_Service_Attach() in can_service.c) is serviced only once this
+ *        function releases the SPI bus, at 48MHz and with the MCP2515 awake.
+ * 
+ *        Note: PWR_INT_Pin_Init() and TIM1_ETR_Init() must be called beforehand, and the MCP2515 CLKOUT pin must be
+ *              enabled and connected to TIM1_ETR. The wake-up latency is then counted in the MCP2515 oscillator
+ *              domain, unaffected by the STM32F070RB clock switching from HSI to PLL.
+ *              Time elapsed between the INT pin edge and the first instruction executed in the EXTI interrupt
+ *              (STOP mode wake-up time, refer to the STM32F070RB datasheet) is not included.
+ * 
+ * @param hcan      pointer to an MCP2515 configuration structure (CAN node whose INT pin is connected to PA8)
+ * @return uint32_t wake-up latency in TIM1 ticks, from the EXTI interrupt to the MCP2515 back in its operation mode.
+ *                  Divide by GET_CLKOUT_FREQ( OSC1_FREQ, hcan->clkout ) to get it in seconds.
+ *                  PWR_SLEEP_ERROR if the MCP2515 did not enter sleep mode within PWR_SLEEP_TIMEOUT_US (the
+ *                  STM32F070RB does not enter STOP mode and the MCP2515 is brought back to its operation mode)
+ */
+uint32_t PWR_CAN_Sleep( CAN_Control_HandleTypeDef *hcan )
+{
+    uint32_t latency;
+
+    pwr_wake_flag = 0U;
+
+    /* Hold the SPI bus until the MCP2515 is back in its operation mode: the wake-up interrupt only captures the
+       wake-up time, and its controller service is deferred until the clocks are restored and the wake-up is
+       handled below (refer to CAN_Service_EXTI_IRQ() in can_service.c) */
+    SPI_Bus_Lock( hcan->spiport );
+
+    /* Put the MCP2515 to sleep */
+    CAN_Control_Sleep( hcan );
+
+    /* Wait for the MCP2515 to actually enter sleep mode (pending transmissions are completed first). Without
+       the MCP2515 in sleep mode no wake-up interrupt would ever come, so STOP mode is not entered */
+    if ( CAN_Control_Wait_Op_Mode( hcan, SLEEP_OP_MODE, PWR_SLEEP_TIMEOUT_US ) == OPMODE_TIMEOUT )
+    {
+        CAN_Control_Wake_Up( hcan );
+        SPI_Bus_Unlock( hcan->spiport );
+        return PWR_SLEEP_ERROR;
+    }
+
+    /* Put the STM32F070RB into STOP mode until the MCP2515 INT pin goes LOW */
+    PWR_Enter_Stop_Mode();
+
+    /* Back to 48MHz before any SPI transaction or TIM3 delay */
+    PWR_Restore_Clocks();
+
+    /* Bring the MCP2515 back to the operation mode selected by user (clears WAKIF) */
+    CAN_Control_Wake_Up( hcan );
+
+    latency = TIM1_Get_Ticks() - pwr_wake_tick;
+
+    /* Release the SPI bus, the deferred controller service runs now */
+    SPI_Bus_Unlock( hcan->spiport );
+
+    return latency;
+}
+
+/**
+ * @brief EXTI lines 4 to 15 interrupt handler, capture the wake-up time when the MCP2515 INT pin (PA8) goes LOW
+ *        and demultiplex the controllers sharing that INT line
+ */
+void EXTI4_15_IRQHandler( void )
+{
+    PROFILE_START( PROFILE_ISR );
+
+    /* if EXTI line 8 is pending */
+    if ( ( EXTI->PR & EXTI_PR_PR8 ) == EXTI_PR_PR8 )
+    {
+        pwr_wake_tick = TIM1_Get_Ticks();
+        pwr_wake_flag = 1U;
+
+        /* clear EXTI line 8 pending request (write 1 to clear) */
+        EXTI->PR = EXTI_PR_PR8;
+
+        /* service the MCP2515s sharing the INT line, if a controller group is attached (refer to can_service.c) */
+        CAN_Service_EXTI_IRQ();
+    }
+
+    PROFILE_STOP( PROFILE_ISR );
+}
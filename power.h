@@ -0,0 +1,45 @@
+/**
+ * @file      power.h
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the definitions and function prototypes for the low-power manager, which coordinates
+ *            the MCP2515 sleep mode with the STOP mode of the STM32F070RB (wake-on-CAN through the MCP2515 INT pin).
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+    #include <stdint.h>
+    #include "stm32f0xx.h"
+    #include "gpio.h"
+    #include "timer.h"
+    #include "can.h"
+    #include "can_service.h"
+
+    /* Macros to enable PWR and SYSCFG clocks in the RCC */
+    #define PWR_CLK_ENBL()       (RCC->APB1ENR |= RCC_APB1ENR_PWREN)
+    #define SYSCFG_CLK_ENBL()    (RCC->APB2ENR |= RCC_APB2ENR_SYSCFGCOMPEN)
+
+    /* Longest time to wait for the MCP2515 to enter sleep mode, in microseconds */
+    #define PWR_SLEEP_TIMEOUT_US (50000U)
+
+    /* PWR_CAN_Sleep() result when the MCP2515 did not enter sleep mode */
+    #define PWR_SLEEP_ERROR      (0xFFFFFFFFUL)
+
+    /* MCP2515 INT pin (PA8) initialization function */
+    void PWR_INT_Pin_Init( void );
+
+    /* STM32F070RB STOP mode entering and clock restoring functions */
+    void PWR_Enter_Stop_Mode( void );
+    void PWR_Restore_Clocks( void );
+
+    /* Wake-on-CAN sleep function */
+    uint32_t PWR_CAN_Sleep( CAN_Control_HandleTypeDef *hcan );
+
+#endif
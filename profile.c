@@ -0,0 +1,137 @@
+/**
+ * @file      profile.c
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the function implementations for the cycle-level profiling counters
+ *            used to measure the CAN Controller Driver hot paths (SPI transactions, frame send/read and ISR).
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#include "profile.h"
+
+/* Statistics of every profiled region (average is only computed on read-out) */
+static PROFILE_Stats profile_regions[ PROFILE_REGIONS ];
+
+/**
+ * @brief Start the SysTick timer as a free-running 24-bit cycle counter clocked by the core clock (48MHz),
+ *        with its interrupt disabled, and clear the statistics of all the profiled regions.
+ */
+void PROFILE_Init( void )
+{
+    /* SysTick reload value, full 24-bit range */
+    SysTick->LOAD = PROFILE_CYCLES_MASK;
+
+    /* clear SysTick counter */
+    SysTick->VAL = 0U;
+
+    /* SysTick clocked by the core clock, interrupt disabled and counter enabled */
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+
+    PROFILE_Reset();
+}
+
+/**
+ * @brief Clear the statistics of all the profiled regions.
+ */
+void PROFILE_Reset( void )
+{
+    uint8_t region;
+
+    for ( region = 0U; region < PROFILE_REGIONS; region++ )
+    {
+        profile_regions[ region ].min     = 0xFFFFFFFFUL;
+        profile_regions[ region ].max     = 0U;
+        profile_regions[ region ].average = 0U;
+        profile_regions[ region ].count   = 0U;
+        profile_regions[ region ].total   = 0U;
+    }
+}
+
+/**
+ * @brief Return the current value of the SysTick cycle counter.
+ *        SysTick counts down, use PROFILE_Record() to compute elapsed cycles.
+ * 
+ * @return uint32_t SysTick counter value (24 bits)
+ */
+uint32_t PROFILE_Get_Cycles( void )
+{
+    return SysTick->VAL;
+}
+
+/**
+ * @brief Record one pass of the specified region, from 'start' (read with PROFILE_Get_Cycles()) until now.
+ *        Only additions and comparisons are performed here, no division.
+ * 
+ * @param region profiled region. Refer to 'Profiled region definitions' in profile.h
+ * @param start  SysTick counter value read when the region was entered
+ */
+void PROFILE_Record( uint8_t region, uint32_t start )
+{
+    uint32_t primask;
+    uint32_t elapsed;
+    PROFILE_Stats *stats;
+
+    /* SysTick counts down, the mask handles the counter wrapping around */
+    elapsed = ( start - SysTick->VAL ) & PROFILE_CYCLES_MASK;
+
+    if ( region < PROFILE_REGIONS )
+    {
+        stats = &profile_regions[ region ];
+
+        /* the same region can be recorded from thread and interrupt context */
+        primask = __get_PRIMASK();
+        __disable_irq();
+
+        if ( elapsed < stats->min )
+        {
+            stats->min = elapsed;
+        }
+
+        if ( elapsed > stats->max )
+        {
+            stats->max = elapsed;
+        }
+
+        stats->count++;
+        stats->total += elapsed;
+
+        __set_PRIMASK( primask );
+    }
+}
+
+/**
+ * @brief Copy the statistics of the specified region into 'stats' and compute its average execution time.
+ *        All times are given in core clock cycles (divide by 48 to get microseconds at 48MHz).
+ * 
+ * @param region profiled region. Refer to 'Profiled region definitions' in profile.h
+ * @param stats  pointer to the structure that will hold the statistics of the region
+ */
+void PROFILE_Get_Stats( uint8_t region, PROFILE_Stats *stats )
+{
+    uint32_t primask;
+
+    if ( region < PROFILE_REGIONS )
+    {
+        primask = __get_PRIMASK();
+        __disable_irq();
+
+        *stats = profile_regions[ region ];
+
+        __set_PRIMASK( primask );
+
+        /* if the region was never executed, report a zero minimum time */
+        if ( stats->count == 0U )
+        {
+            stats->min = 0U;
+        }
+        else
+        {
+            stats->average = ( uint32_t )( stats->total / stats->count );
+        }
+    }
+}
@@ -0,0 +1,68 @@
+/**
+ * @file      profile.h
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     This file contains the definitions and function prototypes for the cycle-level profiling counters
+ *            used to measure the CAN Controller Driver hot paths (SPI transactions, frame send/read and ISR).
+ *            The Cortex-M0 has no DWT cycle counter, so the SysTick timer running at the core clock (48MHz) is used.
+ *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+    #include <stdint.h>
+    #include "stm32f0xx.h"
+
+    /* Uncomment (or pass -DPROFILE_ENABLED to the compiler) to instrument the driver hot paths.
+       When not defined, PROFILE_START() and PROFILE_STOP() expand to nothing and add no code at all */
+    /* #define PROFILE_ENABLED */
+
+    /* Profiled region definitions */
+    #define PROFILE_SPI_TRANSACTION             (0x00U)
+    #define PROFILE_SEND_FRAME                  (0x01U)
+    #define PROFILE_READ_FRAME                  (0x02U)
+    #define PROFILE_ISR                         (0x03U)
+    #define PROFILE_DISPATCH_LOOKUP             (0x04U)
+    #define PROFILE_REGIONS                     (0x05U)
+
+    /* SysTick is a 24-bit down-counter, longest measurable region = 2^24 / 48MHz = 349ms */
+    #define PROFILE_CYCLES_MASK                 (0x00FFFFFFUL)
+
+    /* Macros to instrument a region, the start time is kept in a local variable so that the same region
+       can be safely interrupted and re-entered from an ISR. Both must be used within the same block */
+    #ifdef PROFILE_ENABLED
+        #define PROFILE_START( region )         uint32_t profile_start_##region = PROFILE_Get_Cycles()
+        #define PROFILE_STOP( region )          PROFILE_Record( region, profile_start_##region )
+    #else
+        #define PROFILE_START( region )
+        #define PROFILE_STOP( region )
+    #endif
+
+    /* Structure that holds the statistics of a profiled region (all times in core clock cycles) */
+    typedef struct
+    {
+        uint32_t min;     /* Shortest execution time recorded                      */
+        uint32_t max;     /* Longest execution time recorded                       */
+        uint32_t average; /* Average execution time (total / count)                */
+        uint32_t count;   /* Number of times the region was executed               */
+        uint64_t total;   /* Accumulated execution time of all the recorded passes */
+    } PROFILE_Stats;
+
+    /* Profiling initialization and reset functions */
+    void PROFILE_Init( void );
+    void PROFILE_Reset( void );
+
+    /* Profiling cycle counter read and region recording functions */
+    uint32_t PROFILE_Get_Cycles( void );
+    void PROFILE_Record( uint8_t region, uint32_t start );
+
+    /* Profiling statistics read-out function */
+    void PROFILE_Get_Stats( uint8_t region, PROFILE_Stats *stats );
+
+#endif
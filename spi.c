@@ -3,6 +3,7 @@
  * @author    Julio Cesar Bernal Mendez
  * 
  * @brief     This file contains the High-Level implementations for the SPI 1 and 2 peripherals of the Nucleo Board.
+ *            Several devices can share a bus through the SPI_xxx() functions, each one with its own chip-select pin.
  *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
  * 
  *            STM32F070RB SPI1 and SPI2 pinout:
@@ -25,6 +26,12 @@
 
 #include "spi.h"
 
+/* Nesting depth of the transactions in progress on SPI1 and SPI2 (refer to SPI_Bus_Lock()) */
+static volatile uint8_t spi_bus_locks[ 2 ] = { 0U, 0U };
+
+/* EXTI lines whose interrupt service was deferred until SPI1 and SPI2 are released (refer to SPI_Bus_Defer()) */
+static volatile uint32_t spi_bus_deferred[ 2 ] = { 0U, 0U };
+
 /**
  * @brief Disable (pin is HIGH) the CS line of the SPI1 peripheral of the Nucleo Board
  */
@@ -314,70 +321,141 @@ void SPI2_Init( void )
  */
 void SPI1_Write( uint8_t *data, uint8_t size )
 {
-    uint8_t item;
-    uint8_t temp;
+    SPI_Write( SPI1, data, size );
+}
+
+/**
+ * @brief Write data over the SPI2 MOSI line. The SPI2 chip-select enabling and disabling functions must be
+ *        called before and after this function is executed respectively in order for the writing to take effect.
+ *        The byte read on SPI2 MISO (due to the full-duplex configuration) is simply ignored.
+ * 
+ * @param data data array
+ * @param size number of bytes to be sent from the data array
+ */
+void SPI2_Write( uint8_t *data, uint8_t size )
+{
+    SPI_Write( SPI2, data, size );
+}
+
+/**
+ * @brief Read data from the SPI1 MISO line by sending a zero dummy byte value on SPI1 MOSI for each byte to read
+ *        in order to trigger the sending of information from the slave.
+ * 
+ * @param read data array to store the information read
+ * @param size number of bytes to be read
+ */
+void SPI1_Read( uint8_t *read, uint8_t size )
+{
+    SPI_Read( SPI1, read, size );
+}
+
+/**
+ * @brief Read data from the SPI2 MISO line by sending a zero dummy byte value on SPI2 MOSI for each byte to read
+ *        in order to trigger the sending of information from the slave.
+ * 
+ * @param read data array to store the information read
+ * @param size number of bytes to be read
+ */
+void SPI2_Read( uint8_t *read, uint8_t size )
+{
+    SPI_Read( SPI2, read, size );
+}
+
+/**
+ * @brief Enable the clock of the GPIO port of a chip-select pin and configure the pin as a high-speed push-pull
+ *        output in IDLE state (HIGH). Any GPIO pin can select a device, so several devices can share the same SPI bus.
+ * 
+ * @param port GPIO port of the CS pin (GPIOA to GPIOF)
+ * @param pin  CS pin mask (GPIO_ODR_0 to GPIO_ODR_15)
+ */
+void SPI_CS_Init( GPIO_TypeDef *port, uint16_t pin )
+{
+    uint8_t number = 0U;
 
-    /* Wait for SPI1 bus to be free */
-    while ( ( SPI1->SR & SPI_SR_BSY ) == SPI_SR_BSY )
+    /* Get the pin number from its mask */
+    while ( ( ( uint32_t )pin >> number ) > 1U )
     {
-        /* Do nothing */
+        number++;
     }
-    
-    /* Loop through the data array */
-    for ( item = 0U; item < size; item++ )
-    {   
-        /* Send current byte from the data array */
-        *( uint8_t * )( &( SPI1->DR ) ) = data[ item ];
 
-        /* Wait for SPI1 transmit buffer to be empty */
-        while ( ( SPI1->SR & SPI_SR_TXE ) != SPI_SR_TXE )
-        {
-            /* Do nothing */
-        }
+    /* enable the GPIO port clock access */
+    GPIO_CLK_ENBL( port );
 
-        /* NOTE: SPI1 is configured in 2-line unidirectional and full duplex mode,
-                 therefore for each data sent over MISO, data received in the MISO
-                 pin is sampled every clock cycle, meaning that we send and receive
-                 data at the same time although that may not be what we intend. */
+    /* set CS pin HIGH before it becomes an output */
+    SPI_CS_Disable( port, pin );
 
-        /* Wait for RX buffer to receive 1 data byte (FRXTH = 1) */
-        while ( ( SPI1->SR & SPI_SR_RXNE ) != SPI_SR_RXNE )
+    /* CS pin as general purpose output (MODER = 01), push-pull and high speed */
+    port->MODER   &= ~( 0x03UL << ( number << 1 ) );
+    port->MODER   |=  ( 0x01UL << ( number << 1 ) );
+    port->OTYPER  &= ~( uint32_t )pin;
+    port->OSPEEDR |=  ( 0x03UL << ( number << 1 ) );
+}
+
+/**
+ * @brief Disable (pin is HIGH) a chip-select line, with an atomic write so that an interrupt driving another device
+ *        on the same port can not undo it.
+ * 
+ * @param port GPIO port of the CS pin
+ * @param pin  CS pin mask
+ */
+void SPI_CS_Disable( GPIO_TypeDef *port, uint16_t pin )
+{
+    port->BSRR = pin;
+}
+
+/**
+ * @brief Enable (pin is LOW) a chip-select line with an atomic write.
+ * 
+ * @param port GPIO port of the CS pin
+ * @param pin  CS pin mask
+ */
+void SPI_CS_Enable( GPIO_TypeDef *port, uint16_t pin )
+{
+    port->BRR = pin;
+}
+
+/**
+ * @brief Initialize an SPI bus (SPI1 or SPI2) unless it is already running, so that every device sharing the bus
+ *        can request it.
+ * 
+ * @param spi SPI peripheral (SPI1 or SPI2)
+ */
+void SPI_Bus_Init( SPI_TypeDef *spi )
+{
+    /* Only initialize the bus once (SPE is set by SPIx_Init()) */
+    if ( ( spi->CR1 & SPI_CR1_SPE ) == 0U )
+    {
+        if ( spi == SPI1 )
+        {
+            SPI1_Init();
+        }
+        else if ( spi == SPI2 )
+        {
+            SPI2_Init();
+        }
+        else
         {
             /* Do nothing */
         }
-
-        /* Store data read on MISO (this data will be ignored and not used)
-           in order to clear the RX buffer. Also by reading data the 
-           RXNE flag (receive buffer not empty) is automatically cleared */
-        temp = ( uint8_t )( SPI1->DR );
-    }
-      
-    /* Wait for SPI1 bus to be free */
-    while ( ( SPI1->SR & SPI_SR_BSY ) == SPI_SR_BSY )
-    {
-        /* Do nothing */
     }
-
-    /* Clear the overrun flag just in case the buffer is full and 
-       attempt to store more receiving data on MISO is made */
-    SPI1->SR &= ~SPI_SR_OVR;
 }
 
 /**
- * @brief Write data over the SPI2 MOSI line. The SPI2 chip-select enabling and disabling functions must be
+ * @brief Write data over the MOSI line of an SPI bus. The chip-select enabling and disabling functions must be
  *        called before and after this function is executed respectively in order for the writing to take effect.
- *        The byte read on SPI2 MISO (due to the full-duplex configuration) is simply ignored.
+ *        The byte read on MISO (due to the full-duplex configuration) is simply ignored.
  * 
+ * @param spi  SPI peripheral (SPI1 or SPI2)
  * @param data data array
- * @param size number of bytes to be sent from the data array
+ * @param size number in bytes to be sent from the data array
  */
-void SPI2_Write( uint8_t *data, uint8_t size )
+void SPI_Write( SPI_TypeDef *spi, const uint8_t *data, uint8_t size )
 {
     uint8_t item;
     uint8_t temp;
 
-    /* Wait for SPI2 bus to be free */
-    while ( ( SPI2->SR & SPI_SR_BSY ) == SPI_SR_BSY )
+    /* Wait for SPI bus to be free */
+    while ( ( spi->SR & SPI_SR_BSY ) == SPI_SR_BSY )
     {
         /* Do nothing */
     }
@@ -386,21 +464,21 @@ void SPI2_Write( uint8_t *data, uint8_t size )
     for ( item = 0U; item < size; item++ )
     {   
         /* Send current byte from the data array */
-        *( uint8_t * )( &( SPI2->DR ) ) = data[ item ];
+        *( uint8_t * )( &( spi->DR ) ) = data[ item ];
 
-        /* Wait for SPI2 transmit buffer to be empty */
-        while ( ( SPI2->SR & SPI_SR_TXE ) != SPI_SR_TXE )
+        /* Wait for SPI transmit buffer to be empty */
+        while ( ( spi->SR & SPI_SR_TXE ) != SPI_SR_TXE )
         {
             /* Do nothing */
         }
 
-        /* NOTE: SPI2 is configured in 2-line unidirectional and full duplex mode,
+        /* NOTE: the SPI is configured in 2-line unidirectional and full duplex mode,
                  therefore for each data sent over MISO, data received in the MISO
                  pin is sampled every clock cycle, meaning that we send and receive
                  data at the same time although that may not be what we intend. */
 
         /* Wait for RX buffer to receive 1 data byte (FRXTH = 1) */
-        while ( ( SPI2->SR & SPI_SR_RXNE ) != SPI_SR_RXNE )
+        while ( ( spi->SR & SPI_SR_RXNE ) != SPI_SR_RXNE )
         {
             /* Do nothing */
         }
@@ -408,32 +486,33 @@ void SPI2_Write( uint8_t *data, uint8_t size )
         /* Store data read on MISO (this data will be ignored and not used)
            in order to clear the RX buffer. Also by reading data the 
            RXNE flag (receive buffer not empty) is automatically cleared */
-        temp = ( uint8_t )( SPI2->DR );
+        temp = ( uint8_t )( spi->DR );
     }
       
-    /* Wait for SPI2 bus to be free */
-    while ( ( SPI2->SR & SPI_SR_BSY ) == SPI_SR_BSY )
+    /* Wait for SPI bus to be free */
+    while ( ( spi->SR & SPI_SR_BSY ) == SPI_SR_BSY )
     {
         /* Do nothing */
     }
 
     /* Clear the overrun flag just in case the buffer is full and 
        attempt to store more receiving data on MISO is made */
-    SPI2->SR &= ~SPI_SR_OVR;
+    spi->SR &= ~SPI_SR_OVR;
 }
 
 /**
- * @brief Read data from the SPI1 MISO line by sending a zero dummy byte value on SPI1 MOSI for each byte to read
+ * @brief Read data from the MISO line of an SPI bus by sending a zero dummy byte value on MOSI for each byte to read
  *        in order to trigger the sending of information from the slave.
  * 
+ * @param spi  SPI peripheral (SPI1 or SPI2)
  * @param read data array to store the information read
  * @param size number of bytes to be read
  */
-void SPI1_Read( uint8_t *read, uint8_t size )
+void SPI_Read( SPI_TypeDef *spi, uint8_t *read, uint8_t size )
 {   
     uint8_t item;
 
-    /* NOTE: SPI1 is configured in 2-line unidirectional and 
+    /* NOTE: the SPI is configured in 2-line unidirectional and 
              full duplex mode, therefore for each data sent over MISO,
              data received in the MISO pin is sampled every clock cycle,
              meaning that we send and receive data at the same time
@@ -443,51 +522,86 @@ void SPI1_Read( uint8_t *read, uint8_t size )
     for ( item = 0; item < size; item++, read++ )
     {
         /* send dummy data (this allows us to receive data on MISO) */
-        *( uint8_t * )( &( SPI1->DR ) ) = 0U;
+        *( uint8_t * )( &( spi->DR ) ) = 0U;
 
         /* wait for RX buffer to receive data */
-        while ( ( SPI1->SR & SPI_SR_RXNE ) == 0U )
+        while ( ( spi->SR & SPI_SR_RXNE ) == 0U )
         {
             /* do nothing */
         }
 
         /* store received byte (this also clears
-        the SPI1 RX buffer not empty flag) */
-        *read = ( uint8_t )( SPI1->DR );
+        the SPI RX buffer not empty flag) */
+        *read = ( uint8_t )( spi->DR );
     }
 }
 
 /**
- * @brief Read data from the SPI2 MISO line by sending a zero dummy byte value on SPI2 MOSI for each byte to read
- *        in order to trigger the sending of information from the slave.
+ * @brief Take an SPI bus for a transaction (or a sequence of transactions that must not be interleaved with others).
+ *        Calls nest, the bus is released by the matching SPI_Bus_Unlock(). An interrupt that finds the bus busy
+ *        (refer to SPI_Bus_Busy()) must not start a transaction of its own, since it would clock its bytes in the
+ *        middle of the interrupted one: it defers its service with SPI_Bus_Defer() instead.
  * 
- * @param read data array to store the information read
- * @param size number of bytes to be read
+ *        Note: an interrupt may take the bus too, as long as it releases it before returning.
+ * 
+ * @param spi SPI peripheral (SPI1 or SPI2)
  */
-void SPI2_Read( uint8_t *read, uint8_t size )
+void SPI_Bus_Lock( SPI_TypeDef *spi )
 {
-    uint8_t item;
+    spi_bus_locks[ ( spi == SPI2 ) ? 1U : 0U ]++;
+}
 
-    /* NOTE: SPI2 is configured in 2-line unidirectional and 
-             full duplex mode, therefore for each data sent over MISO,
-             data received in the MISO pin is sampled every clock cycle,
-             meaning that we send and receive data at the same time
-             although that may not be our intention. */
-    
-    /* store each data byte into the array */
-    for ( item = 0; item < size; item++, read++ )
+/**
+ * @brief Release an SPI bus taken with SPI_Bus_Lock(). When the outermost lock is released, the EXTI lines whose
+ *        interrupt service was deferred meanwhile are raised again by software, so their interrupts run right away.
+ * 
+ * @param spi SPI peripheral (SPI1 or SPI2)
+ */
+void SPI_Bus_Unlock( SPI_TypeDef *spi )
+{
+    uint8_t  bus = ( spi == SPI2 ) ? 1U : 0U;
+    uint32_t primask;
+    uint32_t lines = 0U;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    spi_bus_locks[ bus ]--;
+
+    if ( spi_bus_locks[ bus ] == 0U )
     {
-        /* send dummy data (this allows us to receive data on MISO) */
-        *( uint8_t * )( &( SPI2->DR ) ) = 0U;
+        lines                   = spi_bus_deferred[ bus ];
+        spi_bus_deferred[ bus ] = 0U;
+    }
 
-        /* wait for RX buffer to receive data */
-        while ( ( SPI2->SR & SPI_SR_RXNE ) != SPI_SR_RXNE )
-        {
-            /* do nothing */
-        }
+    __set_PRIMASK( primask );
 
-        /* store received byte (this also clears
-        the SPI2 RX buffer not empty flag) */
-        *read = ( uint8_t )( SPI2->DR );
+    if ( lines != 0U )
+    {
+        EXTI->SWIER = lines;
     }
 }
+
+/**
+ * @brief Tell whether an SPI bus is taken by the code that an interrupt preempted.
+ * 
+ * @param spi      SPI peripheral (SPI1 or SPI2)
+ * @return uint8_t 1 if a transaction is in progress, 0 if the bus is free
+ */
+uint8_t SPI_Bus_Busy( SPI_TypeDef *spi )
+{
+    return ( spi_bus_locks[ ( spi == SPI2 ) ? 1U : 0U ] != 0U ) ? 1U : 0U;
+}
+
+/**
+ * @brief Defer the service of EXTI lines until an SPI bus is released, to be called from their interrupt when
+ *        SPI_Bus_Busy() is 1. Their pending requests are raised again by software (EXTI_SWIER) once the outermost
+ *        lock is released, instead of right away, which would only preempt the bus owner over and over.
+ * 
+ * @param spi   SPI peripheral (SPI1 or SPI2)
+ * @param lines EXTI lines (EXTI_SWIER_SWIERx bits)
+ */
+void SPI_Bus_Defer( SPI_TypeDef *spi, uint32_t lines )
+{
+    spi_bus_deferred[ ( spi == SPI2 ) ? 1U : 0U ] |= lines;
+}
@@ -40,4 +40,18 @@
     void SPI1_Read( uint8_t *read, uint8_t size );
     void SPI2_Read( uint8_t *read, uint8_t size );
 
+    /* Shared SPI bus functions (any number of devices per bus, each one with its own chip-select pin) */
+    void SPI_Bus_Init( SPI_TypeDef *spi );
+    void SPI_CS_Init( GPIO_TypeDef *port, uint16_t pin );
+    void SPI_CS_Enable( GPIO_TypeDef *port, uint16_t pin );
+    void SPI_CS_Disable( GPIO_TypeDef *port, uint16_t pin );
+    void SPI_Write( SPI_TypeDef *spi, const uint8_t *data, uint8_t size );
+    void SPI_Read( SPI_TypeDef *spi, uint8_t *read, uint8_t size );
+
+    /* Shared SPI bus ownership between thread code and the interrupts that use the same bus */
+    void SPI_Bus_Lock( SPI_TypeDef *spi );
+    void SPI_Bus_Unlock( SPI_TypeDef *spi );
+    uint8_t SPI_Bus_Busy( SPI_TypeDef *spi );
+    void SPI_Bus_Defer( SPI_TypeDef *spi, uint32_t lines );
+
 #endif
@@ -0,0 +1,235 @@
+/**
+ * @file      test_can_id.c
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     Host-side checks of the CAN ID pack/unpack kernels in can.h (CAN_Control_ID_Pack_Raw(), CAN_Control_ID_Pack()
+ *            and CAN_Control_ID_Unpack()). Every one of the 2^29 extended IDs and 2^11 standard IDs is packed, compared
+ *            against a per-field reference implementation and unpacked back, then a microbenchmark compares the
+ *            kernels with the reference. Built and run on the host with 'make test'.
+ *            Host timings only show relative costs on the host CPU, the Cortex-M0 cycles of the driver paths that use the
+ *            kernels are measured on target with the profiling counters (refer to profile.h).
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+#include "can.h"
+
+/* Number of IDs packed and unpacked by each microbenchmark run, cycling over a set of BENCH_SET IDs */
+#define BENCH_IDS           (1UL << 24)
+#define BENCH_SET           (4096UL)
+
+/* Accumulator that keeps the compiler from removing the benchmarked loops */
+static volatile uint32_t bench_sink = 0U;
+
+/* Benchmark IDs, their frame types and their packed registers */
+static uint32_t bench_id[ BENCH_SET ];
+static uint8_t  bench_extended[ BENCH_SET ];
+static uint8_t  bench_reg[ BENCH_SET ][ 4 ];
+
+/**
+ * @brief Reference ID packing, one register field at a time, with a branch on the frame type
+ * 
+ * @param id       standard or extended CAN ID
+ * @param extended 1 if the ID is extended, 0 if it is standard
+ * @param reg      array of 4 bytes: SIDH, SIDL, EID8 and EID0
+ */
+static void Ref_ID_Pack( uint32_t id, uint8_t extended, uint8_t *reg )
+{
+    if ( extended == 1U )
+    {
+        reg[ 0 ] = ( uint8_t )( id >> 21 );                                                  /* SIDH.SID[10:3]  */
+        reg[ 1 ] = ( uint8_t )( ( ( id >> 13 ) & 0xE0U ) | IDE_RECEIVED_EXTENDED_FRAME |     /* SIDL.SID[2:0], EXIDE */
+                                ( ( id >> 16 ) & 0x03U ) );                                  /* SIDL.EID[17:16] */
+        reg[ 2 ] = ( uint8_t )( id >> 8 );                                                   /* EID8.EID[15:8]  */
+        reg[ 3 ] = ( uint8_t )id;                                                            /* EID0.EID[7:0]   */
+    }
+    else
+    {
+        reg[ 0 ] = ( uint8_t )( id >> 3 );                                                   /* SIDH.SID[10:3]  */
+        reg[ 1 ] = ( uint8_t )( ( id & 0x07U ) << 5 );                                       /* SIDL.SID[2:0]   */
+        reg[ 2 ] = 0U;                                                                       /* EID8            */
+        reg[ 3 ] = 0U;                                                                       /* EID0            */
+    }
+}
+
+/**
+ * @brief Reference ID unpacking, one register field at a time, with a branch on the IDE bit
+ * 
+ * @param reg       array of 4 bytes: SIDH, SIDL, EID8 and EID0
+ * @return uint32_t standard or extended CAN ID
+ */
+static uint32_t Ref_ID_Unpack( const uint8_t *reg )
+{
+    uint32_t id;
+
+    if ( ( reg[ 1 ] & IDE_RECEIVED_EXTENDED_FRAME ) == IDE_RECEIVED_EXTENDED_FRAME )
+    {
+        id  = ( uint32_t )reg[ 0 ] << 21;
+        id |= ( uint32_t )( reg[ 1 ] >> 5 ) << 18;
+        id |= ( uint32_t )( reg[ 1 ] & 0x03U ) << 16;
+        id |= ( uint32_t )reg[ 2 ] << 8;
+        id |= ( uint32_t )reg[ 3 ];
+    }
+    else
+    {
+        id = ( ( uint32_t )reg[ 0 ] << 3 ) | ( uint32_t )( reg[ 1 ] >> 5 );
+    }
+
+    return id;
+}
+
+/**
+ * @brief Check every extended and standard ID: packed registers must match the reference and unpack to the same ID.
+ *        Standard IDs are unpacked with garbage in EID8, EID0 and SIDL.EID[17:16], which must be ignored.
+ * 
+ * @return uint32_t number of IDs that failed
+ */
+static uint32_t Test_Round_Trip( void )
+{
+    uint8_t  reg[ 4 ];
+    uint8_t  ref[ 4 ];
+    uint32_t failures = 0U;
+    uint32_t id;
+
+    for ( id = 0U; id < ( 1UL << 29 ); id++ )
+    {
+        CAN_Control_ID_Pack( id, 1U, reg );
+        Ref_ID_Pack( id, 1U, ref );
+
+        if ( ( reg[ 0 ] != ref[ 0 ] ) || ( reg[ 1 ] != ref[ 1 ] ) || ( reg[ 2 ] != ref[ 2 ] ) || ( reg[ 3 ] != ref[ 3 ] ) ||
+             ( CAN_Control_ID_Unpack( reg ) != id ) )
+        {
+            if ( failures++ < 8U )
+            {
+                printf( "extended ID 0x%08lX failed\n", ( unsigned long )id );
+            }
+        }
+    }
+
+    for ( id = 0U; id < ( 1UL << 11 ); id++ )
+    {
+        CAN_Control_ID_Pack( id, 0U, reg );
+        Ref_ID_Pack( id, 0U, ref );
+
+        if ( ( reg[ 0 ] != ref[ 0 ] ) || ( ( reg[ 1 ] & 0xE8U ) != ref[ 1 ] ) )
+        {
+            failures++;
+            printf( "standard ID 0x%03lX packed wrong\n", ( unsigned long )id );
+        }
+
+        reg[ 1 ] = ( uint8_t )( ( reg[ 1 ] & 0xE0U ) | 0x03U ); /* EID[17:16] set, EXIDE clear */
+        reg[ 2 ] = 0x5AU;
+        reg[ 3 ] = 0xA5U;
+
+        if ( CAN_Control_ID_Unpack( reg ) != id )
+        {
+            failures++;
+            printf( "standard ID 0x%03lX unpacked wrong\n", ( unsigned long )id );
+        }
+    }
+
+    return failures;
+}
+
+/**
+ * @brief Elapsed time between two timestamps, in nanoseconds
+ */
+static double Elapsed_ns( const struct timespec *start, const struct timespec *stop )
+{
+    return ( ( double )( stop->tv_sec - start->tv_sec ) * 1e9 ) + ( double )( stop->tv_nsec - start->tv_nsec );
+}
+
+/**
+ * @brief Fill the benchmark arrays with BENCH_SET pseudo-random IDs, mixed standard and extended
+ */
+static void Bench_Fill( void )
+{
+    uint32_t seed = 0x12345678UL;
+    uint32_t i;
+
+    for ( i = 0U; i < BENCH_SET; i++ )
+    {
+        seed                = ( seed * 1664525UL ) + 1013904223UL;
+        bench_extended[ i ] = ( uint8_t )( seed & 1U );
+        bench_id[ i ]       = ( seed >> 3 ) & ( ( bench_extended[ i ] == 1U ) ? 0x1FFFFFFFUL : 0x7FFUL );
+    }
+}
+
+/**
+ * @brief Pack, then unpack, BENCH_IDS IDs with the kernels and with the reference, and print the time per ID of each
+ *        step. Packed registers go through an array, as in the driver where they go to and come from the MCP2515:
+ *        unpacking right after packing would let the compiler fold the round trip of the reference into the ID itself
+ */
+static void Bench_Pack_Unpack( void )
+{
+    struct timespec start, stop;
+    uint32_t        sum, i, j;
+    double          pack[ 2 ], unpack[ 2 ];
+    uint8_t         kernel;
+
+    for ( kernel = 0U; kernel < 2U; kernel++ )
+    {
+        clock_gettime( CLOCK_MONOTONIC, &start );
+
+        for ( j = 0U; j < ( BENCH_IDS / BENCH_SET ); j++ )
+        {
+            for ( i = 0U; i < BENCH_SET; i++ )
+            {
+                if ( kernel == 1U )
+                {
+                    CAN_Control_ID_Pack( bench_id[ i ], bench_extended[ i ], bench_reg[ i ] );
+                }
+                else
+                {
+                    Ref_ID_Pack( bench_id[ i ], bench_extended[ i ], bench_reg[ i ] );
+                }
+            }
+
+            /* Registers are stored for real on every pass */
+            __asm__ volatile( "" : : "r"( bench_reg ) : "memory" );
+        }
+
+        clock_gettime( CLOCK_MONOTONIC, &stop );
+        pack[ kernel ] = Elapsed_ns( &start, &stop ) / ( double )BENCH_IDS;
+
+        sum = 0U;
+        clock_gettime( CLOCK_MONOTONIC, &start );
+
+        for ( j = 0U; j < ( BENCH_IDS / BENCH_SET ); j++ )
+        {
+            for ( i = 0U; i < BENCH_SET; i++ )
+            {
+                sum += ( kernel == 1U ) ? CAN_Control_ID_Unpack( bench_reg[ i ] ) : Ref_ID_Unpack( bench_reg[ i ] );
+            }
+
+            /* Registers are loaded again on every pass */
+            __asm__ volatile( "" : : "r"( bench_reg ) : "memory" );
+        }
+
+        clock_gettime( CLOCK_MONOTONIC, &stop );
+        unpack[ kernel ] = Elapsed_ns( &start, &stop ) / ( double )BENCH_IDS;
+        bench_sink      += sum;
+    }
+
+    printf( "pack:   kernels %.2f ns/ID, reference %.2f ns/ID\n", pack[ 1 ], pack[ 0 ] );
+    printf( "unpack: kernels %.2f ns/ID, reference %.2f ns/ID\n", unpack[ 1 ], unpack[ 0 ] );
+}
+
+int main( void )
+{
+    uint32_t failures = Test_Round_Trip();
+
+    printf( "ID round trip: %lu failures over 2^29 extended and 2^11 standard IDs\n", ( unsigned long )failures );
+
+    Bench_Fill();
+    Bench_Pack_Unpack();
+
+    return ( failures == 0U ) ? 0 : 1;
+}
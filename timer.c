@@ -2,7 +2,12 @@
  * @file      timer.c
  * @author    Julio Cesar Bernal Mendez
  * 
- * @brief     This file contains the High-Level implementations for the 16-bit general purpose timer 3 of the Nucleo Board.
+ * @brief     This file contains the High-Level implementations for the 16-bit general purpose timer 3 and the
+ *            16-bit advanced-control timer 1 of the Nucleo Board.
+ * 
+ *            STM32F070RB TIM1 external clock pinout:
+ *            ---------------------------------------
+ *            - PA12 (TIM1_ETR)
  *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
  * 
  * @version   1.0
@@ -13,8 +18,12 @@
 
 #include <stdint.h>
 #include "stm32f0xx.h"
+#include "gpio.h"
 #include "timer.h"
 
+/* TIM1 overflow counter, it extends the 16-bit TIM1 counter to 32 bits (updated by the TIM1 update interrupt) */
+static volatile uint16_t tim1_overflows = 0U;
+
 /**
  * @brief Initialize the Nucleo Board's 16-bit General Purpose Timer 3 peripheral to the following parameters:
  *        - 0.5 microseconds timebase
@@ -77,3 +86,112 @@ void TIM3_Delay_us( uint32_t us )
     /* disable TIM3 peripheral */
     TIM3->CR1 &= ~TIM_CR1_CEN;
 }
+
+/**
+ * @brief Initialize the Nucleo Board's 16-bit Advanced-Control Timer 1 peripheral as a free-running timebase
+ *        clocked from an external source on its ETR pin (see pinout at the top of this file):
+ *        - External clock mode 2 (TIM1 counts every rising edge on PA12, no ETR prescaler nor filter)
+ *        - Up-counter from 0 to 0xFFFF
+ *        - Update interrupt enabled to extend the counter to 32 bits (see TIM1_Get_Ticks())
+ * 
+ *        The intended source is the MCP2515 CLKOUT pin, so that timestamps are counted in the CAN controller's
+ *        own oscillator domain instead of the HSI-based 48MHz PLL set up in SystemInit().
+ * 
+ *        Note: without the ETR prescaler, the external clock frequency must be lower than PCLK / 4 (= 12MHz),
+ *              which holds for the MCP2515 8MHz crystal at any CLKOUT prescaler.
+ */
+void TIM1_ETR_Init( void )
+{
+    /* enable GPIOA clock access */
+    GPIOA_CLK_ENBL();
+
+    /* PA12 (TIM1_ETR) in alternate function mode */
+    GPIOA->MODER |=  GPIO_MODER_MODER12_1;
+    GPIOA->MODER &= ~GPIO_MODER_MODER12_0;
+
+    /* PA12 in AF2 (TIM1_ETR) */
+    GPIOA->AFR[ 1 ] &= ~GPIO_AFRH_AFSEL12_3;
+    GPIOA->AFR[ 1 ] &= ~GPIO_AFRH_AFSEL12_2;
+    GPIOA->AFR[ 1 ] |=  GPIO_AFRH_AFSEL12_1;
+    GPIOA->AFR[ 1 ] &= ~GPIO_AFRH_AFSEL12_0;
+
+    /* enable TIM1 clock */
+    TIM1_CLK_ENBL();
+
+    /* TIM1 counts up (counts from 0 up to the auto-reload value) */
+    TIM1->CR1 &= ~TIM_CR1_DIR;
+
+    /* TIM1 UEV (update event) generation enabled */
+    TIM1->CR1 &= ~TIM_CR1_UDIS;
+
+    /* TIM1 external clock mode 2 enabled, ETR non-inverted (rising edge),
+       ETR prescaler off and no ETR filter */
+    TIM1->SMCR &= ~( TIM_SMCR_ETP | TIM_SMCR_ETPS | TIM_SMCR_ETF );
+    TIM1->SMCR |=  TIM_SMCR_ECE;
+
+    /* TIM1 prescaler, every ETR edge is counted */
+    TIM1->PSC = 0x00U;
+
+    /* TIM1 reload value, full 16-bit range */
+    TIM1->ARR = 0xFFFFU;
+
+    /* clear TIM1 counter and overflow counter */
+    TIM1->CNT = 0x00U;
+    tim1_overflows = 0U;
+
+    /* clear TIM1 update interrupt flag and enable TIM1 update interrupt */
+    TIM1->SR   &= ~TIM_SR_UIF;
+    TIM1->DIER |=  TIM_DIER_UIE;
+    NVIC_EnableIRQ( TIM1_BRK_UP_TRG_COM_IRQn );
+
+    /* enable TIM1 peripheral */
+    TIM1->CR1 |= TIM_CR1_CEN;
+}
+
+/**
+ * @brief Return the number of ticks counted by TIM1 since TIM1_ETR_Init() was called, as a 32-bit value.
+ *        A tick lasts one period of the clock applied to PA12 (TIM1_ETR).
+ * 
+ *        Note: this function can be called from interrupt context, an update event not yet serviced
+ *              by the TIM1 interrupt is accounted for.
+ * 
+ * @return uint32_t TIM1 ticks
+ */
+uint32_t TIM1_Get_Ticks( void )
+{
+    uint32_t primask;
+    uint32_t high;
+    uint32_t low;
+
+    /* prevent the TIM1 interrupt from updating the overflow counter while reading */
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    high = tim1_overflows;
+    low  = TIM1->CNT;
+
+    /* if TIM1 overflowed but its interrupt has not been serviced yet, and the counter value read belongs to the new period */
+    if ( ( ( TIM1->SR & TIM_SR_UIF ) == TIM_SR_UIF ) && ( low < 0x8000U ) )
+    {
+        high++;
+    }
+
+    __set_PRIMASK( primask );
+
+    return ( high << 16 ) | low;
+}
+
+/**
+ * @brief TIM1 update interrupt handler, count the TIM1 overflows (upper 16 bits of the TIM1 timebase)
+ */
+void TIM1_BRK_UP_TRG_COM_IRQHandler( void )
+{
+    /* if TIM1 update interrupt flag is set */
+    if ( ( TIM1->SR & TIM_SR_UIF ) == TIM_SR_UIF )
+    {
+        /* clear TIM1 update interrupt flag */
+        TIM1->SR &= ~TIM_SR_UIF;
+
+        tim1_overflows++;
+    }
+}
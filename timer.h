@@ -2,7 +2,8 @@
  * @file      timer.h
  * @author    Julio Cesar Bernal Mendez
  * 
- * @brief     This file contains the function prototypes for the 16-bit general purpose timer 3 of the Nucleo Board.
+ * @brief     This file contains the function prototypes for the 16-bit general purpose timer 3 and the
+ *            16-bit advanced-control timer 1 of the Nucleo Board.
  *            Everything was designed for the STM32F070RBT6 Nucleo Board from ST Microelectronics.
  * 
  * @version   1.0
@@ -14,8 +15,9 @@
 #ifndef TIMER_H
 #define TIMER_H
 
-    /* Macro to enable TIM3 clock in the RCC */
+    /* Macros to enable TIM3 and TIM1 clocks in the RCC */
     #define TIM3_CLK_ENBL()    (RCC->APB1ENR |= RCC_APB1ENR_TIM3EN)
+    #define TIM1_CLK_ENBL()    (RCC->APB2ENR |= RCC_APB2ENR_TIM1EN)
 
     /* TIM3 initialization function */
     void TIM3_Init( void );
@@ -23,4 +25,8 @@
     /* TIM3 microseconds delay function */
     void TIM3_Delay_us( uint32_t us );
 
+    /* TIM1 external clock (ETR) timebase initialization and tick read functions */
+    void TIM1_ETR_Init( void );
+    uint32_t TIM1_Get_Ticks( void );
+
 #endif
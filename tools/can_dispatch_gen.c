@@ -0,0 +1,312 @@
+/**
+ * @file      can_dispatch_gen.c
+ * @author    Julio Cesar Bernal Mendez
+ * 
+ * @brief     Host-side generator of the two-level perfect hash ID dispatch tables (refer to can_dispatch.h). It is built
+ *            with the application message list, searches the bucket and slot hash seeds and the bucket displacements
+ *            (hash and displace: the largest buckets are placed first, each one with the first displacement that moves
+ *            all of its keys onto free slots), checks every key against CAN_DISPATCH_PERFECT_SLOT() and writes the
+ *            table source. Built and run on the host by 'make', usage: can_dispatch_gen <output file>.
+ *            The list is selected at build time with CAN_DISPATCH_GEN_HEADER, CAN_DISPATCH_GEN_LIST and
+ *            CAN_DISPATCH_GEN_TABLE (defaults to the example list in can_messages.h).
+ * 
+ * @version   1.0
+ * @date      2024-01-26
+ * 
+ * @copyright This project was created for learning purposes only.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef CAN_DISPATCH_GEN_HEADER
+    #define CAN_DISPATCH_GEN_HEADER     "can_messages.h"
+#endif
+#ifndef CAN_DISPATCH_GEN_LIST
+    #define CAN_DISPATCH_GEN_LIST       BOARD_CAN_MESSAGES
+#endif
+#ifndef CAN_DISPATCH_GEN_TABLE
+    #define CAN_DISPATCH_GEN_TABLE      board_can_ids
+#endif
+
+#include CAN_DISPATCH_GEN_HEADER
+
+#define GEN_STRING( x )                 #x
+#define GEN_XSTRING( x )                GEN_STRING( x )
+
+/* Largest table (slots) and number of seed pairs tried per table size before doubling it */
+#define GEN_MAX_SLOT_BITS               (15U)
+#define GEN_ATTEMPTS                    (10000U)
+
+/* Message list entry as seen by the generator: key plus the source text of every field */
+typedef struct
+{
+    uint32_t    key;
+    const char *id;
+    const char *extended;
+    const char *handler;
+    const char *context;
+} Gen_Message;
+
+#define GEN_MESSAGE( id, extended, handler, context ) \
+    { CAN_DISPATCH_KEY( id, extended ), #id, #extended, #handler, #context },
+
+static const Gen_Message gen_messages[] =
+{
+    CAN_DISPATCH_GEN_LIST( GEN_MESSAGE )
+};
+
+#define GEN_MESSAGES                    ( sizeof( gen_messages ) / sizeof( gen_messages[ 0 ] ) )
+
+/* Search state: bucket of each key, keys of each bucket (ordered by bucket), slot of each key */
+static uint32_t gen_bucket[ GEN_MESSAGES ];
+static uint32_t gen_order[ GEN_MESSAGES ];
+static uint32_t gen_slot[ GEN_MESSAGES ];
+static uint32_t gen_count[ 1UL << GEN_MAX_SLOT_BITS ];
+static uint32_t gen_first[ 1UL << GEN_MAX_SLOT_BITS ];
+static uint32_t gen_buckets_by_size[ 1UL << GEN_MAX_SLOT_BITS ];
+static uint16_t gen_displace[ 1UL << GEN_MAX_SLOT_BITS ];
+static int32_t  gen_owner[ 1UL << GEN_MAX_SLOT_BITS ];
+
+/**
+ * @brief Pseudo-random seeds (xorshift32 with a fixed start, so the generated table is the same on every build)
+ */
+static uint32_t Gen_Random( void )
+{
+    static uint32_t state = 0x9E3779B9UL;
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    return state;
+}
+
+/**
+ * @brief Bucket order for qsort(): largest buckets first
+ */
+static int Gen_Compare_Buckets( const void *a, const void *b )
+{
+    uint32_t sizea = gen_count[ *( const uint32_t * )a ];
+    uint32_t sizeb = gen_count[ *( const uint32_t * )b ];
+
+    return ( sizea < sizeb ) ? 1 : ( ( sizea > sizeb ) ? -1 : 0 );
+}
+
+/**
+ * @brief Try to place every key with the given table size and seeds.
+ * 
+ * @param ids  table parameters (size, seeds and shifts set, displace pointing to gen_displace)
+ * @return int 1 if every key got a slot of its own, 0 otherwise
+ */
+static int Gen_Place( const CAN_Dispatch_IDs *ids )
+{
+    uint32_t buckets = 1UL << ( 32U - ids->bucketshift );
+    uint32_t b, i, k, d, slot, next, placed;
+    int      fits;
+
+    memset( gen_count, 0, sizeof( gen_count ) );
+    memset( gen_displace, 0, sizeof( gen_displace ) );
+
+    for ( i = 0U; i < ( uint32_t )ids->size; i++ )
+    {
+        gen_owner[ i ] = -1;
+    }
+
+    /* Counting sort of the keys by bucket */
+    for ( k = 0U; k < GEN_MESSAGES; k++ )
+    {
+        gen_bucket[ k ] = CAN_DISPATCH_HASH( gen_messages[ k ].key, ids->bucketseed, ids->bucketshift );
+        gen_count[ gen_bucket[ k ] ]++;
+    }
+
+    for ( b = 0U, next = 0U; b < buckets; b++ )
+    {
+        gen_first[ b ]           = next;
+        gen_buckets_by_size[ b ] = b;
+        next                    += gen_count[ b ];
+    }
+
+    for ( k = 0U; k < GEN_MESSAGES; k++ )
+    {
+        gen_order[ gen_first[ gen_bucket[ k ] ]++ ] = k;
+    }
+
+    for ( b = 0U; b < buckets; b++ )
+    {
+        gen_first[ b ] -= gen_count[ b ];
+    }
+
+    qsort( gen_buckets_by_size, buckets, sizeof( uint32_t ), Gen_Compare_Buckets );
+
+    /* Largest buckets first, each one with the first displacement that fits all of its keys */
+    for ( i = 0U; ( i < buckets ) && ( gen_count[ gen_buckets_by_size[ i ] ] > 0U ); i++ )
+    {
+        b    = gen_buckets_by_size[ i ];
+        fits = 0;
+
+        for ( d = 0U; ( d < ( uint32_t )ids->size ) && ( fits == 0 ); d++ )
+        {
+            fits   = 1;
+            placed = 0U;
+
+            for ( next = 0U; ( next < gen_count[ b ] ) && ( fits == 1 ); next++ )
+            {
+                k    = gen_order[ gen_first[ b ] + next ];
+                slot = CAN_DISPATCH_HASH( gen_messages[ k ].key, ids->slotseed, ids->slotshift ) ^ d;
+
+                if ( gen_owner[ slot ] >= 0 )
+                {
+                    fits = 0;
+                }
+                else
+                {
+                    gen_owner[ slot ] = ( int32_t )k;
+                    gen_slot[ k ]     = slot;
+                    placed++;
+                }
+            }
+
+            /* Undo the keys of the bucket placed before the conflict */
+            if ( fits == 0 )
+            {
+                while ( placed > 0U )
+                {
+                    placed--;
+                    gen_owner[ gen_slot[ gen_order[ gen_first[ b ] + placed ] ] ] = -1;
+                }
+            }
+            else
+            {
+                gen_displace[ b ] = ( uint16_t )d;
+            }
+        }
+
+        if ( fits == 0 )
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Check every key against the lookup of can_dispatch.c and write the table source.
+ * 
+ * @param ids  table parameters of the placed keys
+ * @param path output file
+ * @return int 0 if the file was written, 1 otherwise
+ */
+static int Gen_Write( const CAN_Dispatch_IDs *ids, const char *path )
+{
+    uint32_t buckets = 1UL << ( 32U - ids->bucketshift );
+    uint32_t k, b, slot;
+    FILE    *out;
+
+    for ( k = 0U; k < GEN_MESSAGES; k++ )
+    {
+        if ( CAN_DISPATCH_PERFECT_SLOT( ids, gen_messages[ k ].key ) != gen_slot[ k ] )
+        {
+            fprintf( stderr, "can_dispatch_gen: %s does not hash to its slot\n", gen_messages[ k ].id );
+            return 1;
+        }
+    }
+
+    out = fopen( path, "w" );
+
+    if ( out == NULL )
+    {
+        perror( path );
+        return 1;
+    }
+
+    fprintf( out, "/* Generated by tools/can_dispatch_gen from %s (%s): %lu messages, %u slots, %lu buckets.\n"
+                  "   Do not edit, change the message list and run 'make' instead */\n\n",
+             CAN_DISPATCH_GEN_HEADER, GEN_XSTRING( CAN_DISPATCH_GEN_LIST ), ( unsigned long )GEN_MESSAGES,
+             ( unsigned )ids->size, ( unsigned long )buckets );
+    fprintf( out, "#include \"%s\"\n\n", CAN_DISPATCH_GEN_HEADER );
+
+    fprintf( out, "static const uint16_t %s_displace[ %luU ] =\n{", GEN_XSTRING( CAN_DISPATCH_GEN_TABLE ), ( unsigned long )buckets );
+
+    for ( b = 0U; b < buckets; b++ )
+    {
+        fprintf( out, "%s0x%04XU%s", ( ( b % 8U ) == 0U ) ? "\n    " : " ", ( unsigned )gen_displace[ b ],
+                 ( b < ( buckets - 1U ) ) ? "," : "\n" );
+    }
+
+    fprintf( out, "};\n\nstatic const CAN_Dispatch_ID_Entry %s_entries[ %uU ] =\n{\n",
+             GEN_XSTRING( CAN_DISPATCH_GEN_TABLE ), ( unsigned )ids->size );
+
+    for ( slot = 0U; slot < ( uint32_t )ids->size; slot++ )
+    {
+        if ( gen_owner[ slot ] >= 0 )
+        {
+            k = ( uint32_t )gen_owner[ slot ];
+            fprintf( out, "    [ %lu ] = { CAN_DISPATCH_KEY( %s, %s ), %s, %s },\n", ( unsigned long )slot,
+                     gen_messages[ k ].id, gen_messages[ k ].extended, gen_messages[ k ].handler, gen_messages[ k ].context );
+        }
+    }
+
+    fprintf( out, "};\n\nconst CAN_Dispatch_IDs %s = { %s_entries, %s_displace, %uU, 0x%08lXUL, 0x%08lXUL, %uU, %uU };\n",
+             GEN_XSTRING( CAN_DISPATCH_GEN_TABLE ), GEN_XSTRING( CAN_DISPATCH_GEN_TABLE ), GEN_XSTRING( CAN_DISPATCH_GEN_TABLE ),
+             ( unsigned )ids->size, ( unsigned long )ids->bucketseed, ( unsigned long )ids->slotseed,
+             ( unsigned )ids->bucketshift, ( unsigned )ids->slotshift );
+
+    return ( fclose( out ) == 0 ) ? 0 : 1;
+}
+
+int main( int argc, char **argv )
+{
+    CAN_Dispatch_IDs ids = { NULL, gen_displace, 0U, 0U, 0U, 0U, 0U };
+    uint32_t         slotbits, bucketbits, attempt, i, k;
+
+    if ( argc != 2 )
+    {
+        fprintf( stderr, "usage: can_dispatch_gen <output file>\n" );
+        return 1;
+    }
+
+    /* Duplicated messages can not be told apart by any hash */
+    for ( k = 0U; k < GEN_MESSAGES; k++ )
+    {
+        for ( i = k + 1U; i < GEN_MESSAGES; i++ )
+        {
+            if ( gen_messages[ k ].key == gen_messages[ i ].key )
+            {
+                fprintf( stderr, "can_dispatch_gen: %s is listed twice\n", gen_messages[ k ].id );
+                return 1;
+            }
+        }
+    }
+
+    /* Smallest power of two that holds every key (at least 2 slots), doubled when no seeds fit */
+    for ( slotbits = 1U; ( 1UL << slotbits ) < GEN_MESSAGES; slotbits++ )
+    {
+    }
+
+    for ( ; slotbits <= GEN_MAX_SLOT_BITS; slotbits++ )
+    {
+        /* About 4 keys per bucket */
+        bucketbits = ( slotbits > 3U ) ? ( slotbits - 2U ) : 1U;
+
+        for ( attempt = 0U; attempt < GEN_ATTEMPTS; attempt++ )
+        {
+            ids.size        = ( uint16_t )( 1UL << slotbits );
+            ids.bucketseed  = Gen_Random() | 1U;
+            ids.slotseed    = Gen_Random() | 1U;
+            ids.bucketshift = ( uint8_t )( 32U - bucketbits );
+            ids.slotshift   = ( uint8_t )( 32U - slotbits );
+
+            if ( Gen_Place( &ids ) == 1 )
+            {
+                return Gen_Write( &ids, argv[ 1 ] );
+            }
+        }
+    }
+
+    fprintf( stderr, "can_dispatch_gen: no perfect hash found for %lu messages\n", ( unsigned long )GEN_MESSAGES );
+
+    return 1;
+}